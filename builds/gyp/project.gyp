@@ -242,8 +242,6 @@
         '../../src/tipc_connecter.hpp',
         '../../src/tipc_listener.cpp',
         '../../src/tipc_listener.hpp',
-        '../../src/trie.cpp',
-        '../../src/trie.hpp',
         '../../src/tweetnacl.c',
         '../../src/tweetnacl.h',
         '../../src/udp_address.cpp',
@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atomic_counter.hpp"
+#include "config.hpp"
+#include "thread.hpp"
+#include "ypipe.hpp"
+
+//  Measures the raw throughput of the lock-free pipe that carries messages
+//  between sockets, without the sockets around it. Items have the size of
+//  msg_t.
+
+struct item_t
+{
+    uint64_t seq;
+    unsigned char payload[56];
+};
+
+typedef zmq::ypipe_t<item_t, zmq::message_pipe_granularity> item_pipe_t;
+
+struct transfer_t
+{
+    item_pipe_t pipe;
+
+    //  Number of times the writer woke the reader up, standing in for the
+    //  activate_read commands sent between pipes.
+    zmq::atomic_counter_t wakeups;
+};
+
+static uint64_t item_count;
+
+static void writer (void *arg_)
+{
+    transfer_t *transfer = (transfer_t *) arg_;
+    item_t item;
+    memset (&item, 0, sizeof item);
+    for (uint64_t i = 0; i != item_count; i++) {
+        item.seq = i;
+        transfer->pipe.write (item, false);
+        if (!transfer->pipe.flush ())
+            transfer->wakeups.add (1);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 2) {
+        printf ("usage: ypipe_thr <item-count>\n");
+        return 1;
+    }
+
+    item_count = strtoull (argv[1], NULL, 10);
+
+    transfer_t *transfer = new transfer_t;
+    zmq::thread_t writer_thread;
+
+    printf ("item size: %d [B]\n", (int) sizeof (item_t));
+    printf ("item count: %lu\n", (unsigned long) item_count);
+
+    void *watch = zmq_stopwatch_start ();
+    writer_thread.start (writer, transfer);
+
+    uint32_t wakeups_seen = 0;
+    item_t item;
+    for (uint64_t i = 0; i != item_count; i++) {
+        //  Having found the pipe empty, the reader is asleep until the
+        //  writer wakes it up.
+        if (!transfer->pipe.read (&item)) {
+            while (transfer->wakeups.add (0) == wakeups_seen)
+                ;
+            wakeups_seen++;
+            if (!transfer->pipe.read (&item)) {
+                printf ("woken up to an empty pipe\n");
+                return -1;
+            }
+        }
+        if (item.seq != i) {
+            printf ("item out of order received\n");
+            return -1;
+        }
+    }
+
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    writer_thread.stop ();
+    delete transfer;
+
+    const unsigned long throughput =
+      (unsigned long) ((double) item_count / (double) elapsed * 1000000);
+
+    printf ("mean throughput: %lu [items/s]\n", throughput);
+    printf ("mean latency: %.1f [ns/item]\n",
+            (double) elapsed * 1000 / (double) item_count);
+    printf ("wakeups: %u\n", wakeups_seen);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_BATCH_LIMIT_HPP_INCLUDED__
+#define __ZMQ_BATCH_LIMIT_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <algorithm>
+
+#include "config.hpp"
+
+namespace zmq
+{
+//  Maximal number of bytes an engine reads or batches for writing at
+//  once. Unless it adapts to the traffic, the limit is the configured
+//  batch size. Otherwise it starts at the default batch size, doubles
+//  when an I/O operation used all of it and halves when an operation
+//  used less than a quarter of it, staying between
+//  min_adaptive_batch_size and the configured batch size.
+class batch_limit_t
+{
+  public:
+    batch_limit_t (size_t max_, bool adaptive_, size_t initial_) :
+        max (max_),
+        adaptive (adaptive_),
+        limit (adaptive_ ? std::min (initial_, max_) : max_)
+    {
+    }
+
+    size_t get () const { return limit; }
+
+    //  Accounts for an I/O operation that used used_ bytes.
+    void update (size_t used_)
+    {
+        if (!adaptive)
+            return;
+        if (used_ >= limit)
+            limit = std::min (limit * 2, max);
+        else if (used_ < limit / 4)
+            limit = std::max (
+              limit / 2, std::min ((size_t) min_adaptive_batch_size, max));
+    }
+
+  private:
+    const size_t max;
+    const bool adaptive;
+    size_t limit;
+};
+}
+
+#endif
@@ -0,0 +1,250 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_BLOB_MAP_HPP_INCLUDED__
+#define __ZMQ_BLOB_MAP_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+#include "blob.hpp"
+#include "err.hpp"
+#include "random.hpp"
+
+namespace zmq
+{
+//  Hash table keyed on blob_t, used to look up peers by routing id.
+//  It uses open addressing with linear probing over a single vector of
+//  slots, so a lookup usually touches one or two adjacent cache lines
+//  instead of walking the nodes of a balanced tree. Each slot keeps the
+//  hash of its key so that mismatches are rejected without comparing
+//  the keys. Erasure shifts the following entries back, so there are
+//  no tombstones. Inserting or erasing invalidates iterators. The hash
+//  is seeded per map, so that peers cannot choose routing ids that all
+//  end up in the same probe sequence.
+
+template <typename T> class blob_map_t
+{
+  public:
+    struct slot_t
+    {
+        slot_t () : used (false), hash (0) {}
+
+        bool used;
+        size_t hash;
+        blob_t first;
+        T second;
+    };
+
+    class iterator
+    {
+      public:
+        iterator (std::vector<slot_t> *slots_, size_t pos_) :
+            slots (slots_),
+            pos (pos_)
+        {
+            skip ();
+        }
+
+        slot_t &operator* () const { return (*slots)[pos]; }
+        slot_t *operator-> () const { return &(*slots)[pos]; }
+
+        iterator &operator++ ()
+        {
+            ++pos;
+            skip ();
+            return *this;
+        }
+
+        bool operator== (const iterator &other_) const
+        {
+            return pos == other_.pos;
+        }
+        bool operator!= (const iterator &other_) const
+        {
+            return pos != other_.pos;
+        }
+
+      private:
+        void skip ()
+        {
+            while (pos < slots->size () && !(*slots)[pos].used)
+                ++pos;
+        }
+
+        std::vector<slot_t> *slots;
+        size_t pos;
+
+        friend class blob_map_t;
+    };
+
+    blob_map_t () : slots (min_capacity), count (0)
+    {
+        //  Shifting twice is well defined for a 32-bit size_t as well.
+        seed = ((size_t) generate_random () << 16 << 16) | generate_random ();
+    }
+
+    bool empty () const { return count == 0; }
+    size_t size () const { return count; }
+
+    //  The number of slots, and the slot a key's probe sequence starts
+    //  at.
+    size_t bucket_count () const { return slots.size (); }
+    size_t bucket (const blob_t &key_) const
+    {
+        return hash (key_) & (slots.size () - 1);
+    }
+
+    iterator begin () { return iterator (&slots, 0); }
+    iterator end () { return iterator (&slots, slots.size ()); }
+
+    iterator find (const blob_t &key_)
+    {
+        return iterator (&slots, lookup (key_, hash (key_)));
+    }
+
+    //  Lookups in a const map. The iterator itself gives no constness
+    //  guarantee; callers must not modify the entries through it.
+    typedef iterator const_iterator;
+    const_iterator find (const blob_t &key_) const
+    {
+        return const_cast<blob_map_t *> (this)->find (key_);
+    }
+    const_iterator end () const
+    {
+        return const_cast<blob_map_t *> (this)->end ();
+    }
+
+    //  Inserts the value under key_, taking over the key's data. Returns
+    //  false, leaving key_ untouched, if the key is present already.
+    bool insert (blob_t &key_, const T &value_)
+    {
+        const size_t h = hash (key_);
+        if (lookup (key_, h) != slots.size ())
+            return false;
+
+        //  Keep the table at most half full to keep probe sequences short.
+        if ((count + 1) * 2 > slots.size ())
+            grow ();
+
+        slot_t &slot = slots[probe (h)];
+        slot.used = true;
+        slot.hash = h;
+        slot.first = ZMQ_MOVE (key_);
+        slot.second = value_;
+        ++count;
+        return true;
+    }
+
+    void erase (iterator it_)
+    {
+        zmq_assert (it_.pos < slots.size () && slots[it_.pos].used);
+        const size_t mask = slots.size () - 1;
+
+        //  Move back the following entries of the probe sequence whose
+        //  home slot does not lie between the hole and their position.
+        size_t hole = it_.pos;
+        for (size_t pos = (hole + 1) & mask; slots[pos].used;
+             pos = (pos + 1) & mask) {
+            const size_t home = slots[pos].hash & mask;
+            if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+                slots[hole] = ZMQ_MOVE (slots[pos]);
+                hole = pos;
+            }
+        }
+        slots[hole].used = false;
+        slots[hole].first.clear ();
+        --count;
+    }
+
+  private:
+    enum
+    {
+        min_capacity = 16
+    };
+
+    //  FNV-1a, starting from the seed rather than a fixed basis.
+    size_t hash (const blob_t &key_) const
+    {
+        size_t h = (size_t) 2166136261u ^ seed;
+        const unsigned char *data = key_.data ();
+        for (size_t i = 0; i != key_.size (); ++i) {
+            h ^= data[i];
+            h *= (size_t) 16777619u;
+        }
+        return h;
+    }
+
+    //  Returns the position of the key or slots.size () if it's absent.
+    size_t lookup (const blob_t &key_, size_t hash_) const
+    {
+        const size_t mask = slots.size () - 1;
+        for (size_t pos = hash_ & mask; slots[pos].used;
+             pos = (pos + 1) & mask) {
+            const slot_t &slot = slots[pos];
+            if (slot.hash == hash_ && slot.first.size () == key_.size ()
+                && (key_.size () == 0
+                    || memcmp (slot.first.data (), key_.data (), key_.size ())
+                         == 0))
+                return pos;
+        }
+        return slots.size ();
+    }
+
+    //  Returns the first free position in the probe sequence of hash_.
+    size_t probe (size_t hash_) const
+    {
+        const size_t mask = slots.size () - 1;
+        size_t pos = hash_ & mask;
+        while (slots[pos].used)
+            pos = (pos + 1) & mask;
+        return pos;
+    }
+
+    void grow ()
+    {
+        std::vector<slot_t> old (slots.size () * 2);
+        old.swap (slots);
+        for (size_t i = 0; i != old.size (); ++i)
+            if (old[i].used)
+                slots[probe (old[i].hash)] = ZMQ_MOVE (old[i]);
+    }
+
+    //  The number of slots is always a power of two.
+    std::vector<slot_t> slots;
+    size_t count;
+    size_t seed;
+
+    blob_map_t (const blob_map_t &);
+    const blob_map_t &operator= (const blob_map_t &);
+};
+}
+
+#endif
@@ -192,6 +192,42 @@ uint64_t zmq::clock_t::now_us ()
 #endif
 }
 
+uint64_t zmq::clock_t::now_ns ()
+{
+#if defined ZMQ_HAVE_WINDOWS
+
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency (&ticksPerSecond);
+    LARGE_INTEGER tick;
+    QueryPerformanceCounter (&tick);
+    double ticks_div = ticksPerSecond.QuadPart / 1000000000.0;
+    return (uint64_t) (tick.QuadPart / ticks_div);
+
+#elif defined HAVE_CLOCK_GETTIME && defined CLOCK_MONOTONIC
+
+    struct timespec tv;
+
+#if defined ZMQ_HAVE_OSX                                                       \
+  && __MAC_OS_X_VERSION_MIN_REQUIRED < 101200 // less than macOS 10.12
+    int rc = alt_clock_gettime (SYSTEM_CLOCK, &tv);
+#else
+    int rc = clock_gettime (CLOCK_MONOTONIC, &tv);
+#endif
+    if (rc != 0)
+        return now_us () * 1000;
+    return (tv.tv_sec * (uint64_t) 1000000000 + tv.tv_nsec);
+
+#elif defined HAVE_GETHRTIME
+
+    return gethrtime ();
+
+#else
+
+    return now_us () * 1000;
+
+#endif
+}
+
 uint64_t zmq::clock_t::now_ms ()
 {
     uint64_t tsc = rdtsc ();
@@ -60,6 +60,9 @@ class clock_t
     //  High precision timestamp.
     static uint64_t now_us ();
 
+    //  High precision timestamp in nanoseconds.
+    static uint64_t now_ns ();
+
     //  Low precision timestamp. In tight loops generating it can be
     //  10 to 100 times faster than the high precision timestamp.
     uint64_t now_ms ();
@@ -40,6 +40,7 @@ class own_t;
 struct i_engine;
 class pipe_t;
 class socket_base_t;
+class io_thread_t;
 
 //  This structure defines the commands that can be sent between threads.
 
@@ -73,6 +74,9 @@ __declspec(align (64))
         reap,
         reaped,
         inproc_connected,
+        migrate,
+        reroute,
+        adopt,
         done
     } type;
 
@@ -186,6 +190,29 @@ __declspec(align (64))
         {
         } reaped;
 
+        //  Sent by socket to the objects it owns, and passed on to their
+        //  sessions, to move the connections to one of the I/O threads
+        //  selected by the affinity bitmap.
+        struct
+        {
+            uint64_t affinity;
+        } migrate;
+
+        //  Sent by a migrating object to the I/O thread it belongs to, to
+        //  have the commands for the object forwarded to another I/O thread
+        //  from now on.
+        struct
+        {
+            zmq::object_t *object;
+            zmq::io_thread_t *io_thread;
+        } reroute;
+
+        //  Sent by the I/O thread an object belongs to, after rerouting the
+        //  commands for it, for the object to resume in its new I/O thread.
+        struct
+        {
+        } adopt;
+
         //  Sent by reaper thread to the term thread when all the sockets
         //  are successfully deallocated.
         struct
@@ -44,6 +44,16 @@ enum
     //  Commands in pipe per allocation event.
     command_pipe_granularity = 16,
 
+    //  Number of spare command nodes a thread-safe socket's mailbox keeps
+    //  for reuse, so that commands arriving as fast as they are read cause
+    //  no memory allocation.
+    mailbox_spare_nodes = 8,
+
+    //  Assumed size of a CPU cache line. Data used by the reading and
+    //  the writing end of a pipe is kept at least this far apart, so that
+    //  the two threads do not invalidate each other's caches.
+    cache_line_size = 64,
+
     //  Determines how often does socket poll for new commands when it
     //  still has unprocessed messages to handle. Thus, if it is set to 100,
     //  socket will process 100 inbound messages before doing the poll.
@@ -52,6 +62,12 @@ enum
     //  real-time behaviour (less latency peaks).
     inbound_poll_rate = 100,
 
+    //  Bounds of the interval above for sockets that adapt it to the
+    //  traffic (ZMQ_ADAPTIVE_POLL_RATE). The interval halves each time a
+    //  poll finds commands and grows by an eighth each time it does not.
+    min_inbound_poll_rate = 10,
+    max_inbound_poll_rate = 1000,
+
     //  Maximal batching size for engines with receiving functionality.
     //  So, if there are 10 messages that fit into the batch size, all of
     //  them may be read by a single 'recv' system call, thus avoiding
@@ -64,6 +80,64 @@ enum
     //  unnecessary network stack traversals.
     out_batch_size = 8192,
 
+    //  Message parts at least this large are not copied into the output
+    //  batch. Stream engines write them in place, together with the data
+    //  batched before them, using a single gather write.
+    out_gather_threshold = 4096,
+
+    //  Maximal number of datagrams UDP engines receive or send using
+    //  a single recvmmsg/sendmmsg system call, where available.
+    udp_batch_size = 16,
+
+    //  Smallest batch stream engines shrink their batches to when batch
+    //  sizes adapt to the traffic.
+    min_adaptive_batch_size = 1024,
+
+    //  Bounds of the batch sizes that may be set with ZMQ_IN_BATCH_SIZE
+    //  and ZMQ_OUT_BATCH_SIZE. Each connection allocates buffers of the
+    //  sizes set.
+    min_batch_size = 64,
+    max_batch_size = 1048576,
+
+    //  Maximal number of messages zmq_proxy forwards in one direction
+    //  per poll cycle, as long as the source has messages ready and the
+    //  destination can take them.
+    proxy_batch_size = 64,
+
+    //  Largest block, message header included, the message pool hands
+    //  out. Blocks come in power-of-two size classes starting at 64 bytes.
+    //  Larger messages are allocated with malloc.
+    msg_pool_max_size = 8192,
+
+    //  Maximal number of free blocks of each size class a thread keeps
+    //  for itself. Blocks freed beyond that go to a list shared by all
+    //  threads.
+    msg_pool_cache_size = 256,
+
+    //  Maximal number of bytes of free blocks of each size class kept on
+    //  the list shared by all threads. Blocks freed beyond that go back
+    //  to the system.
+    msg_pool_shared_max_size = 1024 * 1024,
+
+    //  Maximal number of bytes of receive buffers released by zero-copy
+    //  messages each decoder keeps for reuse. A decoder keeps at least one
+    //  buffer, even if it is larger.
+    decoder_pool_max_size = 256 * 1024,
+
+    //  Size of the shared memory ring carrying one direction of a shm://
+    //  connection. Must be a power of two.
+    shm_ring_size = 1024 * 1024,
+
+    //  Length of the windows over which I/O threads measure the time they
+    //  spend handling events, in milliseconds.
+    poller_busy_window = 100,
+
+    //  I/O threads busier than the least busy one by no more than this
+    //  share of their time, in parts per million, are considered equally
+    //  loaded when assigning new connections. Among those, the one with
+    //  the fewest file descriptors is chosen.
+    io_thread_busy_margin = 50000,
+
     //  Maximal delta between high and low watermark.
     max_wm_delta = 1024,
 
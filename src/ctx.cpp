@@ -46,6 +46,7 @@
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
+#include "msg_pool.hpp"
 #include "random.hpp"
 
 #ifdef ZMQ_HAVE_VMCI
@@ -245,6 +246,8 @@ int zmq::ctx_t::set (int option_, int optval_)
     } else if (option_ == ZMQ_MAX_MSGSZ && optval_ >= 0) {
         scoped_lock_t locker (opt_sync);
         max_msgsz = optval_ < INT_MAX ? optval_ : INT_MAX;
+    } else if (option_ == ZMQ_MSG_POOL && optval_ >= 0) {
+        rc = msg_pool_t::set_enabled (optval_ != 0);
     } else {
         rc = thread_ctx_t::set (option_, optval_);
     }
@@ -268,6 +271,8 @@ int zmq::ctx_t::get (int option_)
         rc = max_msgsz;
     else if (option_ == ZMQ_MSG_T_SIZE)
         rc = sizeof (zmq_msg_t);
+    else if (option_ == ZMQ_MSG_POOL)
+        rc = msg_pool_t::enabled ();
     else {
         errno = EINVAL;
         rc = -1;
@@ -321,7 +326,7 @@ bool zmq::ctx_t::start ()
         }
         io_threads.push_back (io_thread);
         slots[i] = io_thread->get_mailbox ();
-        io_thread->start ();
+        io_thread->start (io_thread_cpu (i - 2));
     }
 
     //  In the unused part of the slot array, create a list of empty slots.
@@ -416,12 +421,16 @@ zmq::thread_ctx_t::thread_ctx_t () :
 
 void zmq::thread_ctx_t::start_thread (thread_t &thread_,
                                       thread_fn *tfn_,
-                                      void *arg_) const
+                                      void *arg_,
+                                      int cpu_) const
 {
     static unsigned int nthreads_started = 0;
 
+    std::set<int> cpu;
+    if (cpu_ >= 0)
+        cpu.insert (cpu_);
     thread_.setSchedulingParameters (thread_priority, thread_sched_policy,
-                                     thread_affinity_cpus);
+                                     cpu_ >= 0 ? cpu : thread_affinity_cpus);
     thread_.start (tfn_, arg_);
 #ifndef ZMQ_HAVE_ANDROID
     std::ostringstream s;
@@ -451,7 +460,16 @@ int zmq::thread_ctx_t::set (int option_, int optval_)
             errno = EINVAL;
             rc = -1;
         }
-    } else if (option_ == ZMQ_THREAD_NAME_PREFIX && optval_ >= 0) {
+    }
+#ifdef ZMQ_HAVE_PTHREAD_SET_AFFINITY
+    //  Without the means to pin them, the I/O threads would silently run
+    //  anywhere.
+    else if (option_ == ZMQ_IO_THREAD_CPU_ADD && optval_ >= 0) {
+        scoped_lock_t locker (opt_sync);
+        io_thread_cpus.push_back (optval_);
+    }
+#endif
+    else if (option_ == ZMQ_THREAD_NAME_PREFIX && optval_ >= 0) {
         std::ostringstream s;
         s << optval_;
         scoped_lock_t locker (opt_sync);
@@ -466,6 +484,14 @@ int zmq::thread_ctx_t::set (int option_, int optval_)
     return rc;
 }
 
+int zmq::thread_ctx_t::io_thread_cpu (int index_)
+{
+    scoped_lock_t locker (opt_sync);
+    if (io_thread_cpus.empty ())
+        return -1;
+    return io_thread_cpus[index_ % io_thread_cpus.size ()];
+}
+
 void zmq::ctx_t::send_command (uint32_t tid_, const command_t &command_)
 {
     slots[tid_]->send (command_);
@@ -476,11 +502,27 @@ zmq::io_thread_t *zmq::ctx_t::choose_io_thread (uint64_t affinity_)
     if (io_threads.empty ())
         return NULL;
 
-    //  Find the I/O thread with minimum load.
+    //  Find the least busy I/O thread.
+    int min_busy = -1;
+    io_thread_t *least_busy_io_thread = NULL;
+    for (io_threads_t::size_type i = 0; i != io_threads.size (); i++) {
+        if (!affinity_ || (affinity_ & (uint64_t (1) << i))) {
+            int busy = io_threads[i]->get_busy ();
+            if (least_busy_io_thread == NULL || busy < min_busy) {
+                min_busy = busy;
+                least_busy_io_thread = io_threads[i];
+            }
+        }
+    }
+
+    //  Of the I/O threads about as busy as that, find the one with
+    //  minimum load.
     int min_load = -1;
     io_thread_t *selected_io_thread = NULL;
     for (io_threads_t::size_type i = 0; i != io_threads.size (); i++) {
         if (!affinity_ || (affinity_ & (uint64_t (1) << i))) {
+            if (io_threads[i]->get_busy () > min_busy + io_thread_busy_margin)
+                continue;
             int load = io_threads[i]->get_load ();
             if (selected_io_thread == NULL || load < min_load) {
                 min_load = load;
@@ -488,7 +530,9 @@ zmq::io_thread_t *zmq::ctx_t::choose_io_thread (uint64_t affinity_)
             }
         }
     }
-    return selected_io_thread;
+
+    //  Busy shares are measured concurrently and may have grown since.
+    return selected_io_thread ? selected_io_thread : least_busy_io_thread;
 }
 
 int zmq::ctx_t::register_endpoint (const char *addr_,
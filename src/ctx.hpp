@@ -66,12 +66,20 @@ class thread_ctx_t
   public:
     thread_ctx_t ();
 
-    //  Start a new thread with proper scheduling parameters.
-    void start_thread (thread_t &thread_, thread_fn *tfn_, void *arg_) const;
+    //  Start a new thread with proper scheduling parameters. If cpu_ is
+    //  not negative, the thread is pinned to that CPU alone.
+    void start_thread (thread_t &thread_,
+                       thread_fn *tfn_,
+                       void *arg_,
+                       int cpu_ = -1) const;
 
     int set (int option_, int optval_);
 
   protected:
+    //  Returns the CPU the I/O thread with the given index is to be pinned
+    //  to, or -1 if the I/O threads are not pinned individually.
+    int io_thread_cpu (int index_);
+
     //  Synchronisation of access to context options.
     mutex_t opt_sync;
 
@@ -80,6 +88,7 @@ class thread_ctx_t
     int thread_priority;
     int thread_sched_policy;
     std::set<int> thread_affinity_cpus;
+    std::vector<int> io_thread_cpus;
     std::string thread_name_prefix;
 };
 
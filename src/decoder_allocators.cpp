@@ -33,6 +33,84 @@
 #include <cmath>
 
 #include "msg.hpp"
+#include "atomic_ptr.hpp"
+#include "config.hpp"
+
+#include <new>
+
+//  Prefix of every buffer, followed by max_size bytes of message data and
+//  the content structures of the messages constructed on top of it.
+struct zmq::shared_message_memory_allocator::header_t
+{
+    atomic_counter_t refcnt;
+    pool_t *pool;
+
+    //  Links the buffer into the free lists of the pool.
+    header_t *next;
+};
+
+struct zmq::shared_message_memory_allocator::pool_t
+{
+    explicit pool_t (std::size_t capacity_) :
+        cached (NULL),
+        pooled (0),
+        refs (1),
+        capacity (static_cast<atomic_counter_t::integer_t> (capacity_))
+    {
+    }
+
+    //  Marks the list of returned buffers once the allocator is gone.
+    header_t *closed () { return reinterpret_cast<header_t *> (this); }
+
+    //  Takes a free buffer from the pool. Returns NULL if there is none.
+    //  Called from the allocator's thread only.
+    header_t *take ()
+    {
+        if (!cached)
+            cached = returned.xchg (NULL);
+        header_t *header = cached;
+        if (header) {
+            cached = header->next;
+            pooled.sub (1);
+        }
+        return header;
+    }
+
+    //  Returns a buffer no longer referenced by any message to the pool.
+    //  Returns false if the pool is full or closed; the caller has to free
+    //  the buffer in that case.
+    bool put (header_t *header_)
+    {
+        if (pooled.add (1) >= capacity) {
+            pooled.sub (1);
+            return false;
+        }
+        header_t *head = NULL;
+        while (true) {
+            header_->next = head;
+            header_t *old = returned.cas (head, header_);
+            if (old == head)
+                return true;
+            if (old == closed ())
+                return false;
+            head = old;
+        }
+    }
+
+    //  Buffers taken over from the returned list, owned by the allocator.
+    header_t *cached;
+
+    //  Buffers returned by the threads closing the messages.
+    atomic_ptr_t<header_t> returned;
+
+    //  Number of buffers in either list.
+    atomic_counter_t pooled;
+
+    //  One reference held by the allocator and one by each buffer.
+    atomic_counter_t refs;
+
+    const atomic_counter_t::integer_t capacity;
+};
 
 zmq::shared_message_memory_allocator::shared_message_memory_allocator (
   std::size_t bufsize_) :
@@ -42,8 +120,10 @@ zmq::shared_message_memory_allocator::shared_message_memory_allocator (
     msg_content (NULL),
     maxCounters (static_cast<size_t> (
       std::ceil (static_cast<double> (max_size)
-                 / static_cast<double> (msg_t::max_vsm_size))))
+                 / static_cast<double> (msg_t::max_vsm_size)))),
+    pool (NULL)
 {
+    init_pool ();
 }
 
 zmq::shared_message_memory_allocator::shared_message_memory_allocator (
@@ -52,26 +132,61 @@ zmq::shared_message_memory_allocator::shared_message_memory_allocator (
     bufsize (0),
     max_size (bufsize_),
     msg_content (NULL),
-    maxCounters (maxMessages)
+    maxCounters (maxMessages),
+    pool (NULL)
 {
+    init_pool ();
 }
 
 zmq::shared_message_memory_allocator::~shared_message_memory_allocator ()
 {
     deallocate ();
+
+    //  Free the pooled buffers. Buffers still in use are freed when their
+    //  last message is closed.
+    header_t *header = pool->returned.xchg (pool->closed ());
+    while (header) {
+        header_t *next = header->next;
+        destroy (header);
+        header = next;
+    }
+    header = pool->cached;
+    while (header) {
+        header_t *next = header->next;
+        destroy (header);
+        header = next;
+    }
+    if (!pool->refs.sub (1))
+        delete pool;
+}
+
+void zmq::shared_message_memory_allocator::init_pool ()
+{
+    //  Keep at least one buffer, so that a buffer still in use by the
+    //  application alternates with the one being filled.
+    std::size_t capacity = decoder_pool_max_size / allocation_size ();
+    if (capacity < 1)
+        capacity = 1;
+    pool = new (std::nothrow) pool_t (capacity);
+    alloc_assert (pool);
+}
+
+std::size_t zmq::shared_message_memory_allocator::allocation_size () const
+{
+    return sizeof (header_t) + max_size
+           + maxCounters * sizeof (zmq::msg_t::content_t);
 }
 
 unsigned char *zmq::shared_message_memory_allocator::allocate ()
 {
     if (buf) {
         // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (buf);
+        header_t *header = reinterpret_cast<header_t *> (buf);
 
         // if refcnt drops to 0, there are no message using the buffer
         // because either all messages have been closed or only vsm-messages
         // were created
-        if (c->sub (1)) {
+        if (header->refcnt.sub (1)) {
             // buffer is still in use as message data. "Release" it and create a new one
             // release pointer because we are going to create a new buffer
             release ();
@@ -80,34 +195,34 @@ unsigned char *zmq::shared_message_memory_allocator::allocate ()
 
     // if buf != NULL it is not used by any message so we can re-use it for the next run
     if (!buf) {
-        // allocate memory for reference counters together with reception buffer
-        std::size_t const allocationsize =
-          max_size + sizeof (zmq::atomic_counter_t)
-          + maxCounters * sizeof (zmq::msg_t::content_t);
-
-        buf = static_cast<unsigned char *> (std::malloc (allocationsize));
-        alloc_assert (buf);
+        // reuse a buffer returned to the pool if there is one
+        header_t *header = pool->take ();
+        if (!header) {
+            // allocate memory for reference counters together with reception buffer
+            header = static_cast<header_t *> (std::malloc (allocation_size ()));
+            alloc_assert (header);
 
-        new (buf) atomic_counter_t (1);
-    } else {
-        // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (buf);
-        c->set (1);
+            new (header) header_t;
+            header->pool = pool;
+            pool->refs.add (1);
+        }
+        buf = reinterpret_cast<unsigned char *> (header);
     }
 
+    // hold a reference while decoding into the buffer
+    reinterpret_cast<header_t *> (buf)->refcnt.set (1);
+
     bufsize = max_size;
     msg_content = reinterpret_cast<zmq::msg_t::content_t *> (
-      buf + sizeof (atomic_counter_t) + max_size);
-    return buf + sizeof (zmq::atomic_counter_t);
+      buf + sizeof (header_t) + max_size);
+    return buf + sizeof (header_t);
 }
 
 void zmq::shared_message_memory_allocator::deallocate ()
 {
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (buf);
-    if (buf && !c->sub (1)) {
-        std::free (buf);
-    }
+    header_t *header = reinterpret_cast<header_t *> (buf);
+    if (buf && !header->refcnt.sub (1))
+        destroy (header);
     release ();
 }
 
@@ -123,22 +238,26 @@ unsigned char *zmq::shared_message_memory_allocator::release ()
 
 void zmq::shared_message_memory_allocator::inc_ref ()
 {
-    (reinterpret_cast<zmq::atomic_counter_t *> (buf))->add (1);
+    (reinterpret_cast<header_t *> (buf))->refcnt.add (1);
 }
 
 void zmq::shared_message_memory_allocator::call_dec_ref (void *, void *hint)
 {
     zmq_assert (hint);
-    unsigned char *buf = static_cast<unsigned char *> (hint);
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (buf);
+    header_t *header = static_cast<header_t *> (hint);
 
-    if (!c->sub (1)) {
-        c->~atomic_counter_t ();
-        std::free (buf);
-        buf = NULL;
-    }
+    if (!header->refcnt.sub (1) && !header->pool->put (header))
+        destroy (header);
 }
 
+void zmq::shared_message_memory_allocator::destroy (header_t *header_)
+{
+    pool_t *pool = header_->pool;
+    header_->~header_t ();
+    std::free (header_);
+    if (!pool->refs.sub (1))
+        delete pool;
+}
 
 std::size_t zmq::shared_message_memory_allocator::size () const
 {
@@ -147,5 +266,5 @@ std::size_t zmq::shared_message_memory_allocator::size () const
 
 unsigned char *zmq::shared_message_memory_allocator::data ()
 {
-    return buf + sizeof (zmq::atomic_counter_t);
+    return buf + sizeof (header_t);
 }
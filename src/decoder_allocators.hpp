@@ -77,6 +77,12 @@ class c_single_allocator
 // from zero to one, gets passed to the user application, processed in the user thread and deleted
 // which would then deallocate the buffer. The drawback is that the buffer may be allocated longer
 // than necessary because it is only deleted when allocate is called the next time.
+//
+// Buffers whose messages have all been closed go back to a pool owned by the
+// allocator instead of being freed, and later calls to allocate take them from
+// there. Consumers return buffers from their own threads through a lock-free
+// list. The pool outlives the allocator for as long as any of its buffers are
+// still referenced by messages.
 class shared_message_memory_allocator
 {
   public:
@@ -120,11 +126,27 @@ class shared_message_memory_allocator
     void advance_content () { msg_content++; }
 
   private:
+    struct header_t;
+    struct pool_t;
+
+    void init_pool ();
+
+    // Bytes allocated for each buffer, header and message contents included.
+    std::size_t allocation_size () const;
+
+    // Free a buffer and drop its reference to the pool.
+    static void destroy (header_t *header_);
+
     unsigned char *buf;
     std::size_t bufsize;
     const std::size_t max_size;
     zmq::msg_t::content_t *msg_content;
     std::size_t maxCounters;
+    pool_t *pool;
+
+    shared_message_memory_allocator (shared_message_memory_allocator const &);
+    shared_message_memory_allocator &
+    operator= (shared_message_memory_allocator const &);
 };
 }
 
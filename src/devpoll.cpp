@@ -135,9 +135,9 @@ void zmq::devpoll_t::reset_pollout (handle_t handle_)
     devpoll_ctl (handle_, fd_table[handle_].events);
 }
 
-void zmq::devpoll_t::start ()
+void zmq::devpoll_t::start (int cpu_)
 {
-    ctx.start_thread (worker, worker_routine, this);
+    ctx.start_thread (worker, worker_routine, this, cpu_);
 }
 
 void zmq::devpoll_t::stop ()
@@ -176,6 +176,7 @@ void zmq::devpoll_t::loop ()
         if (n == -1 && errno == EINTR)
             continue;
         errno_assert (n != -1);
+        const uint64_t start = clock_t::now_us ();
 
         for (int i = 0; i < n; i++) {
             fd_entry_t *fd_ptr = &fd_table[ev_buf[i].fd];
@@ -192,6 +193,8 @@ void zmq::devpoll_t::loop ()
             if (ev_buf[i].revents & POLLIN)
                 fd_ptr->reactor->in_event ();
         }
+
+        account_busy (start);
     }
 }
 
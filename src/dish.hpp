@@ -37,7 +37,6 @@
 #include "session_base.hpp"
 #include "dist.hpp"
 #include "fq.hpp"
-#include "trie.hpp"
 
 namespace zmq
 {
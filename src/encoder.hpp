@@ -59,6 +59,7 @@ template <typename T> class encoder_base_t : public i_encoder
         to_write (0),
         next (NULL),
         new_msg_flag (false),
+        gather_threshold (0),
         bufsize (bufsize_),
         buf ((unsigned char *) malloc (bufsize_)),
         in_progress (NULL)
@@ -76,7 +77,8 @@ template <typename T> class encoder_base_t : public i_encoder
     inline size_t encode (unsigned char **data_, size_t size_)
     {
         unsigned char *buffer = !*data_ ? buf : *data_;
-        size_t buffersize = !*data_ ? bufsize : size_;
+        size_t buffersize =
+          !*data_ ? (size_ && size_ < bufsize ? size_ : bufsize) : size_;
 
         if (in_progress == NULL)
             return 0;
@@ -116,6 +118,12 @@ template <typename T> class encoder_base_t : public i_encoder
                 return pos;
             }
 
+            //  In gather mode large chunks are not copied into the buffer.
+            //  They are left in place to be picked up by 'gather' and
+            //  written right after the data batched so far.
+            if (gather_threshold && to_write >= gather_threshold)
+                break;
+
             //  Copy data to the buffer. If the buffer is full, return.
             size_t to_copy = std::min (to_write, buffersize - pos);
             memcpy (buffer + pos, write_pos, to_copy);
@@ -135,6 +143,25 @@ template <typename T> class encoder_base_t : public i_encoder
         (static_cast<T *> (this)->*next) ();
     }
 
+    void set_gather_threshold (size_t threshold_)
+    {
+        gather_threshold = threshold_;
+    }
+
+    inline size_t gather (unsigned char **data_)
+    {
+        if (!gather_threshold || to_write < gather_threshold)
+            return 0;
+
+        //  Hand out the pending chunk in place. The message it belongs to
+        //  is not released until the next call to encode.
+        *data_ = write_pos;
+        const size_t size = to_write;
+        write_pos = NULL;
+        to_write = 0;
+        return size;
+    }
+
   protected:
     //  Prototype of state machine action.
     typedef void (T::*step_t) ();
@@ -165,6 +192,10 @@ template <typename T> class encoder_base_t : public i_encoder
 
     bool new_msg_flag;
 
+    //  Chunks at least this large are left for 'gather' instead of being
+    //  copied into the buffer. Zero disables gather mode.
+    size_t gather_threshold;
+
     //  The buffer for encoded data.
     const size_t bufsize;
     unsigned char *const buf;
@@ -179,6 +179,7 @@ void zmq::epoll_t::loop ()
             errno_assert (errno == EINTR);
             continue;
         }
+        const uint64_t start = clock_t::now_us ();
 
         for (int i = 0; i < n; i++) {
             poll_entry_t *pe = ((poll_entry_t *) ev_buf[i].data.ptr);
@@ -205,6 +206,8 @@ void zmq::epoll_t::loop ()
         }
         retired.clear ();
         retired_sync.unlock ();
+
+        account_busy (start);
     }
 }
 
@@ -38,6 +38,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace zmq
 {
 //  Multi-trie (prefix tree). Each node in the trie is a set of pointers.
+//  Chains of nodes that have a single child and no values of their own
+//  are collapsed into a byte label held by the node below them, so that
+//  matching long topics compares bytes in place instead of chasing one
+//  pointer per character.
 template <typename T> class generic_mtrie_t
 {
   public:
@@ -95,9 +99,23 @@ template <typename T> class generic_mtrie_t
     rm_result rm_helper (prefix_t prefix_, size_t size_, value_t *value_);
     bool is_redundant () const;
 
+    //  Splits the label at offset common_. The node keeps the first
+    //  common_ bytes of the label and a single child takes the rest
+    //  together with the values and subnodes of this node.
+    void split (size_t common_);
+
+    //  Merges the single child into this node if this node holds no
+    //  values of its own.
+    void compact ();
+
     typedef std::set<value_t *> pipes_t;
     pipes_t *pipes;
 
+    //  Bytes that follow the character leading to this node and precede
+    //  the prefix at which pipes are attached.
+    unsigned char *label;
+    size_t label_size;
+
     unsigned char min;
     unsigned short count;
     unsigned short live_nodes;
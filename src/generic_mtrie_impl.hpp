@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <new>
 #include <algorithm>
@@ -44,6 +45,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 template <typename T>
 zmq::generic_mtrie_t<T>::generic_mtrie_t () :
     pipes (0),
+    label (0),
+    label_size (0),
     min (0),
     count (0),
     live_nodes (0)
@@ -53,6 +56,7 @@ zmq::generic_mtrie_t<T>::generic_mtrie_t () :
 template <typename T> zmq::generic_mtrie_t<T>::~generic_mtrie_t ()
 {
     LIBZMQ_DELETE (pipes);
+    free (label);
 
     if (count == 1) {
         zmq_assert (next.node);
@@ -78,6 +82,19 @@ bool zmq::generic_mtrie_t<T>::add_helper (prefix_t prefix_,
                                           size_t size_,
                                           value_t *pipe_)
 {
+    //  Consume the label. If the prefix diverges from it or ends inside
+    //  it, split the label at that point.
+    if (label_size) {
+        size_t common = 0;
+        while (common < label_size && common < size_
+               && label[common] == prefix_[common])
+            ++common;
+        if (common < label_size)
+            split (common);
+        prefix_ += common;
+        size_ -= common;
+    }
+
     //  We are at the node corresponding to the prefix. We are done.
     if (!size_) {
         bool result = !pipes;
@@ -132,22 +149,79 @@ bool zmq::generic_mtrie_t<T>::add_helper (prefix_t prefix_,
         }
     }
 
-    //  If next node does not exist, create one.
-    if (count == 1) {
-        if (!next.node) {
-            next.node = new (std::nothrow) generic_mtrie_t;
-            alloc_assert (next.node);
-            ++live_nodes;
-        }
-        return next.node->add_helper (prefix_ + 1, size_ - 1, pipe_);
-    } else {
-        if (!next.table[c - min]) {
-            next.table[c - min] = new (std::nothrow) generic_mtrie_t;
-            alloc_assert (next.table[c - min]);
-            ++live_nodes;
+    //  If next node does not exist, create one. The whole remainder of
+    //  the prefix becomes its label.
+    generic_mtrie_t **slot = count == 1 ? &next.node : &next.table[c - min];
+    if (!*slot) {
+        *slot = new (std::nothrow) generic_mtrie_t;
+        alloc_assert (*slot);
+        ++live_nodes;
+        if (size_ > 1) {
+            (*slot)->label_size = size_ - 1;
+            (*slot)->label = (unsigned char *) malloc (size_ - 1);
+            alloc_assert ((*slot)->label);
+            memcpy ((*slot)->label, prefix_ + 1, size_ - 1);
         }
-        return next.table[c - min]->add_helper (prefix_ + 1, size_ - 1, pipe_);
     }
+    return (*slot)->add_helper (prefix_ + 1, size_ - 1, pipe_);
+}
+
+template <typename T> void zmq::generic_mtrie_t<T>::split (size_t common_)
+{
+    zmq_assert (common_ < label_size);
+
+    generic_mtrie_t *tail = new (std::nothrow) generic_mtrie_t;
+    alloc_assert (tail);
+    tail->pipes = pipes;
+    tail->min = min;
+    tail->count = count;
+    tail->live_nodes = live_nodes;
+    tail->next = next;
+    tail->label_size = label_size - common_ - 1;
+    if (tail->label_size) {
+        tail->label = (unsigned char *) malloc (tail->label_size);
+        alloc_assert (tail->label);
+        memcpy (tail->label, label + common_ + 1, tail->label_size);
+    }
+
+    pipes = NULL;
+    min = label[common_];
+    count = 1;
+    live_nodes = 1;
+    next.node = tail;
+    label_size = common_;
+    if (!label_size) {
+        free (label);
+        label = NULL;
+    }
+}
+
+template <typename T> void zmq::generic_mtrie_t<T>::compact ()
+{
+    if (pipes || count != 1 || !next.node)
+        return;
+
+    //  The new label is the old one, the character leading to the
+    //  child and the child's label.
+    generic_mtrie_t *child = next.node;
+    size_t size = label_size + 1 + child->label_size;
+    unsigned char *merged = (unsigned char *) realloc (label, size);
+    alloc_assert (merged);
+    merged[label_size] = min;
+    if (child->label_size)
+        memcpy (merged + label_size + 1, child->label, child->label_size);
+    label = merged;
+    label_size = size;
+
+    pipes = child->pipes;
+    min = child->min;
+    count = child->count;
+    live_nodes = child->live_nodes;
+    next = child->next;
+
+    child->pipes = NULL;
+    child->count = 0;
+    LIBZMQ_DELETE (child);
 }
 
 
@@ -177,6 +251,17 @@ void zmq::generic_mtrie_t<T>::rm_helper(value_t *pipe_,
                                          Arg arg_,
                                          bool call_on_uniq_)
 {
+    //  Append the label to the buffer.
+    if (label_size) {
+        if (buffsize_ + label_size >= maxbuffsize_) {
+            maxbuffsize_ = buffsize_ + label_size + 256;
+            *buff_ = (unsigned char *) realloc (*buff_, maxbuffsize_);
+            alloc_assert (*buff_);
+        }
+        memcpy (*buff_ + buffsize_, label, label_size);
+        buffsize_ += label_size;
+    }
+
     //  Remove the subscription from this node.
     if (pipes && pipes->erase (pipe_)) {
         if (!call_on_uniq_ || pipes->empty ()) {
@@ -213,6 +298,7 @@ void zmq::generic_mtrie_t<T>::rm_helper(value_t *pipe_,
             --live_nodes;
             zmq_assert (live_nodes == 0);
         }
+        compact ();
         return;
     }
 
@@ -291,6 +377,8 @@ void zmq::generic_mtrie_t<T>::rm_helper(value_t *pipe_,
 
         min = new_min;
     }
+
+    compact ();
 }
 
 template <typename T>
@@ -304,6 +392,13 @@ template <typename T>
 typename zmq::generic_mtrie_t<T>::rm_result zmq::generic_mtrie_t<T>::rm_helper (
   prefix_t prefix_, size_t size_, value_t *pipe_)
 {
+    if (label_size) {
+        if (size_ < label_size || memcmp (prefix_, label, label_size) != 0)
+            return not_found;
+        prefix_ += label_size;
+        size_ -= label_size;
+    }
+
     if (!size_) {
         if (!pipes)
             return not_found;
@@ -312,6 +407,7 @@ typename zmq::generic_mtrie_t<T>::rm_result zmq::generic_mtrie_t<T>::rm_helper (
         if (pipes->empty ()) {
             zmq_assert (erased == 1);
             LIBZMQ_DELETE (pipes);
+            compact ();
             return last_value_removed;
         }
         return (erased == 1) ? values_remain : not_found;
@@ -393,6 +489,7 @@ typename zmq::generic_mtrie_t<T>::rm_result zmq::generic_mtrie_t<T>::rm_helper (
                 free (old_table);
             }
         }
+        compact ();
     }
 
     return ret;
@@ -407,6 +504,15 @@ void zmq::generic_mtrie_t<T>::match (prefix_t data_,
 {
     generic_mtrie_t *current = this;
     while (true) {
+        //  The label has to be matched as a whole.
+        if (current->label_size) {
+            if (size_ < current->label_size
+                || memcmp (data_, current->label, current->label_size) != 0)
+                break;
+            data_ += current->label_size;
+            size_ -= current->label_size;
+        }
+
         //  Signal the pipes attached to this node.
         if (current->pipes) {
             for (typename pipes_t::iterator it = current->pipes->begin ();
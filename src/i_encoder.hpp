@@ -45,12 +45,23 @@ struct i_encoder
 
     //  The function returns a batch of binary data. The data
     //  are filled to a supplied buffer. If no buffer is supplied (data_
-    //  is NULL) encoder will provide buffer of its own.
+    //  is NULL) encoder will provide buffer of its own, using no more
+    //  than size bytes of it unless size is 0.
     //  Function returns 0 when a new message is required.
     virtual size_t encode (unsigned char **data_, size_t size) = 0;
 
     //  Load a new message into encoder.
     virtual void load_msg (msg_t *msg_) = 0;
+
+    //  Enables gather mode. Chunks of at least threshold_ bytes (typically
+    //  message bodies) are not copied by encode; encode stops in front of
+    //  them instead. Zero disables gather mode.
+    virtual void set_gather_threshold (size_t threshold_) = 0;
+
+    //  Returns the chunk encode stopped at in gather mode, without copying
+    //  it. The data stay valid until the next call to encode.
+    //  Returns 0 if there is no such chunk.
+    virtual size_t gather (unsigned char **data_) = 0;
 };
 }
 
@@ -58,6 +58,14 @@ struct i_engine
 
     virtual void zap_msg_available () = 0;
 
+    //  Detaches the engine from its I/O thread, keeping the connection,
+    //  so that it can be moved to another I/O thread. Returns false if
+    //  the engine cannot be moved at the moment.
+    virtual bool suspend () = 0;
+
+    //  Attaches an engine detached by suspend to an I/O thread.
+    virtual void resume (zmq::io_thread_t *io_thread_) = 0;
+
     virtual const char *get_endpoint () const = 0;
 };
 }
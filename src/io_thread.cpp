@@ -35,6 +35,7 @@
 #include "io_thread.hpp"
 #include "err.hpp"
 #include "ctx.hpp"
+#include "likely.hpp"
 
 zmq::io_thread_t::io_thread_t (ctx_t *ctx_, uint32_t tid_) :
     object_t (ctx_, tid_),
@@ -54,10 +55,10 @@ zmq::io_thread_t::~io_thread_t ()
     LIBZMQ_DELETE (poller);
 }
 
-void zmq::io_thread_t::start ()
+void zmq::io_thread_t::start (int cpu_)
 {
     //  Start the underlying I/O thread.
-    poller->start ();
+    poller->start (cpu_);
 }
 
 void zmq::io_thread_t::stop ()
@@ -75,6 +76,11 @@ int zmq::io_thread_t::get_load ()
     return poller->get_load ();
 }
 
+int zmq::io_thread_t::get_busy ()
+{
+    return poller->get_busy ();
+}
+
 void zmq::io_thread_t::in_event ()
 {
     //  TODO: Do we want to limit number of commands I/O thread can
@@ -85,13 +91,41 @@ void zmq::io_thread_t::in_event ()
 
     while (rc == 0 || errno == EINTR) {
         if (rc == 0)
-            cmd.destination->process_command (cmd);
+            dispatch (cmd);
         rc = mailbox.recv (&cmd, 0);
     }
 
     errno_assert (rc != 0 && errno == EAGAIN);
 }
 
+void zmq::io_thread_t::dispatch (command_t &cmd_)
+{
+    //  Commands for migrated objects are sent to the thread the objects
+    //  belong to, which forwards them. Thus they keep their order. Were
+    //  the senders to address the running thread directly, commands sent
+    //  after a move could overtake those still waiting to be forwarded.
+    //  The price is a wakeup of this thread per forwarded command.
+    if (cmd_.destination->get_tid () == get_tid ()) {
+        const uint32_t runner_tid = cmd_.destination->get_runner_tid ();
+        if (unlikely (runner_tid == migrating_tid)) {
+            held_commands.push_back (cmd_);
+            return;
+        }
+
+        //  Hold back further commands until the object has handed over to
+        //  the thread it ends up in, possibly the one it is running in.
+        if (unlikely (cmd_.type == command_t::migrate))
+            cmd_.destination->set_runner_tid (migrating_tid);
+
+        if (unlikely (runner_tid != get_tid ())) {
+            get_ctx ()->send_command (runner_tid, cmd_);
+            return;
+        }
+    }
+
+    cmd_.destination->process_command (cmd_);
+}
+
 void zmq::io_thread_t::out_event ()
 {
     //  We are never polling for POLLOUT here. This function is never called.
@@ -110,6 +144,27 @@ zmq::poller_t *zmq::io_thread_t::get_poller ()
     return poller;
 }
 
+void zmq::io_thread_t::process_reroute (object_t *object_,
+                                        io_thread_t *io_thread_)
+{
+    zmq_assert (object_->get_tid () == get_tid ());
+    zmq_assert (object_->get_runner_tid () == migrating_tid);
+    object_->set_runner_tid (io_thread_->get_tid ());
+
+    //  Let the object resume in its new thread before passing on the
+    //  commands held back in the meantime.
+    command_t cmd;
+    cmd.destination = object_;
+    cmd.type = command_t::adopt;
+    dispatch (cmd);
+
+    held_commands_t commands;
+    commands.swap (held_commands);
+    for (held_commands_t::iterator it = commands.begin ();
+         it != commands.end (); ++it)
+        dispatch (*it);
+}
+
 void zmq::io_thread_t::process_stop ()
 {
     zmq_assert (mailbox_handle);
@@ -37,6 +37,7 @@
 #include "poller.hpp"
 #include "i_poll_events.hpp"
 #include "mailbox.hpp"
+#include "command.hpp"
 
 namespace zmq
 {
@@ -55,7 +56,8 @@ class io_thread_t : public object_t, public i_poll_events
     ~io_thread_t ();
 
     //  Launch the physical thread.
-    void start ();
+    //  If cpu_ is not negative, the thread is pinned to that CPU.
+    void start (int cpu_);
 
     //  Ask underlying thread to stop.
     void stop ();
@@ -73,11 +75,21 @@ class io_thread_t : public object_t, public i_poll_events
 
     //  Command handlers.
     void process_stop ();
+    void process_reroute (zmq::object_t *object_, zmq::io_thread_t *io_thread_);
 
     //  Returns load experienced by the I/O thread.
     int get_load ();
 
+    //  Returns the share of time the I/O thread spent handling events
+    //  recently, in parts per million.
+    int get_busy ();
+
   private:
+    //  Processes a command, or forwards it to the I/O thread running the
+    //  destination object if the object belongs to this thread but has
+    //  been migrated.
+    void dispatch (command_t &cmd_);
+
     //  I/O thread accesses incoming commands via this mailbox.
     mailbox_t mailbox;
 
@@ -87,6 +99,11 @@ class io_thread_t : public object_t, public i_poll_events
     //  I/O multiplexing is performed using a poller object.
     poller_t *poller;
 
+    //  Commands for objects on their way to another I/O thread, in the
+    //  order they arrived.
+    typedef std::vector<command_t> held_commands_t;
+    held_commands_t held_commands;
+
     io_thread_t (const io_thread_t &);
     const io_thread_t &operator= (const io_thread_t &);
 };
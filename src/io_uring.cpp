@@ -0,0 +1,383 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "precompiled.hpp"
+#include "io_uring.hpp"
+#if defined ZMQ_USE_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <algorithm>
+#include <new>
+
+#include "macros.hpp"
+#include "err.hpp"
+#include "config.hpp"
+#include "i_poll_events.hpp"
+
+//  Poll masks are passed to the kernel in 32-bit words with the halves
+//  swapped on big-endian machines.
+static unsigned int poll_mask (unsigned int events_)
+{
+#if __BYTE_ORDER == __BIG_ENDIAN
+    return (events_ << 16) | (events_ >> 16);
+#else
+    return events_;
+#endif
+}
+
+zmq::io_uring_t::io_uring_t (const zmq::thread_ctx_t &ctx_) :
+    worker_poller_base_t (ctx_),
+    sq_local_tail (0)
+{
+    io_uring_params params;
+    memset (&params, 0, sizeof params);
+    ring_fd = (fd_t) syscall (__NR_io_uring_setup, max_io_events, &params);
+    errno_assert (ring_fd != -1);
+
+    //  Waiting for completions with a timeout requires IORING_FEAT_EXT_ARG,
+    //  available since Linux 5.11. Re-armed poll operations may exceed
+    //  the size of the completion queue, so IORING_FEAT_NODROP is needed
+    //  as well.
+    zmq_assert (params.features & IORING_FEAT_EXT_ARG);
+    zmq_assert (params.features & IORING_FEAT_NODROP);
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+        sq_ring_size = cq_ring_size = std::max (sq_ring_size, cq_ring_size);
+
+    sq_ring = mmap (NULL, sq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    errno_assert (sq_ring != MAP_FAILED);
+    if (single_mmap)
+        cq_ring = sq_ring;
+    else {
+        cq_ring = mmap (NULL, cq_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        errno_assert (cq_ring != MAP_FAILED);
+    }
+    sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+    void *sqes_ptr = mmap (NULL, sqes_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    errno_assert (sqes_ptr != MAP_FAILED);
+    sqes = (io_uring_sqe *) sqes_ptr;
+
+    unsigned char *sq = (unsigned char *) sq_ring;
+    sq_entries = params.sq_entries;
+    sq_head = (unsigned *) (sq + params.sq_off.head);
+    sq_tail = (unsigned *) (sq + params.sq_off.tail);
+    sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+    sq_array = (unsigned *) (sq + params.sq_off.array);
+    sq_local_tail = *sq_tail;
+
+    unsigned char *cq = (unsigned char *) cq_ring;
+    cq_head = (unsigned *) (cq + params.cq_off.head);
+    cq_tail = (unsigned *) (cq + params.cq_off.tail);
+    cq_mask = (unsigned *) (cq + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe *) (cq + params.cq_off.cqes);
+}
+
+zmq::io_uring_t::~io_uring_t ()
+{
+    //  Wait till the worker thread exits.
+    stop_worker ();
+
+    //  Closing the ring cancels any operations still in flight.
+    munmap (sqes, sqes_size);
+    if (cq_ring != sq_ring)
+        munmap (cq_ring, cq_ring_size);
+    munmap (sq_ring, sq_ring_size);
+    close (ring_fd);
+
+    for (retired_t::iterator it = retired.begin (); it != retired.end ();
+         ++it) {
+        LIBZMQ_DELETE (*it);
+    }
+}
+
+zmq::io_uring_t::handle_t zmq::io_uring_t::add_fd (fd_t fd_,
+                                                   i_poll_events *events_)
+{
+    check_thread ();
+    poll_entry_t *pe = new (std::nothrow) poll_entry_t;
+    alloc_assert (pe);
+
+    pe->fd = fd_;
+    pe->events = 0;
+    pe->armed = 0;
+    pe->pending = false;
+    pe->cancelling = false;
+    pe->changed = false;
+    pe->events_sink = events_;
+
+    //  Even with no events requested, errors and hang-ups are reported.
+    update (pe);
+
+    //  Increase the load metric of the thread.
+    adjust_load (1);
+
+    return pe;
+}
+
+void zmq::io_uring_t::rm_fd (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->fd = retired_fd;
+    retired.push_back (pe);
+
+    //  The poll operation in flight holds a reference to the file. Cancel
+    //  it straight away, so that the caller closing the fd next actually
+    //  closes the connection rather than at the next wait.
+    if (pe->pending && !pe->cancelling) {
+        remove_poll (pe);
+        enter (false, 0);
+    }
+
+    //  Decrease the load metric of the thread.
+    adjust_load (-1);
+}
+
+void zmq::io_uring_t::set_pollin (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->events |= POLLIN;
+    update (pe);
+}
+
+void zmq::io_uring_t::reset_pollin (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->events &= ~((unsigned int) POLLIN);
+    update (pe);
+}
+
+void zmq::io_uring_t::set_pollout (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->events |= POLLOUT;
+    update (pe);
+}
+
+void zmq::io_uring_t::reset_pollout (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->events &= ~((unsigned int) POLLOUT);
+    update (pe);
+}
+
+void zmq::io_uring_t::stop ()
+{
+    check_thread ();
+}
+
+int zmq::io_uring_t::max_fds ()
+{
+    return -1;
+}
+
+void zmq::io_uring_t::update (poll_entry_t *pe_)
+{
+    if (!pe_->changed) {
+        pe_->changed = true;
+        changes.push_back (pe_);
+    }
+}
+
+void zmq::io_uring_t::flush_changes ()
+{
+    for (changes_t::iterator it = changes.begin (); it != changes.end ();
+         ++it) {
+        poll_entry_t *pe = *it;
+        pe->changed = false;
+
+        bool add = false;
+        bool remove = false;
+        if (pe->fd == retired_fd)
+            remove = pe->pending && !pe->cancelling;
+        else if (!pe->pending)
+            add = true;
+        else
+            //  Dropped events are filtered out when the operation in flight
+            //  completes. Only newly requested events need a new operation.
+            remove = (pe->events & ~pe->armed) && !pe->cancelling;
+
+        if (add) {
+            io_uring_sqe *sqe = get_sqe ();
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = pe->fd;
+            sqe->poll32_events = poll_mask (pe->events);
+            sqe->user_data = (uint64_t) pe;
+            pe->pending = true;
+            pe->armed = pe->events;
+        } else if (remove)
+            remove_poll (pe);
+    }
+    changes.clear ();
+
+    //  Destroy retired event sources with no operation in flight.
+    retired_t::iterator last = retired.begin ();
+    for (retired_t::iterator it = retired.begin (); it != retired.end ();
+         ++it) {
+        if ((*it)->pending)
+            *last++ = *it;
+        else
+            LIBZMQ_DELETE (*it);
+    }
+    retired.erase (last, retired.end ());
+}
+
+void zmq::io_uring_t::remove_poll (poll_entry_t *pe_)
+{
+    //  The poll operation completes with -ECANCELED and is re-armed from
+    //  there unless the entry is retired. The removal itself completes
+    //  with no user data.
+    io_uring_sqe *sqe = get_sqe ();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t) pe_;
+    sqe->user_data = 0;
+    pe_->cancelling = true;
+}
+
+io_uring_sqe *zmq::io_uring_t::get_sqe ()
+{
+    //  If the submission queue is full, hand the queued entries over to
+    //  the kernel first.
+    if (sq_local_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE)
+        == sq_entries)
+        enter (false, 0);
+
+    const unsigned index = sq_local_tail & *sq_mask;
+    io_uring_sqe *sqe = &sqes[index];
+    memset (sqe, 0, sizeof *sqe);
+    sq_array[index] = index;
+    sq_local_tail++;
+    return sqe;
+}
+
+void zmq::io_uring_t::enter (bool wait_, int timeout_)
+{
+    __atomic_store_n (sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+    const unsigned to_submit =
+      sq_local_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE);
+
+    struct timespec ts;
+    io_uring_getevents_arg arg;
+    memset (&arg, 0, sizeof arg);
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeout_) {
+        ts.tv_sec = timeout_ / 1000;
+        ts.tv_nsec = (timeout_ % 1000) * 1000000;
+        arg.ts = (uint64_t) &ts;
+    }
+
+    const unsigned flags =
+      wait_ ? IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG : 0;
+    const int rc =
+      (int) syscall (__NR_io_uring_enter, ring_fd, to_submit, wait_ ? 1 : 0,
+                     flags, wait_ ? &arg : NULL, wait_ ? sizeof arg : 0);
+    if (rc == -1)
+        errno_assert (errno == EINTR || errno == ETIME || errno == EAGAIN
+                      || errno == EBUSY);
+}
+
+void zmq::io_uring_t::process_completions ()
+{
+    unsigned head = *cq_head;
+    while (head != __atomic_load_n (cq_tail, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe *cqe = &cqes[head & *cq_mask];
+        poll_entry_t *pe = (poll_entry_t *) cqe->user_data;
+        const int res = cqe->res;
+        __atomic_store_n (cq_head, ++head, __ATOMIC_RELEASE);
+
+        //  Completion of a removal request.
+        if (!pe)
+            continue;
+
+        pe->pending = false;
+        pe->cancelling = false;
+        if (pe->fd == retired_fd)
+            continue;
+
+        if (res < 0) {
+            errno = -res;
+            errno_assert (res == -ECANCELED);
+        } else {
+            if (res & (POLLERR | POLLHUP))
+                pe->events_sink->in_event ();
+            if (pe->fd != retired_fd && (res & POLLOUT)
+                && (pe->events & POLLOUT))
+                pe->events_sink->out_event ();
+            if (pe->fd != retired_fd && (res & POLLIN)
+                && (pe->events & POLLIN))
+                pe->events_sink->in_event ();
+        }
+
+        //  Poll operations are one-shot. Re-arm.
+        if (pe->fd != retired_fd)
+            update (pe);
+    }
+}
+
+void zmq::io_uring_t::loop ()
+{
+    while (true) {
+        //  Execute any due timers.
+        int timeout = (int) execute_timers ();
+
+        //  With no fds left, the wait below just sleeps till the next
+        //  timer.
+        if (get_load () == 0 && timeout == 0)
+            break;
+
+        //  Submit the changes made since the last wait along with the wait.
+        flush_changes ();
+        enter (true, timeout);
+        const uint64_t start = clock_t::now_us ();
+        process_completions ();
+        account_busy (start);
+    }
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __ZMQ_IO_URING_HPP_INCLUDED__
+#define __ZMQ_IO_URING_HPP_INCLUDED__
+
+//  poller.hpp decides which polling mechanism to use.
+#include "poller.hpp"
+#if defined ZMQ_USE_IO_URING
+
+#include <vector>
+#include <linux/io_uring.h>
+
+#include "ctx.hpp"
+#include "fd.hpp"
+#include "thread.hpp"
+#include "poller_base.hpp"
+
+namespace zmq
+{
+struct i_poll_events;
+
+//  This class implements socket polling mechanism using the Linux-specific
+//  io_uring interface. It is a readiness poller only: readiness is requested
+//  by one-shot poll operations that are re-armed after each completion,
+//  while the engines keep reading and writing the fds themselves. All the
+//  changes made while processing events are submitted in one batch, using
+//  the same system call that waits for the next completions.
+//
+//  Reads and writes are deliberately not submitted as operations of their
+//  own. The engines decide how much to read into the decoder's buffer and
+//  when to stop writing (handshake, mechanism, HWM), synchronously within
+//  in_event and out_event. Completion-based I/O would need the ring to own
+//  those buffers across the engine's lifetime, including while the engine
+//  is unplugged, migrated or being terminated.
+
+class io_uring_t : public worker_poller_base_t
+{
+  public:
+    typedef void *handle_t;
+
+    io_uring_t (const thread_ctx_t &ctx_);
+    ~io_uring_t ();
+
+    //  "poller" concept.
+    handle_t add_fd (fd_t fd_, zmq::i_poll_events *events_);
+    void rm_fd (handle_t handle_);
+    void set_pollin (handle_t handle_);
+    void reset_pollin (handle_t handle_);
+    void set_pollout (handle_t handle_);
+    void reset_pollout (handle_t handle_);
+    void stop ();
+
+    static int max_fds ();
+
+  private:
+    //  Main event loop.
+    void loop ();
+
+    struct poll_entry_t
+    {
+        fd_t fd;
+
+        //  Events the fd is to be polled for.
+        unsigned int events;
+
+        //  Events the outstanding poll operation was submitted with.
+        unsigned int armed;
+
+        //  True iff there is a poll operation in flight.
+        bool pending;
+
+        //  True iff removal of the poll operation in flight was requested.
+        bool cancelling;
+
+        //  True iff the entry is on the list of changes to submit.
+        bool changed;
+
+        zmq::i_poll_events *events_sink;
+    };
+
+    //  Schedules submission of the entry's current state.
+    void update (poll_entry_t *pe_);
+
+    //  Queues operations for all the entries changed since the last call
+    //  and destroys retired entries with no operations in flight.
+    void flush_changes ();
+
+    //  Queues cancellation of the entry's poll operation in flight.
+    void remove_poll (poll_entry_t *pe_);
+
+    //  Returns the next free submission queue entry.
+    io_uring_sqe *get_sqe ();
+
+    //  Submits queued operations. If wait_ is true, waits for at least one
+    //  completion for up to timeout_ milliseconds (forever if zero).
+    void enter (bool wait_, int timeout_);
+
+    //  Dispatches all the available completions.
+    void process_completions ();
+
+    //  The ring's file descriptor.
+    fd_t ring_fd;
+
+    //  Submission queue.
+    void *sq_ring;
+    size_t sq_ring_size;
+    unsigned sq_entries;
+    unsigned sq_local_tail;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    //  Completion queue.
+    void *cq_ring;
+    size_t cq_ring_size;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    io_uring_cqe *cqes;
+
+    //  Entries whose state has to be submitted.
+    typedef std::vector<poll_entry_t *> changes_t;
+    changes_t changes;
+
+    //  List of retired event sources.
+    typedef std::vector<poll_entry_t *> retired_t;
+    retired_t retired;
+
+    io_uring_t (const io_uring_t &);
+    const io_uring_t &operator= (const io_uring_t &);
+};
+
+typedef io_uring_t poller_t;
+}
+
+#endif
+
+#endif
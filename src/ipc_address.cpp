@@ -75,6 +75,11 @@ int zmq::ipc_address_t::resolve (const char *path_)
 }
 
 int zmq::ipc_address_t::to_string (std::string &addr_)
+{
+    return to_string (addr_, "ipc");
+}
+
+int zmq::ipc_address_t::to_string (std::string &addr_, const char *protocol_)
 {
     if (address.sun_family != AF_UNIX) {
         addr_.clear ();
@@ -82,7 +87,7 @@ int zmq::ipc_address_t::to_string (std::string &addr_)
     }
 
     std::stringstream s;
-    s << "ipc://";
+    s << protocol_ << "://";
     if (!address.sun_path[0] && address.sun_path[1])
         s << "@" << address.sun_path + 1;
     else
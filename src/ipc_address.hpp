@@ -52,6 +52,10 @@ class ipc_address_t
     //  The opposite to resolve()
     int to_string (std::string &addr_);
 
+    //  Same as above, for transports other than ipc:// that use UNIX
+    //  domain sockets too.
+    int to_string (std::string &addr_, const char *protocol_);
+
     const sockaddr *addr () const;
     socklen_t addrlen () const;
 
@@ -36,9 +36,11 @@
 #include <string>
 
 #include "stream_engine.hpp"
+#include "shm_engine.hpp"
 #include "io_thread.hpp"
 #include "random.hpp"
 #include "err.hpp"
+#include "macros.hpp"
 #include "ip.hpp"
 #include "address.hpp"
 #include "ipc_address.hpp"
@@ -65,7 +67,7 @@ zmq::ipc_connecter_t::ipc_connecter_t (class io_thread_t *io_thread_,
     current_reconnect_ivl (options.reconnect_ivl)
 {
     zmq_assert (addr);
-    zmq_assert (addr->protocol == "ipc");
+    zmq_assert (addr->protocol == "ipc" || addr->protocol == "shm");
     addr->to_string (endpoint);
     socket = session->get_socket ();
 }
@@ -124,9 +126,25 @@ void zmq::ipc_connecter_t::out_event ()
         return;
     }
     //  Create the engine object for this connection.
-    stream_engine_t *engine =
-      new (std::nothrow) stream_engine_t (fd, options, endpoint);
-    alloc_assert (engine);
+    stream_engine_t *engine;
+#if defined HAVE_MEMFD_CREATE
+    if (addr->protocol == "shm") {
+        shm_engine_t *shm_engine =
+          new (std::nothrow) shm_engine_t (fd, options, endpoint);
+        alloc_assert (shm_engine);
+        if (shm_engine->init () != 0) {
+            //  The engine owns the connection and closes it.
+            LIBZMQ_DELETE (shm_engine);
+            add_reconnect_timer ();
+            return;
+        }
+        engine = shm_engine;
+    } else
+#endif
+    {
+        engine = new (std::nothrow) stream_engine_t (fd, options, endpoint);
+        alloc_assert (engine);
+    }
 
     //  Attach the engine to the corresponding session object.
     send_attach (session, engine);
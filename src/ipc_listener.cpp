@@ -37,11 +37,13 @@
 #include <string.h>
 
 #include "stream_engine.hpp"
+#include "shm_engine.hpp"
 #include "ipc_address.hpp"
 #include "io_thread.hpp"
 #include "session_base.hpp"
 #include "config.hpp"
 #include "err.hpp"
+#include "macros.hpp"
 #include "ip.hpp"
 #include "socket_base.hpp"
 
@@ -131,12 +133,14 @@ int zmq::ipc_listener_t::create_wildcard_address (std::string &path_,
 
 zmq::ipc_listener_t::ipc_listener_t (io_thread_t *io_thread_,
                                      socket_base_t *socket_,
-                                     const options_t &options_) :
+                                     const options_t &options_,
+                                     const std::string &protocol_) :
     own_t (io_thread_, options_),
     io_object_t (io_thread_),
     has_file (false),
     s (retired_fd),
-    socket (socket_)
+    socket (socket_),
+    protocol (protocol_)
 {
 }
 
@@ -171,9 +175,25 @@ void zmq::ipc_listener_t::in_event ()
     }
 
     //  Create the engine object for this connection.
-    stream_engine_t *engine =
-      new (std::nothrow) stream_engine_t (fd, options, endpoint);
-    alloc_assert (engine);
+    stream_engine_t *engine;
+#if defined HAVE_MEMFD_CREATE
+    if (protocol == "shm") {
+        shm_engine_t *shm_engine =
+          new (std::nothrow) shm_engine_t (fd, options, endpoint);
+        alloc_assert (shm_engine);
+        if (shm_engine->init () != 0) {
+            //  The engine owns the connection and closes it.
+            socket->event_accept_failed (endpoint, zmq_errno ());
+            LIBZMQ_DELETE (shm_engine);
+            return;
+        }
+        engine = shm_engine;
+    } else
+#endif
+    {
+        engine = new (std::nothrow) stream_engine_t (fd, options, endpoint);
+        alloc_assert (engine);
+    }
 
     //  Choose I/O thread to run connecter in. Given that we are already
     //  running in an I/O thread, there must be at least one available.
@@ -205,7 +225,7 @@ int zmq::ipc_listener_t::get_address (std::string &addr_)
     }
 
     ipc_address_t addr ((struct sockaddr *) &ss, sl);
-    return addr.to_string (addr_);
+    return addr.to_string (addr_, protocol.c_str ());
 }
 
 int zmq::ipc_listener_t::set_address (const char *addr_)
@@ -244,7 +264,7 @@ int zmq::ipc_listener_t::set_address (const char *addr_)
         return -1;
     }
 
-    address.to_string (endpoint);
+    address.to_string (endpoint, protocol.c_str ());
 
     if (options.use_fd != -1) {
         s = options.use_fd;
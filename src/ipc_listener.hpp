@@ -47,9 +47,12 @@ class socket_base_t;
 class ipc_listener_t : public own_t, public io_object_t
 {
   public:
+    //  The protocol is either "ipc" or "shm"; the latter runs the
+    //  connections over shared memory rings.
     ipc_listener_t (zmq::io_thread_t *io_thread_,
                     zmq::socket_base_t *socket_,
-                    const options_t &options_);
+                    const options_t &options_,
+                    const std::string &protocol_);
     ~ipc_listener_t ();
 
     //  Set address to listen on.
@@ -105,6 +108,9 @@ class ipc_listener_t : public own_t, public io_object_t
     // String representation of endpoint to bind to
     std::string endpoint;
 
+    //  Transport the listener was bound with.
+    const std::string protocol;
+
     // Acceptable temporary directory environment variables
     static const char *tmp_env_vars[];
 
@@ -200,6 +200,7 @@ void zmq::kqueue_t::loop ()
             errno_assert (errno == EINTR);
             continue;
         }
+        const uint64_t start = clock_t::now_us ();
 
         for (int i = 0; i < n; i++) {
             poll_entry_t *pe = (poll_entry_t *) ev_buf[i].udata;
@@ -224,6 +225,8 @@ void zmq::kqueue_t::loop ()
             LIBZMQ_DELETE (*it);
         }
         retired.clear ();
+
+        account_busy (start);
     }
 }
 
@@ -100,6 +100,18 @@ int zmq::mailbox_t::recv (command_t *cmd_, int timeout_)
     return 0;
 }
 
+bool zmq::mailbox_t::check_read ()
+{
+    //  In passive state a successful check means a sender has flushed
+    //  commands and its signal is either pending or about to be sent.
+    if (cpipe.check_read ())
+        return true;
+
+    //  The failed check has switched the pipe into passive state.
+    active = false;
+    return false;
+}
+
 bool zmq::mailbox_t::valid () const
 {
     return signaler.valid ();
@@ -52,6 +52,11 @@ class mailbox_t : public i_mailbox
     void send (const command_t &cmd_);
     int recv (command_t *cmd_, int timeout_);
 
+    //  Returns true if a command may be available for reading. Unlike
+    //  recv with zero timeout, this never enters the kernel, so it is
+    //  cheap enough to be called in a busy loop.
+    bool check_read ();
+
     bool valid () const;
 
 #ifdef HAVE_FORK
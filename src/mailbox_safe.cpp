@@ -31,36 +31,54 @@
 #include "mailbox_safe.hpp"
 #include "clock.hpp"
 #include "err.hpp"
+#include "macros.hpp"
 
-zmq::mailbox_safe_t::mailbox_safe_t (mutex_t *sync_) : sync (sync_)
+zmq::mailbox_safe_t::mailbox_safe_t (mutex_t *sync_) :
+    head (new (std::nothrow) node_t),
+    sync (sync_)
 {
-    //  Get the pipe into passive state. That way, if the users starts by
-    //  polling on the associated file descriptor it will get woken up when
-    //  new command is posted.
-    const bool ok = cpipe.read (NULL);
-    zmq_assert (!ok);
+    alloc_assert (head);
+    head->next.set (NULL);
+    tail.set (head);
+
+    //  Start in the waiting state. That way, if the user starts by polling
+    //  on the associated signalers they will get woken up when a new
+    //  command is posted.
+    waiting.set (head);
 }
 
 zmq::mailbox_safe_t::~mailbox_safe_t ()
 {
-    //  TODO: Retrieve and deallocate commands inside the cpipe.
+    //  Other threads might still be in our send() method, past the point
+    //  where the command became visible to us. Wait for them to leave.
+    while (senders.add (0) != 0)
+        ;
+
+    //  Deallocate the commands nobody has read.
+    while (head) {
+        node_t *next = head->next.xchg (NULL);
+        delete head;
+        head = next;
+    }
+    for (int i = 0; i != mailbox_spare_nodes; i++)
+        delete spare_nodes[i].xchg (NULL);
 
-    // Work around problem that other threads might still be in our
-    // send() method, by waiting on the mutex before disappearing.
-    sync->lock ();
-    sync->unlock ();
+    for (std::vector<signaler_t *>::iterator it = idle_waiters.begin ();
+         it != idle_waiters.end (); ++it)
+        LIBZMQ_DELETE (*it);
 }
 
 void zmq::mailbox_safe_t::add_signaler (signaler_t *signaler)
 {
+    scoped_lock_t lock (signalers_sync);
     signalers.push_back (signaler);
 }
 
 void zmq::mailbox_safe_t::remove_signaler (signaler_t *signaler)
 {
+    scoped_lock_t lock (signalers_sync);
     std::vector<signaler_t *>::iterator it = signalers.begin ();
 
-    // TODO: make a copy of array and signal outside the lock
     for (; it != signalers.end (); ++it) {
         if (*it == signaler)
             break;
@@ -72,43 +90,135 @@ void zmq::mailbox_safe_t::remove_signaler (signaler_t *signaler)
 
 void zmq::mailbox_safe_t::clear_signalers ()
 {
+    scoped_lock_t lock (signalers_sync);
     signalers.clear ();
 }
 
 void zmq::mailbox_safe_t::send (const command_t &cmd_)
 {
-    sync->lock ();
-    cpipe.write (cmd_, false);
-    const bool ok = cpipe.flush ();
-
-    if (!ok) {
-        cond_var.broadcast ();
-        for (std::vector<signaler_t *>::iterator it = signalers.begin ();
-             it != signalers.end (); ++it) {
-            (*it)->send ();
-        }
+    senders.add (1);
+
+    node_t *node = alloc_node ();
+    node->next.set (NULL);
+    node->cmd = cmd_;
+
+    //  Append the node. Until the previous tail is linked to it the
+    //  receiver sees the list as ending at the previous tail; it will
+    //  have marked itself waiting by then and we wake it up below.
+    node_t *prev = tail.xchg (node);
+    prev->next.xchg (node);
+
+    if (waiting.xchg (NULL))
+        wake ();
+
+    senders.sub (1);
+}
+
+void zmq::mailbox_safe_t::wake ()
+{
+    scoped_lock_t lock (signalers_sync);
+    for (std::vector<signaler_t *>::iterator it = signalers.begin ();
+         it != signalers.end (); ++it) {
+        (*it)->send ();
     }
+}
 
-    sync->unlock ();
+zmq::mailbox_safe_t::node_t *zmq::mailbox_safe_t::alloc_node ()
+{
+    for (int i = 0; i != mailbox_spare_nodes; i++) {
+        node_t *node = spare_nodes[i].xchg (NULL);
+        if (node)
+            return node;
+    }
+
+    node_t *node = new (std::nothrow) node_t;
+    alloc_assert (node);
+    return node;
+}
+
+void zmq::mailbox_safe_t::free_node (node_t *node_)
+{
+    for (int i = 0; i != mailbox_spare_nodes; i++)
+        if (!spare_nodes[i].cas (NULL, node_))
+            return;
+
+    delete node_;
+}
+
+bool zmq::mailbox_safe_t::pop (command_t *cmd_)
+{
+    node_t *next = head->next.cas (NULL, NULL);
+    if (!next)
+        return false;
+
+    //  The node read becomes the new head; its command is no longer needed.
+    free_node (head);
+    head = next;
+    *cmd_ = head->cmd;
+    return true;
+}
+
+bool zmq::mailbox_safe_t::read (command_t *cmd_)
+{
+    if (pop (cmd_))
+        return true;
+
+    //  Mark ourselves waiting before checking once more, so that a command
+    //  sent in between either is seen here or wakes us up.
+    waiting.xchg (head);
+    if (!pop (cmd_))
+        return false;
+
+    waiting.xchg (NULL);
+    return true;
 }
 
 int zmq::mailbox_safe_t::recv (command_t *cmd_, int timeout_)
 {
     //  Try to get the command straight away.
-    if (cpipe.read (cmd_))
+    if (read (cmd_))
         return 0;
 
-    //  Wait for signal from the command sender.
-    int rc = cond_var.wait (sync, timeout_);
+    if (timeout_ == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    //  Wait for a signal from the command sender on a signaler of our own,
+    //  so that concurrent waiters are all woken up.
+    signaler_t *waiter;
+    if (idle_waiters.empty ()) {
+        waiter = new (std::nothrow) signaler_t;
+        alloc_assert (waiter);
+    } else {
+        waiter = idle_waiters.back ();
+        idle_waiters.pop_back ();
+    }
+    add_signaler (waiter);
+
+    //  A command may have arrived before the signaler was added.
+    if (read (cmd_)) {
+        remove_signaler (waiter);
+        idle_waiters.push_back (waiter);
+        return 0;
+    }
+
+    sync->unlock ();
+    int rc = waiter->wait (timeout_);
+    sync->lock ();
+
+    remove_signaler (waiter);
+    while (waiter->recv_failable () == 0)
+        ;
+    idle_waiters.push_back (waiter);
+
     if (rc == -1) {
         errno_assert (errno == EAGAIN || errno == EINTR);
         return -1;
     }
 
     //  Another thread may already fetch the command
-    const bool ok = cpipe.read (cmd_);
-
-    if (!ok) {
+    if (!read (cmd_)) {
         errno = EAGAIN;
         return -1;
     }
@@ -37,10 +37,10 @@
 #include "fd.hpp"
 #include "config.hpp"
 #include "command.hpp"
-#include "ypipe.hpp"
+#include "atomic_ptr.hpp"
+#include "atomic_counter.hpp"
 #include "mutex.hpp"
 #include "i_mailbox.hpp"
-#include "condition_variable.hpp"
 
 namespace zmq
 {
@@ -64,22 +64,65 @@ class mailbox_safe_t : public i_mailbox
     // with the context in the parent process.
     void forked ()
     {
-        // TODO: call fork on the condition variable
+        for (std::vector<signaler_t *>::iterator it = idle_waiters.begin ();
+             it != idle_waiters.end (); ++it)
+            (*it)->forked ();
     }
 #endif
 
   private:
-    //  The pipe to store actual commands.
-    typedef ypipe_t<command_t, command_pipe_granularity> cpipe_t;
-    cpipe_t cpipe;
+    //  Commands are kept in a linked list of nodes. Senders append nodes
+    //  to the tail without locking; the receiver takes them from the head,
+    //  which is the node of the command read last.
+    struct node_t
+    {
+        atomic_ptr_t<node_t> next;
+        command_t cmd;
+    };
+
+    //  Takes the next command from the list. If there is none, marks the
+    //  receiver as waiting so that the next sender wakes it up.
+    bool read (command_t *cmd_);
+    bool pop (command_t *cmd_);
+
+    //  Wakes up the threads waiting for commands and the pollers.
+    void wake ();
+
+    //  Take nodes from and give nodes back to the spares, falling back
+    //  to the heap when there are none or too many of them.
+    node_t *alloc_node ();
+    void free_node (node_t *node_);
+
+    //  Accessed by the receiver only.
+    node_t *head;
 
-    //  Condition variable to pass signals from writer thread to reader thread.
-    condition_variable_t cond_var;
+    //  Last node in the list, swapped in by the senders.
+    atomic_ptr_t<node_t> tail;
 
-    //  Synchronize access to the mailbox from receivers and senders
+    //  Points to the head while the receiver waits for commands, NULL
+    //  otherwise. The sender finding it set wakes the receiver up.
+    atomic_ptr_t<node_t> waiting;
+
+    //  Nodes of commands already read, for reuse by the senders. A slot
+    //  is owned by whoever swaps the node out of it.
+    atomic_ptr_t<node_t> spare_nodes[mailbox_spare_nodes];
+
+    //  Number of threads currently in send.
+    atomic_counter_t senders;
+
+    //  Synchronises the receivers, i.e. the threads using the socket.
+    //  Released while waiting for commands.
     mutex_t *const sync;
 
+    //  Signalers of the pollers and of the threads waiting for commands,
+    //  and the synchronisation of the senders waking them up with threads
+    //  adding and removing them.
     std::vector<zmq::signaler_t *> signalers;
+    mutex_t signalers_sync;
+
+    //  Signalers of threads that waited for commands before, for reuse.
+    //  Accessed with sync locked.
+    std::vector<zmq::signaler_t *> idle_waiters;
 
     //  Disable copying of mailbox_t object.
     mailbox_safe_t (const mailbox_safe_t &);
@@ -39,6 +39,7 @@
 #include "likely.hpp"
 #include "metadata.hpp"
 #include "err.hpp"
+#include "msg_pool.hpp"
 
 //  Check whether the sizes of public representation of the message (zmq_msg_t)
 //  and private representation of the message (zmq::msg_t) match.
@@ -74,6 +75,7 @@ int zmq::msg_t::init (
 int zmq::msg_t::init ()
 {
     u.vsm.metadata = NULL;
+    clear_stamp ();
     u.vsm.type = type_vsm;
     u.vsm.flags = 0;
     u.vsm.size = 0;
@@ -86,6 +88,7 @@ int zmq::msg_t::init_size (size_t size_)
 {
     if (size_ <= max_vsm_size) {
         u.vsm.metadata = NULL;
+        clear_stamp ();
         u.vsm.type = type_vsm;
         u.vsm.flags = 0;
         u.vsm.size = (unsigned char) size_;
@@ -93,13 +96,16 @@ int zmq::msg_t::init_size (size_t size_)
         u.vsm.routing_id = 0;
     } else {
         u.lmsg.metadata = NULL;
+        clear_stamp ();
         u.lmsg.type = type_lmsg;
         u.lmsg.flags = 0;
         u.lmsg.group[0] = '\0';
         u.lmsg.routing_id = 0;
         u.lmsg.content = NULL;
+        unsigned char pool_class = msg_pool_t::no_class;
         if (sizeof (content_t) + size_ > size_)
-            u.lmsg.content = (content_t *) malloc (sizeof (content_t) + size_);
+            u.lmsg.content = (content_t *) msg_pool_t::allocate (
+              sizeof (content_t) + size_, &pool_class);
         if (unlikely (!u.lmsg.content)) {
             errno = ENOMEM;
             return -1;
@@ -110,6 +116,7 @@ int zmq::msg_t::init_size (size_t size_)
         u.lmsg.content->ffn = NULL;
         u.lmsg.content->hint = NULL;
         new (&u.lmsg.content->refcnt) zmq::atomic_counter_t ();
+        u.lmsg.content->pool_class = pool_class;
     }
     return 0;
 }
@@ -124,6 +131,7 @@ int zmq::msg_t::init_external_storage (content_t *content_,
     zmq_assert (NULL != content_);
 
     u.zclmsg.metadata = NULL;
+    clear_stamp ();
     u.zclmsg.type = type_zclmsg;
     u.zclmsg.flags = 0;
     u.zclmsg.group[0] = '\0';
@@ -151,6 +159,7 @@ int zmq::msg_t::init_data (void *data_,
     //  Initialize constant message if there's no need to deallocate
     if (ffn_ == NULL) {
         u.cmsg.metadata = NULL;
+        clear_stamp ();
         u.cmsg.type = type_cmsg;
         u.cmsg.flags = 0;
         u.cmsg.data = data_;
@@ -159,11 +168,14 @@ int zmq::msg_t::init_data (void *data_,
         u.cmsg.routing_id = 0;
     } else {
         u.lmsg.metadata = NULL;
+        clear_stamp ();
         u.lmsg.type = type_lmsg;
         u.lmsg.flags = 0;
         u.lmsg.group[0] = '\0';
         u.lmsg.routing_id = 0;
-        u.lmsg.content = (content_t *) malloc (sizeof (content_t));
+        unsigned char pool_class;
+        u.lmsg.content = (content_t *) msg_pool_t::allocate (
+          sizeof (content_t), &pool_class);
         if (!u.lmsg.content) {
             errno = ENOMEM;
             return -1;
@@ -174,6 +186,7 @@ int zmq::msg_t::init_data (void *data_,
         u.lmsg.content->ffn = ffn_;
         u.lmsg.content->hint = hint_;
         new (&u.lmsg.content->refcnt) zmq::atomic_counter_t ();
+        u.lmsg.content->pool_class = pool_class;
     }
     return 0;
 }
@@ -181,6 +194,7 @@ int zmq::msg_t::init_data (void *data_,
 int zmq::msg_t::init_delimiter ()
 {
     u.delimiter.metadata = NULL;
+    clear_stamp ();
     u.delimiter.type = type_delimiter;
     u.delimiter.flags = 0;
     u.delimiter.group[0] = '\0';
@@ -191,6 +205,7 @@ int zmq::msg_t::init_delimiter ()
 int zmq::msg_t::init_join ()
 {
     u.base.metadata = NULL;
+    clear_stamp ();
     u.base.type = type_join;
     u.base.flags = 0;
     u.base.group[0] = '\0';
@@ -201,6 +216,7 @@ int zmq::msg_t::init_join ()
 int zmq::msg_t::init_leave ()
 {
     u.base.metadata = NULL;
+    clear_stamp ();
     u.base.type = type_leave;
     u.base.flags = 0;
     u.base.group[0] = '\0';
@@ -228,7 +244,8 @@ int zmq::msg_t::close ()
             if (u.lmsg.content->ffn)
                 u.lmsg.content->ffn (u.lmsg.content->data,
                                      u.lmsg.content->hint);
-            free (u.lmsg.content);
+            msg_pool_t::deallocate (u.lmsg.content,
+                                    u.lmsg.content->pool_class);
         }
     }
 
@@ -490,7 +507,7 @@ bool zmq::msg_t::rm_refs (int refs_)
 
         if (u.lmsg.content->ffn)
             u.lmsg.content->ffn (u.lmsg.content->data, u.lmsg.content->hint);
-        free (u.lmsg.content);
+        msg_pool_t::deallocate (u.lmsg.content, u.lmsg.content->pool_class);
 
         return false;
     }
@@ -68,6 +68,10 @@ class msg_t
         msg_free_fn *ffn;
         void *hint;
         zmq::atomic_counter_t refcnt;
+
+        //  Size class of the message pool the structure was allocated
+        //  from. Only meaningful for long messages.
+        unsigned char pool_class;
     };
 
     //  Message flags.
@@ -133,6 +137,23 @@ class msg_t
     //  references drops to 0, the message is closed and false is returned.
     bool rm_refs (int refs_);
 
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    //  Time (in nanoseconds) the message passed the last instrumentation
+    //  point, or 0 if the message is not being timed.
+    uint64_t stamp () const;
+    void set_stamp (uint64_t stamp_);
+#endif
+
+    //  Size in bytes of the latency timestamp carried by every message.
+    enum
+    {
+#ifdef ZMQ_BUILD_LATENCY_STATS
+        stamp_size = sizeof (uint64_t)
+#else
+        stamp_size = 0
+#endif
+    };
+
     //  Size in bytes of the largest message that is still copied around
     //  rather than being reference-counted.
     enum
@@ -141,13 +162,18 @@ class msg_t
     };
     enum
     {
-        max_vsm_size =
-          msg_t_size - (sizeof (metadata_t *) + 3 + 16 + sizeof (uint32_t))
+        max_vsm_size = msg_t_size
+                       - (sizeof (metadata_t *) + stamp_size + 3 + 16
+                          + sizeof (uint32_t))
     };
 
   private:
     zmq::atomic_counter_t *refcnt ();
 
+    //  Marks the message as not being timed. No-op unless built with
+    //  ZMQ_BUILD_LATENCY_STATS.
+    void clear_stamp ();
+
     //  Different message types.
     enum type_t
     {
@@ -182,9 +208,13 @@ class msg_t
         struct
         {
             metadata_t *metadata;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+            uint64_t stamp;
+#endif
             unsigned char
               unused[msg_t_size
-                     - (sizeof (metadata_t *) + 2 + 16 + sizeof (uint32_t))];
+                     - (sizeof (metadata_t *) + stamp_size + 2 + 16
+                        + sizeof (uint32_t))];
             unsigned char type;
             unsigned char flags;
             char group[16];
@@ -193,6 +223,9 @@ class msg_t
         struct
         {
             metadata_t *metadata;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+            uint64_t stamp;
+#endif
             unsigned char data[max_vsm_size];
             unsigned char size;
             unsigned char type;
@@ -203,10 +236,14 @@ class msg_t
         struct
         {
             metadata_t *metadata;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+            uint64_t stamp;
+#endif
             content_t *content;
             unsigned char unused[msg_t_size
-                                 - (sizeof (metadata_t *) + sizeof (content_t *)
-                                    + 2 + 16 + sizeof (uint32_t))];
+                                 - (sizeof (metadata_t *) + stamp_size
+                                    + sizeof (content_t *) + 2 + 16
+                                    + sizeof (uint32_t))];
             unsigned char type;
             unsigned char flags;
             char group[16];
@@ -215,10 +252,14 @@ class msg_t
         struct
         {
             metadata_t *metadata;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+            uint64_t stamp;
+#endif
             content_t *content;
             unsigned char unused[msg_t_size
-                                 - (sizeof (metadata_t *) + sizeof (content_t *)
-                                    + 2 + 16 + sizeof (uint32_t))];
+                                 - (sizeof (metadata_t *) + stamp_size
+                                    + sizeof (content_t *) + 2 + 16
+                                    + sizeof (uint32_t))];
             unsigned char type;
             unsigned char flags;
             char group[16];
@@ -227,11 +268,14 @@ class msg_t
         struct
         {
             metadata_t *metadata;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+            uint64_t stamp;
+#endif
             void *data;
             size_t size;
             unsigned char
               unused[msg_t_size
-                     - (sizeof (metadata_t *) + sizeof (void *)
+                     - (sizeof (metadata_t *) + stamp_size + sizeof (void *)
                         + sizeof (size_t) + 2 + 16 + sizeof (uint32_t))];
             unsigned char type;
             unsigned char flags;
@@ -241,9 +285,13 @@ class msg_t
         struct
         {
             metadata_t *metadata;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+            uint64_t stamp;
+#endif
             unsigned char
               unused[msg_t_size
-                     - (sizeof (metadata_t *) + 2 + 16 + sizeof (uint32_t))];
+                     - (sizeof (metadata_t *) + stamp_size + 2 + 16
+                        + sizeof (uint32_t))];
             unsigned char type;
             unsigned char flags;
             char group[16];
@@ -252,6 +300,25 @@ class msg_t
     } u;
 };
 
+inline void msg_t::clear_stamp ()
+{
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    u.base.stamp = 0;
+#endif
+}
+
+#ifdef ZMQ_BUILD_LATENCY_STATS
+inline uint64_t msg_t::stamp () const
+{
+    return u.base.stamp;
+}
+
+inline void msg_t::set_stamp (uint64_t stamp_)
+{
+    u.base.stamp = stamp_;
+}
+#endif
+
 inline int close_and_return (zmq::msg_t *msg, int echo)
 {
     // Since we abort on close failure we preserve errno for success case.
@@ -0,0 +1,219 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "precompiled.hpp"
+#include "msg_pool.hpp"
+#include "atomic_counter.hpp"
+#include "atomic_ptr.hpp"
+#include "config.hpp"
+#include "err.hpp"
+
+#include <stdlib.h>
+
+//  Thread caches require thread-local storage with destructors.
+#if (defined __cplusplus && __cplusplus >= 201103L)                            \
+  || (defined _MSC_VER && _MSC_VER >= 1900)
+#define ZMQ_MSG_POOL_THREAD_CACHE
+#endif
+
+namespace
+{
+//  Free blocks are linked through their first word.
+struct block_t
+{
+    block_t *next;
+};
+
+enum
+{
+    min_block_size = 64,
+
+    //  Size classes from min_block_size up to msg_pool_max_size.
+    class_count = 8
+};
+
+//  Blocks handed back by threads whose caches are full.
+zmq::atomic_ptr_t<block_t> shared_lists[class_count];
+
+//  Number of blocks on the shared lists. Raised before blocks are pushed
+//  and lowered after they are taken, so it never falls below the actual
+//  number.
+zmq::atomic_counter_t shared_counts[class_count];
+
+zmq::atomic_value_t pool_enabled (0);
+
+unsigned char size_class (size_t size_)
+{
+    unsigned char pool_class = 0;
+    for (size_t block_size = min_block_size; block_size < size_;
+         block_size <<= 1)
+        pool_class++;
+    return pool_class;
+}
+
+//  Pushes the block onto the shared list, or frees it if the list is full.
+void push_shared (unsigned char pool_class_, block_t *block_)
+{
+    const zmq::atomic_counter_t::integer_t capacity =
+      zmq::msg_pool_shared_max_size / ((size_t) min_block_size << pool_class_);
+    if (shared_counts[pool_class_].add (1) >= capacity) {
+        shared_counts[pool_class_].sub (1);
+        free (block_);
+        return;
+    }
+
+    block_t *head = NULL;
+    while (true) {
+        block_->next = head;
+        block_t *old = shared_lists[pool_class_].cas (head, block_);
+        if (old == head)
+            break;
+        head = old;
+    }
+}
+
+#if defined ZMQ_MSG_POOL_THREAD_CACHE
+struct cache_t
+{
+    block_t *blocks[class_count];
+    int counts[class_count];
+
+    //  Set once the cache is flushed at thread exit. Blocks freed after
+    //  that go straight to the shared lists.
+    bool closed;
+};
+
+//  Trivially destructible, so that it stays usable while other thread
+//  local objects are destroyed.
+thread_local cache_t cache;
+
+struct cache_flusher_t
+{
+    cache_flusher_t () {}
+
+    ~cache_flusher_t ()
+    {
+        for (int i = 0; i != class_count; i++) {
+            block_t *block = cache.blocks[i];
+            while (block) {
+                block_t *next = block->next;
+                push_shared ((unsigned char) i, block);
+                block = next;
+            }
+            cache.blocks[i] = NULL;
+            cache.counts[i] = 0;
+        }
+        cache.closed = true;
+    }
+};
+
+thread_local cache_flusher_t cache_flusher;
+
+cache_t *get_cache ()
+{
+    //  Referencing the flusher registers its destructor for this thread.
+    (void) &cache_flusher;
+    return cache.closed ? NULL : &cache;
+}
+#endif
+}
+
+void *zmq::msg_pool_t::allocate (size_t size_, unsigned char *pool_class_)
+{
+#if defined ZMQ_MSG_POOL_THREAD_CACHE
+    if (pool_enabled.load () && size_ <= msg_pool_max_size) {
+        const unsigned char pool_class = size_class (size_);
+        cache_t *c = get_cache ();
+        if (c) {
+            block_t *block = c->blocks[pool_class];
+            if (!block) {
+                //  Take over all the blocks other threads have handed back.
+                block = shared_lists[pool_class].xchg (NULL);
+                int taken = 0;
+                for (block_t *b = block; b; b = b->next)
+                    taken++;
+                if (taken)
+                    shared_counts[pool_class].sub (taken);
+                c->counts[pool_class] += taken;
+            }
+            if (block) {
+                c->blocks[pool_class] = block->next;
+                c->counts[pool_class]--;
+                *pool_class_ = pool_class;
+                return block;
+            }
+        }
+        void *block = malloc ((size_t) min_block_size << pool_class);
+        *pool_class_ = pool_class;
+        return block;
+    }
+#endif
+    *pool_class_ = no_class;
+    return malloc (size_);
+}
+
+void zmq::msg_pool_t::deallocate (void *block_, unsigned char pool_class_)
+{
+    if (pool_class_ == no_class) {
+        free (block_);
+        return;
+    }
+
+    zmq_assert (pool_class_ < class_count);
+    block_t *block = (block_t *) block_;
+#if defined ZMQ_MSG_POOL_THREAD_CACHE
+    cache_t *c = get_cache ();
+    if (c && c->counts[pool_class_] < msg_pool_cache_size) {
+        block->next = c->blocks[pool_class_];
+        c->blocks[pool_class_] = block;
+        c->counts[pool_class_]++;
+        return;
+    }
+#endif
+    push_shared (pool_class_, block);
+}
+
+int zmq::msg_pool_t::set_enabled (bool enabled_)
+{
+#if defined ZMQ_MSG_POOL_THREAD_CACHE
+    pool_enabled.store (enabled_ ? 1 : 0);
+    return 0;
+#else
+    if (!enabled_)
+        return 0;
+    errno = EINVAL;
+    return -1;
+#endif
+}
+
+bool zmq::msg_pool_t::enabled ()
+{
+    return pool_enabled.load () != 0;
+}
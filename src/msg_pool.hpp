@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __ZMQ_MSG_POOL_HPP_INCLUDED__
+#define __ZMQ_MSG_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+namespace zmq
+{
+//  Size-classed allocator for the contents of long messages. Each thread
+//  allocates from and frees to its own cache of free blocks, without any
+//  synchronisation. As messages are typically freed by a thread other than
+//  the one that allocated them, caches overflowing on the freeing side
+//  hand blocks back through a lock-free list per size class, from which
+//  the allocating side refills. Blocks not fitting onto a full list are
+//  freed.
+//
+//  The pool is process-wide, as messages are not bound to a context.
+//  Blocks allocated while it was enabled are returned to it regardless of
+//  later changes of the setting.
+
+class msg_pool_t
+{
+  public:
+    //  Size class of blocks not allocated from the pool.
+    enum
+    {
+        no_class = 0xff
+    };
+
+    //  Allocates a block of at least size_ bytes. Stores the size class
+    //  to pass to deallocate in pool_class_. Returns NULL if there is no
+    //  memory available.
+    static void *allocate (size_t size_, unsigned char *pool_class_);
+
+    //  Returns a block obtained from allocate.
+    static void deallocate (void *block_, unsigned char pool_class_);
+
+    //  Switches pooling on or off for subsequent allocations. Returns -1
+    //  if the platform does not support pooling.
+    static int set_enabled (bool enabled_);
+    static bool enabled ();
+};
+}
+
+#endif
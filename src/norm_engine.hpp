@@ -46,6 +46,9 @@ class norm_engine_t : public io_object_t, public i_engine
 
     virtual void zap_msg_available (){};
 
+    virtual bool suspend () { return false; }
+    virtual void resume (zmq::io_thread_t *) {}
+
     virtual const char *get_endpoint () const;
 
     // i_poll_events interface implementation.
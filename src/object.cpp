@@ -39,13 +39,17 @@
 #include "session_base.hpp"
 #include "socket_base.hpp"
 
-zmq::object_t::object_t (ctx_t *ctx_, uint32_t tid_) : ctx (ctx_), tid (tid_)
+zmq::object_t::object_t (ctx_t *ctx_, uint32_t tid_) :
+    ctx (ctx_),
+    tid (tid_),
+    runner_tid (NULL)
 {
 }
 
 zmq::object_t::object_t (object_t *parent_) :
     ctx (parent_->ctx),
-    tid (parent_->tid)
+    tid (parent_->tid),
+    runner_tid (parent_->runner_tid)
 {
 }
 
@@ -63,6 +67,23 @@ void zmq::object_t::set_tid (uint32_t id)
     tid = id;
 }
 
+uint32_t zmq::object_t::get_runner_tid ()
+{
+    return runner_tid ? *runner_tid : tid;
+}
+
+void zmq::object_t::set_runner_tid (uint32_t tid_)
+{
+    if (runner_tid)
+        *runner_tid = tid_;
+}
+
+void zmq::object_t::set_migratable (uint32_t *runner_tid_)
+{
+    runner_tid = runner_tid_;
+    *runner_tid = tid;
+}
+
 zmq::ctx_t *zmq::object_t::get_ctx ()
 {
     return ctx;
@@ -148,6 +169,19 @@ void zmq::object_t::process_command (command_t &cmd_)
             process_seqnum ();
             break;
 
+        case command_t::migrate:
+            process_migrate (cmd_.args.migrate.affinity);
+            break;
+
+        case command_t::reroute:
+            process_reroute (cmd_.args.reroute.object,
+                             cmd_.args.reroute.io_thread);
+            break;
+
+        case command_t::adopt:
+            process_adopt ();
+            break;
+
         case command_t::done:
         default:
             zmq_assert (false);
@@ -382,6 +416,27 @@ void zmq::object_t::send_done ()
     ctx->send_command (ctx_t::term_tid, cmd);
 }
 
+void zmq::object_t::send_migrate (own_t *destination_, uint64_t affinity_)
+{
+    command_t cmd;
+    cmd.destination = destination_;
+    cmd.type = command_t::migrate;
+    cmd.args.migrate.affinity = affinity_;
+    send_command (cmd);
+}
+
+void zmq::object_t::send_reroute (io_thread_t *destination_,
+                                  object_t *object_,
+                                  io_thread_t *io_thread_)
+{
+    command_t cmd;
+    cmd.destination = destination_;
+    cmd.type = command_t::reroute;
+    cmd.args.reroute.object = object_;
+    cmd.args.reroute.io_thread = io_thread_;
+    send_command (cmd);
+}
+
 void zmq::object_t::process_stop ()
 {
     zmq_assert (false);
@@ -467,6 +522,21 @@ void zmq::object_t::process_reaped ()
     zmq_assert (false);
 }
 
+void zmq::object_t::process_migrate (uint64_t)
+{
+    zmq_assert (false);
+}
+
+void zmq::object_t::process_reroute (object_t *, io_thread_t *)
+{
+    zmq_assert (false);
+}
+
+void zmq::object_t::process_adopt ()
+{
+    zmq_assert (false);
+}
+
 void zmq::object_t::process_seqnum ()
 {
     zmq_assert (false);
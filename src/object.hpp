@@ -58,6 +58,22 @@ class object_t
 
     uint32_t get_tid ();
     void set_tid (uint32_t id);
+
+    //  Returns the ID of the thread processing the commands sent to the
+    //  object. This is the thread the object belongs to, unless the object
+    //  has been migrated to another I/O thread. The thread the object
+    //  belongs to then forwards the commands to it. Objects that cannot be
+    //  migrated ignore set_runner_tid.
+    uint32_t get_runner_tid ();
+    void set_runner_tid (uint32_t tid_);
+
+    //  Runner ID of objects on their way to another I/O thread. Commands
+    //  for them are held back until they have arrived.
+    enum
+    {
+        migrating_tid = 0xffffffff
+    };
+
     ctx_t *get_ctx ();
     void process_command (zmq::command_t &cmd_);
     void send_inproc_connected (zmq::socket_base_t *socket_);
@@ -66,6 +82,12 @@ class object_t
                     bool inc_seqnum_ = true);
 
   protected:
+    //  Allows the object to be migrated to another I/O thread. The object
+    //  stores the ID of the thread processing its commands in runner_tid_.
+    //  Objects created with it as their parent, e.g. its pipes, share this
+    //  and thus migrate along with it.
+    void set_migratable (uint32_t *runner_tid_);
+
     //  Using following function, socket is able to access global
     //  repository of inproc endpoints.
     int register_endpoint (const char *addr_, const zmq::endpoint_t &endpoint_);
@@ -106,6 +128,10 @@ class object_t
     void send_reap (zmq::socket_base_t *socket_);
     void send_reaped ();
     void send_done ();
+    void send_migrate (zmq::own_t *destination_, uint64_t affinity_);
+    void send_reroute (zmq::io_thread_t *destination_,
+                       zmq::object_t *object_,
+                       zmq::io_thread_t *io_thread_);
 
     //  These handlers can be overridden by the derived objects. They are
     //  called when command arrives from another thread.
@@ -126,6 +152,10 @@ class object_t
     virtual void process_term_endpoint (std::string *endpoint_);
     virtual void process_reap (zmq::socket_base_t *socket_);
     virtual void process_reaped ();
+    virtual void process_migrate (uint64_t affinity_);
+    virtual void process_reroute (zmq::object_t *object_,
+                                  zmq::io_thread_t *io_thread_);
+    virtual void process_adopt ();
 
     //  Special handler called after a command that requires a seqnum
     //  was processed. The implementation should catch up with its counter
@@ -139,6 +169,11 @@ class object_t
     //  Thread ID of the thread the object belongs to.
     uint32_t tid;
 
+    //  ID of the thread processing the commands for a migratable object,
+    //  shared with the objects created with it as their parent. NULL if
+    //  the object cannot be migrated.
+    uint32_t *runner_tid;
+
     void send_command (command_t &cmd_);
 
     object_t (const object_t &);
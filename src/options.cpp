@@ -31,6 +31,7 @@
 #include <string.h>
 
 #include "options.hpp"
+#include "config.hpp"
 #include "err.hpp"
 #include "macros.hpp"
 
@@ -91,7 +92,13 @@ zmq::options_t::options_t () :
     heartbeat_timeout (-1),
     use_fd (-1),
     zap_enforce_domain (false),
-    loopback_fastpath (false)
+    loopback_fastpath (false),
+    tcp_zerocopy_threshold (0),
+    busy_poll_us (0),
+    in_batch_size (zmq::in_batch_size),
+    out_batch_size (zmq::out_batch_size),
+    adaptive_batch_size (false),
+    adaptive_poll_rate (false)
 {
     memset (curve_public_key, 0, CURVE_KEYSIZE);
     memset (curve_secret_key, 0, CURVE_KEYSIZE);
@@ -635,6 +642,50 @@ int zmq::options_t::setsockopt (int option_,
             }
             break;
 
+        case ZMQ_TCP_ZEROCOPY_THRESHOLD:
+            if (is_int && value >= 0) {
+                tcp_zerocopy_threshold = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_BUSY_POLL_US:
+            if (is_int && value >= 0) {
+                busy_poll_us = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_IN_BATCH_SIZE:
+            if (is_int && value >= min_batch_size
+                && value <= max_batch_size) {
+                in_batch_size = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_OUT_BATCH_SIZE:
+            if (is_int && value >= min_batch_size
+                && value <= max_batch_size) {
+                out_batch_size = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ADAPTIVE_BATCH_SIZE:
+            if (is_int && (value == 0 || value == 1)) {
+                adaptive_batch_size = (value != 0);
+                return 0;
+            }
+            break;
+
+        case ZMQ_ADAPTIVE_POLL_RATE:
+            if (is_int && (value == 0 || value == 1)) {
+                adaptive_poll_rate = (value != 0);
+                return 0;
+            }
+            break;
+
 
         default:
 #if defined(ZMQ_ACT_MILITANT)
@@ -1079,6 +1130,48 @@ int zmq::options_t::getsockopt (int option_,
             }
             break;
 
+        case ZMQ_TCP_ZEROCOPY_THRESHOLD:
+            if (is_int) {
+                *value = tcp_zerocopy_threshold;
+                return 0;
+            }
+            break;
+
+        case ZMQ_BUSY_POLL_US:
+            if (is_int) {
+                *value = busy_poll_us;
+                return 0;
+            }
+            break;
+
+        case ZMQ_IN_BATCH_SIZE:
+            if (is_int) {
+                *value = in_batch_size;
+                return 0;
+            }
+            break;
+
+        case ZMQ_OUT_BATCH_SIZE:
+            if (is_int) {
+                *value = out_batch_size;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ADAPTIVE_BATCH_SIZE:
+            if (is_int) {
+                *value = adaptive_batch_size;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ADAPTIVE_POLL_RATE:
+            if (is_int) {
+                *value = adaptive_poll_rate;
+                return 0;
+            }
+            break;
+
         default:
 #if defined(ZMQ_ACT_MILITANT)
             malformed = false;
@@ -251,6 +251,25 @@ struct options_t
 
     // Use of loopback fastpath.
     bool loopback_fastpath;
+
+    //  Message parts at least this large are sent using zero-copy TCP
+    //  transmission, where supported. Zero disables zero-copy.
+    int tcp_zerocopy_threshold;
+
+    //  Time in microseconds a blocking receive spins before it sleeps.
+    int busy_poll_us;
+
+    //  Sizes of the buffers stream engines read into and encode into.
+    int in_batch_size;
+    int out_batch_size;
+
+    //  If true, stream engines grow their batches while the traffic fills
+    //  them and shrink them when it is sparse, up to the sizes above.
+    bool adaptive_batch_size;
+
+    //  If true, sockets check for commands more often while commands keep
+    //  arriving and less often while the mailbox stays empty.
+    bool adaptive_poll_rate;
 };
 }
 
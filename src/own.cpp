@@ -191,6 +191,12 @@ void zmq::own_t::process_term_ack ()
     unregister_term_ack ();
 }
 
+void zmq::own_t::process_migrate (uint64_t affinity_)
+{
+    for (owned_t::iterator it = owned.begin (); it != owned.end (); ++it)
+        send_migrate (*it, affinity_);
+}
+
 void zmq::own_t::check_term_acks ()
 {
     if (terminating && processed_seqnum == sent_seqnum.get ()
@@ -102,6 +102,10 @@ class own_t : public object_t
     //  is to be delayed.
     virtual void process_destroy ();
 
+    //  Passes a migration request on to the owned objects. Sessions
+    //  intercept it to migrate themselves.
+    void process_migrate (uint64_t affinity_);
+
     //  Socket options associated with this object.
     options_t options;
 
@@ -60,6 +60,8 @@ class pgm_receiver_t : public io_object_t, public i_engine
     void restart_input ();
     void restart_output ();
     void zap_msg_available () {}
+    bool suspend () { return false; }
+    void resume (zmq::io_thread_t *) {}
     const char *get_endpoint () const;
 
     //  i_poll_events interface implementation.
@@ -30,6 +30,7 @@
 #include "precompiled.hpp"
 #include <new>
 #include <stddef.h>
+#include <algorithm>
 
 #include "macros.hpp"
 #include "pipe.hpp"
@@ -38,6 +39,10 @@
 #include "ypipe.hpp"
 #include "ypipe_conflate.hpp"
 
+#ifdef ZMQ_BUILD_LATENCY_STATS
+#include "clock.hpp"
+#endif
+
 int zmq::pipepair (class object_t *parents_[2],
                    class pipe_t *pipes_[2],
                    int hwms_[2],
@@ -93,9 +98,15 @@ zmq::pipe_t::pipe_t (object_t *parent_,
     outhwmboost (-1),
     msgs_read (0),
     msgs_written (0),
+    bytes_read (0),
+    bytes_written (0),
+    hwm_drops (0),
     peers_msgs_read (0),
     peer (NULL),
     sink (NULL),
+    stats (NULL),
+    deferred_flushes (NULL),
+    in_deferred_flushes (false),
     state (active),
     delay (true),
     server_socket_routing_id (0),
@@ -121,6 +132,46 @@ void zmq::pipe_t::set_event_sink (i_pipe_events *sink_)
     sink = sink_;
 }
 
+void zmq::pipe_t::set_stats (socket_stats_t *stats_)
+{
+    stats = stats_;
+    if (stats)
+        stats->queue_depth.add (msgs_written - peers_msgs_read);
+}
+
+void zmq::pipe_t::set_deferred_flushes (
+  deferred_flushes_t *deferred_flushes_)
+{
+    deferred_flushes = deferred_flushes_;
+}
+
+void zmq::pipe_t::deferred_flush ()
+{
+    in_deferred_flushes = false;
+    flush ();
+}
+
+void zmq::pipe_t::count_hwm_drop ()
+{
+    hwm_drops++;
+    if (stats)
+        stats->hwm_drops.add (1);
+}
+
+void zmq::pipe_t::get_stats (stats_snapshot_t *stats_) const
+{
+    stats_->msgs_in = msgs_read;
+    stats_->bytes_in = bytes_read;
+    stats_->msgs_out = msgs_written;
+    stats_->bytes_out = bytes_written;
+    stats_->hwm_drops = hwm_drops;
+    stats_->eagains = 0;
+    stats_->reconnects = 0;
+    stats_->mutes = 0;
+    stats_->queue_depth = msgs_written - peers_msgs_read;
+    stats_->zerocopy_writes = 0;
+}
+
 void zmq::pipe_t::set_server_socket_routing_id (
   uint32_t server_socket_routing_id_)
 {
@@ -174,6 +225,15 @@ bool zmq::pipe_t::check_read ()
     return true;
 }
 
+//  Number of bytes of user data the message carries, zero for the
+//  RADIO/DISH group commands that have no body.
+static size_t payload_size (const zmq::msg_t *msg_)
+{
+    if (msg_->is_join () || msg_->is_leave ())
+        return 0;
+    return msg_->size ();
+}
+
 bool zmq::pipe_t::read (msg_t *msg_)
 {
     if (unlikely (!in_active))
@@ -203,8 +263,11 @@ read_message:
         return false;
     }
 
-    if (!(msg_->flags () & msg_t::more) && !msg_->is_routing_id ())
-        msgs_read++;
+    if (!msg_->is_routing_id ()) {
+        if (!(msg_->flags () & msg_t::more))
+            msgs_read++;
+        bytes_read += payload_size (msg_);
+    }
 
     if (lwm > 0 && msgs_read % lwm == 0)
         send_activate_write (peer, msgs_read);
@@ -234,9 +297,26 @@ bool zmq::pipe_t::write (msg_t *msg_)
 
     bool more = msg_->flags () & msg_t::more ? true : false;
     const bool is_routing_id = msg_->is_routing_id ();
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    //  Only the socket's end of a pipe has the statistics attached, so
+    //  the time spent in zmq_send is not mixed with session writes.
+    if (msg_->stamp ()) {
+        const uint64_t now = clock_t::now_ns ();
+        if (stats)
+            stats->latency[latency_send].record (now - msg_->stamp ());
+        msg_->set_stamp (now);
+    }
+#endif
+    const size_t size = payload_size (msg_);
     outpipe->write (*msg_, more);
-    if (!more && !is_routing_id)
-        msgs_written++;
+    if (!is_routing_id) {
+        if (!more) {
+            msgs_written++;
+            if (stats)
+                stats->queue_depth.add (1);
+        }
+        bytes_written += size;
+    }
 
     return true;
 }
@@ -248,6 +328,8 @@ void zmq::pipe_t::rollback ()
     if (outpipe) {
         while (outpipe->unwrite (&msg)) {
             zmq_assert (msg.flags () & msg_t::more);
+            if (!msg.is_routing_id ())
+                bytes_written -= payload_size (&msg);
             int rc = msg.close ();
             errno_assert (rc == 0);
         }
@@ -260,6 +342,17 @@ void zmq::pipe_t::flush ()
     if (state == term_ack_sent)
         return;
 
+    //  While the socket sends a batch, remember the pipe and flush it once
+    //  the batch is over. Terminating pipes are flushed straight away.
+    if (unlikely (deferred_flushes && deferred_flushes->active)
+        && state == active) {
+        if (!in_deferred_flushes) {
+            in_deferred_flushes = true;
+            deferred_flushes->pipes.push_back (this);
+        }
+        return;
+    }
+
     if (outpipe && !outpipe->flush ())
         send_activate_read (peer);
 }
@@ -275,6 +368,8 @@ void zmq::pipe_t::process_activate_read ()
 void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
 {
     //  Remember the peer's message sequence number.
+    if (stats)
+        stats->queue_depth.add (peers_msgs_read - msgs_read_);
     peers_msgs_read = msgs_read_;
 
     if (!out_active && state == active) {
@@ -291,8 +386,11 @@ void zmq::pipe_t::process_hiccup (void *pipe_)
     outpipe->flush ();
     msg_t msg;
     while (outpipe->read (&msg)) {
-        if (!(msg.flags () & msg_t::more))
+        if (!(msg.flags () & msg_t::more)) {
             msgs_written--;
+            if (stats)
+                stats->queue_depth.add (uint64_t (-1));
+        }
         int rc = msg.close ();
         errno_assert (rc == 0);
     }
@@ -352,6 +450,15 @@ void zmq::pipe_t::process_pipe_term_ack ()
     zmq_assert (sink);
     sink->pipe_terminated (this);
 
+    //  Whatever the peer has not read leaves the socket's queue.
+    if (stats)
+        stats->queue_depth.add (peers_msgs_read - msgs_written);
+
+    if (in_deferred_flushes) {
+        std::vector<pipe_t *> &pipes = deferred_flushes->pipes;
+        pipes.erase (std::find (pipes.begin (), pipes.end (), this));
+    }
+
     //  In term_ack_sent and term_req_sent2 states there's nothing to do.
     //  Simply deallocate the pipe. In term_req_sent1 state we have to ack
     //  the peer before deallocating this side of the pipe.
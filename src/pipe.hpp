@@ -37,6 +37,9 @@
 #include "stdint.hpp"
 #include "array.hpp"
 #include "blob.hpp"
+#include "socket_stats.hpp"
+
+#include <vector>
 
 namespace zmq
 {
@@ -56,6 +59,20 @@ int pipepair (zmq::object_t *parents_[2],
               int hwms_[2],
               bool conflate_[2]);
 
+//  Pipes whose flushes a socket defers while it sends a batch of
+//  messages (ZMQ_SNDBATCH). The readers are woken up once the batch is
+//  over rather than once per message.
+struct deferred_flushes_t
+{
+    deferred_flushes_t () : active (false) {}
+
+    //  True while flushes are being deferred.
+    bool active;
+
+    //  Pipes with messages written but not yet flushed.
+    std::vector<pipe_t *> pipes;
+};
+
 struct i_pipe_events
 {
     virtual ~i_pipe_events () {}
@@ -85,6 +102,23 @@ class pipe_t : public object_t,
     //  Specifies the object to send events to.
     void set_event_sink (i_pipe_events *sink_);
 
+    //  Specifies the statistics of the socket owning this end of the pipe.
+    void set_stats (socket_stats_t *stats_);
+
+    //  Accounts for a message dropped because the pipe was full.
+    void count_hwm_drop ();
+
+    //  Copies the traffic statistics of this end of the pipe.
+    void get_stats (stats_snapshot_t *stats_) const;
+
+    //  Specifies where the socket owning this end of the pipe collects
+    //  the flushes it defers.
+    void set_deferred_flushes (deferred_flushes_t *deferred_flushes_);
+
+    //  Flushes the messages written while flushes were deferred. Called by
+    //  the socket for each of the deferred pipes once the batch is over.
+    void deferred_flush ();
+
     //  Pipe endpoint can store an routing ID to be used by its clients.
     void set_server_socket_routing_id (uint32_t routing_id_);
     uint32_t get_server_socket_routing_id ();
@@ -196,6 +230,12 @@ class pipe_t : public object_t,
     uint64_t msgs_read;
     uint64_t msgs_written;
 
+    //  Number of bytes read and written so far, not counting routing ids,
+    //  and of messages dropped because the pipe was full.
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t hwm_drops;
+
     //  Last received peer's msgs_read. The actual number in the peer
     //  can be higher at the moment.
     uint64_t peers_msgs_read;
@@ -206,6 +246,14 @@ class pipe_t : public object_t,
     //  Sink to send events to.
     i_pipe_events *sink;
 
+    //  Statistics of the owning socket, if any.
+    socket_stats_t *stats;
+
+    //  Flushes deferred by the owning socket, if any, and whether this
+    //  pipe is among them.
+    deferred_flushes_t *deferred_flushes;
+    bool in_deferred_flushes;
+
     //  States of the pipe endpoint:
     //  active: common state before any termination begins,
     //  delimiter_received: delimiter was read from pipe before
@@ -169,6 +169,7 @@ void zmq::poll_t::loop ()
         //  in checking the pollset.
         if (rc == 0)
             continue;
+        const uint64_t start = clock_t::now_us ();
 
         for (pollset_t::size_type i = 0; i != pollset.size (); i++) {
             zmq_assert (!(pollset[i].revents & POLLNVAL));
@@ -185,6 +186,8 @@ void zmq::poll_t::loop ()
             if (pollset[i].revents & POLLIN)
                 fd_table[pollset[i].fd].events->in_event ();
         }
+
+        account_busy (start);
     }
 }
 
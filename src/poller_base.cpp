@@ -31,9 +31,15 @@
 #include "poller_base.hpp"
 #include "i_poll_events.hpp"
 #include "err.hpp"
+#include "config.hpp"
 
-zmq::poller_base_t::poller_base_t ()
+zmq::poller_base_t::poller_base_t () :
+    timers (clock.now_ms ()),
+    busy_time (0),
+    busy_window_start (clock_t::now_us ())
 {
+    busy_updated.set (
+      static_cast<atomic_counter_t::integer_t> (busy_window_start / 1000));
 }
 
 zmq::poller_base_t::~poller_base_t ()
@@ -55,24 +61,53 @@ void zmq::poller_base_t::adjust_load (int amount_)
         load.sub (-amount_);
 }
 
+int zmq::poller_base_t::get_busy () const
+{
+    //  Read the time of the last update before the clock, so that the
+    //  update cannot appear to have happened in the future.
+    const atomic_counter_t::integer_t updated = busy_updated.get ();
+    const atomic_counter_t::integer_t value = busy.get ();
+    const uint64_t now = clock_t::now_us () / 1000;
+
+    //  Halve the value for every window the thread has not reported in.
+    //  A report racing with this call counts as a current one.
+    const int32_t idle = static_cast<int32_t> (
+      static_cast<atomic_counter_t::integer_t> (now) - updated);
+    if (idle <= 0)
+        return static_cast<int> (value);
+    const int32_t windows = idle / poller_busy_window;
+    return windows >= 32 ? 0 : static_cast<int> (value >> windows);
+}
+
+void zmq::poller_base_t::account_busy (uint64_t start_us_)
+{
+    const uint64_t now = clock_t::now_us ();
+    busy_time += now - start_us_;
+
+    const uint64_t elapsed = now - busy_window_start;
+    if (elapsed < poller_busy_window * 1000)
+        return;
+
+    uint64_t share = busy_time * 1000000 / elapsed;
+    if (share > 1000000)
+        share = 1000000;
+    //  The share covers all the time since the last report, idle windows
+    //  included, so the previous value must not be decayed once more.
+    busy.set (
+      static_cast<atomic_counter_t::integer_t> ((busy.get () + share) / 2));
+    busy_updated.set (static_cast<atomic_counter_t::integer_t> (now / 1000));
+    busy_time = 0;
+    busy_window_start = now;
+}
+
 void zmq::poller_base_t::add_timer (int timeout_, i_poll_events *sink_, int id_)
 {
-    uint64_t expiration = clock.now_ms () + timeout_;
-    timer_info_t info = {sink_, id_};
-    timers.insert (timers_t::value_type (expiration, info));
+    timers.add (clock.now_ms () + timeout_, sink_, id_);
 }
 
 void zmq::poller_base_t::cancel_timer (i_poll_events *sink_, int id_)
 {
-    //  Complexity of this operation is O(n). We assume it is rarely used.
-    for (timers_t::iterator it = timers.begin (); it != timers.end (); ++it)
-        if (it->second.sink == sink_ && it->second.id == id_) {
-            timers.erase (it);
-            return;
-        }
-
-    //  Timer not found.
-    zmq_assert (false);
+    timers.cancel (sink_, id_);
 }
 
 uint64_t zmq::poller_base_t::execute_timers ()
@@ -81,30 +116,7 @@ uint64_t zmq::poller_base_t::execute_timers ()
     if (timers.empty ())
         return 0;
 
-    //  Get the current time.
-    uint64_t current = clock.now_ms ();
-
-    //   Execute the timers that are already due.
-    timers_t::iterator it = timers.begin ();
-    while (it != timers.end ()) {
-        //  If we have to wait to execute the item, same will be true about
-        //  all the following items (multimap is sorted). Thus we can stop
-        //  checking the subsequent timers and return the time to wait for
-        //  the next timer (at least 1ms).
-        if (it->first > current)
-            return it->first - current;
-
-        //  Trigger the timer.
-        it->second.sink->timer_event (it->second.id);
-
-        //  Remove it from the list of active timers.
-        timers_t::iterator o = it;
-        ++it;
-        timers.erase (o);
-    }
-
-    //  There are no more timers.
-    return 0;
+    return timers.execute (clock.now_ms ());
 }
 
 zmq::worker_poller_base_t::worker_poller_base_t (const thread_ctx_t &ctx_) :
@@ -117,10 +129,10 @@ void zmq::worker_poller_base_t::stop_worker ()
     worker.stop ();
 }
 
-void zmq::worker_poller_base_t::start ()
+void zmq::worker_poller_base_t::start (int cpu_)
 {
     zmq_assert (get_load () > 0);
-    ctx.start_thread (worker, worker_routine, this);
+    ctx.start_thread (worker, worker_routine, this, cpu_);
 }
 
 void zmq::worker_poller_base_t::check_thread ()
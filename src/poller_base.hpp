@@ -30,11 +30,10 @@
 #ifndef __ZMQ_POLLER_BASE_HPP_INCLUDED__
 #define __ZMQ_POLLER_BASE_HPP_INCLUDED__
 
-#include <map>
-
 #include "clock.hpp"
 #include "atomic_counter.hpp"
 #include "ctx.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -44,14 +43,18 @@ struct i_poll_events;
 // convention, this is done via a typedef.
 //
 // At the time of writing, the following implementations of the poller_t
-// concept exist: zmq::devpoll_t, zmq::epoll_t, zmq::kqueue_t, zmq::poll_t,
-// zmq::pollset_t, zmq::select_t
+// concept exist: zmq::devpoll_t, zmq::epoll_t, zmq::io_uring_t, zmq::kqueue_t,
+// zmq::poll_t, zmq::pollset_t, zmq::select_t
 //
 // An implementation of the poller_t concept must provide the following public
 // methods:
 //   Returns load of the poller.
 // int get_load() const;
 //
+//   Returns the share of time the poller's thread spent handling events
+//   recently, in parts per million.
+// int get_busy() const;
+//
 //   Add a timeout to expire in timeout_ milliseconds. After the
 //   expiration, timer_event on sink_ object will be called with
 //   argument set to id_.
@@ -94,7 +97,7 @@ struct i_poll_events;
 // Most of the methods may only be called from a zmq::i_poll_events callback
 // function when invoked by the poller (and, therefore, typically from the
 // poller's worker thread), with the following exceptions:
-// - get_load may be called from outside
+// - get_load and get_busy may be called from outside
 // - add_fd and add_timer may be called from outside before start
 // - start may be called from outside once
 //
@@ -127,6 +130,7 @@ class poller_base_t
 
     // Methods from the poller concept.
     int get_load () const;
+    int get_busy () const;
     void add_timer (int timeout_, zmq::i_poll_events *sink_, int id_);
     void cancel_timer (zmq::i_poll_events *sink_, int id_);
 
@@ -134,6 +138,11 @@ class poller_base_t
     //  Called by individual poller implementations to manage the load.
     void adjust_load (int amount_);
 
+    //  Called by individual poller implementations after handling the
+    //  events returned by a wait, which returned at start_us_ (as given
+    //  by clock_t::now_us), to measure how busy the thread is.
+    void account_busy (uint64_t start_us_);
+
     //  Executes any timers that are due. Returns number of milliseconds
     //  to wait to match the next timer or 0 meaning "no timers".
     uint64_t execute_timers ();
@@ -142,19 +151,25 @@ class poller_base_t
     //  Clock instance private to this I/O thread.
     clock_t clock;
 
-    //  List of active timers.
-    struct timer_info_t
-    {
-        zmq::i_poll_events *sink;
-        int id;
-    };
-    typedef std::multimap<uint64_t, timer_info_t> timers_t;
-    timers_t timers;
+    //  Active timers.
+    timer_wheel_t timers;
 
     //  Load of the poller. Currently the number of file descriptors
     //  registered.
     atomic_counter_t load;
 
+    //  Time spent handling events since the start of the current
+    //  measurement window, and the start of the window, in microseconds.
+    uint64_t busy_time;
+    uint64_t busy_window_start;
+
+    //  Busy share, decayed by half with every measurement window, as of
+    //  the end of the last window, in parts per million. Along with the
+    //  end of that window, in milliseconds, so that readers can decay it
+    //  further while the thread is idle.
+    atomic_counter_t busy;
+    atomic_counter_t busy_updated;
+
     poller_base_t (const poller_base_t &);
     const poller_base_t &operator= (const poller_base_t &);
 };
@@ -166,7 +181,7 @@ class worker_poller_base_t : public poller_base_t
     worker_poller_base_t (const thread_ctx_t &ctx_);
 
     // Methods from the poller concept.
-    void start ();
+    void start (int cpu_ = -1);
 
   protected:
     //  Checks whether the currently executing thread is the worker thread
@@ -188,9 +188,9 @@ void zmq::pollset_t::reset_pollout (handle_t handle_)
     pe->flag_pollout = false;
 }
 
-void zmq::pollset_t::start ()
+void zmq::pollset_t::start (int cpu_)
 {
-    ctx.start_thread (worker, worker_routine, this);
+    ctx.start_thread (worker, worker_routine, this, cpu_);
 }
 
 void zmq::pollset_t::stop ()
@@ -218,6 +218,7 @@ void zmq::pollset_t::loop ()
             errno_assert (errno == EINTR);
             continue;
         }
+        const uint64_t start = clock_t::now_us ();
 
         for (int i = 0; i < n; i++) {
             poll_entry_t *pe = fd_table[polldata_array[i].fd];
@@ -243,6 +244,8 @@ void zmq::pollset_t::loop ()
              ++it)
             LIBZMQ_DELETE (*it);
         retired.clear ();
+
+        account_busy (start);
     }
 }
 
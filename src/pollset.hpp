@@ -65,7 +65,7 @@ class pollset_t : public poller_base_t
     void reset_pollin (handle_t handle_);
     void set_pollout (handle_t handle_);
     void reset_pollout (handle_t handle_);
-    void start ();
+    void start (int cpu_ = -1);
     void stop ();
 
     static int max_fds ();
@@ -42,6 +42,10 @@
 #include "poller.hpp"
 #include "proxy.hpp"
 #include "likely.hpp"
+#include "config.hpp"
+#include "ctx.hpp"
+#include "thread.hpp"
+#include "atomic_ptr.hpp"
 
 #if defined ZMQ_POLL_BASED_ON_POLL && !defined ZMQ_HAVE_WINDOWS                \
   && !defined ZMQ_HAVE_AIX
@@ -124,39 +128,50 @@ int forward (class zmq::socket_base_t *from_,
              class zmq::socket_base_t *capture_,
              zmq::msg_t &msg_)
 {
-    int more;
-    size_t moresz;
-    size_t complete_msg_size = 0;
-    while (true) {
-        int rc = from_->recv (&msg_, 0);
-        if (unlikely (rc < 0))
-            return -1;
+    //  The caller has seen the sockets ready for the first message. Keep
+    //  forwarding while more messages are ready, up to the batch size.
+    //  Rather than polling the sockets again, the source is read without
+    //  blocking until it runs dry, and the destination is trusted while
+    //  its pipes have room. A socket proxying to itself is never checked
+    //  for room, as when polling.
+    for (int i = 0; i != zmq::proxy_batch_size; i++) {
+        if (i > 0 && to_ != from_ && !to_->has_out ())
+            break;
 
-        complete_msg_size += msg_.size ();
+        int more;
+        size_t complete_msg_size = 0;
+        int flags = i > 0 ? ZMQ_DONTWAIT : 0;
+        while (true) {
+            int rc = from_->recv (&msg_, flags);
+            if (unlikely (rc < 0)) {
+                if (flags == ZMQ_DONTWAIT && errno == EAGAIN)
+                    return 0;
+                return -1;
+            }
+            flags = 0;
 
-        moresz = sizeof more;
-        rc = from_->getsockopt (ZMQ_RCVMORE, &more, &moresz);
-        if (unlikely (rc < 0))
-            return -1;
+            complete_msg_size += msg_.size ();
+            more = msg_.flags () & zmq::msg_t::more;
 
-        //  Copy message to capture socket if any
-        rc = capture (capture_, msg_, more);
-        if (unlikely (rc < 0))
-            return -1;
+            //  Copy message to capture socket if any
+            rc = capture (capture_, msg_, more);
+            if (unlikely (rc < 0))
+                return -1;
 
-        rc = to_->send (&msg_, more ? ZMQ_SNDMORE : 0);
-        if (unlikely (rc < 0))
-            return -1;
+            rc = to_->send (&msg_, more ? ZMQ_SNDMORE : 0);
+            if (unlikely (rc < 0))
+                return -1;
 
-        if (more == 0)
-            break;
-    }
+            if (more == 0)
+                break;
+        }
 
-    // A multipart message counts as 1 packet:
-    from_stats->msg_in++;
-    from_stats->bytes_in += complete_msg_size;
-    to_stats->msg_out++;
-    to_stats->bytes_out += complete_msg_size;
+        // A multipart message counts as 1 packet:
+        from_stats->msg_in++;
+        from_stats->bytes_in += complete_msg_size;
+        to_stats->msg_out++;
+        to_stats->bytes_out += complete_msg_size;
+    }
 
     return 0;
 }
@@ -654,3 +669,251 @@ int zmq::proxy (class socket_base_t *frontend_,
 }
 
 #endif //  ZMQ_HAVE_POLLER
+
+//  State of one forwarding loop run by proxy_mt.
+struct proxy_worker_t
+{
+    proxy_worker_t () : finished (0), rc (0), err (0) {}
+
+    zmq::socket_base_t *frontend;
+    zmq::socket_base_t *backend;
+
+    //  Both ends of the inproc pair used to relay control commands. The
+    //  worker end is the control socket of its proxy loop.
+    zmq::socket_base_t *control_in;
+    zmq::socket_base_t *control_out;
+
+    //  Set once the loop has returned, with its result and errno.
+    zmq::atomic_value_t finished;
+    int rc;
+    int err;
+
+    zmq::thread_t thread;
+};
+
+static void proxy_worker_routine (void *arg_)
+{
+    proxy_worker_t *worker = (proxy_worker_t *) arg_;
+    worker->rc =
+      zmq::proxy (worker->frontend, worker->backend, NULL, worker->control_in);
+    worker->err = errno;
+    worker->finished.store (1);
+
+    //  Wake up collect_stats should it be waiting for this loop's reply.
+    //  The empty message cannot be mistaken for a counter.
+    zmq::msg_t msg;
+    int rc = msg.init ();
+    errno_assert (rc == 0);
+    if (worker->control_in->send (&msg, ZMQ_DONTWAIT) != 0) {
+        rc = msg.close ();
+        errno_assert (rc == 0);
+    }
+}
+
+//  Returns the first loop that returned with an error, if any.
+static proxy_worker_t *failed_worker (proxy_worker_t *workers_, int count_)
+{
+    for (int i = 0; i != count_; i++)
+        if (workers_[i].finished.load () && workers_[i].rc != 0)
+            return &workers_[i];
+    return NULL;
+}
+
+//  Sends the command to all loops still running.
+static int relay_command (proxy_worker_t *workers_,
+                          int count_,
+                          const void *data_,
+                          size_t size_)
+{
+    for (int i = 0; i != count_; i++) {
+        if (workers_[i].finished.load ())
+            continue;
+        zmq::msg_t msg;
+        int rc = msg.init_size (size_);
+        if (unlikely (rc < 0))
+            return -1;
+        memcpy (msg.data (), data_, size_);
+        rc = workers_[i].control_out->send (&msg, 0);
+        if (unlikely (rc < 0))
+            return close_and_return (&msg, -1);
+    }
+    return 0;
+}
+
+#ifdef ZMQ_BUILD_DRAFT_API
+//  Sums the statistics of all forwarding loops. Each loop replies with
+//  the 8 counters in the order reply_stats sends them. Loops that have
+//  returned are left out; a loop returning while it is being asked
+//  fails the collection with EAGAIN.
+static int collect_stats (proxy_worker_t *workers_,
+                          int count_,
+                          zmq_socket_stats_t *frontend_stats_,
+                          zmq_socket_stats_t *backend_stats_)
+{
+    if (relay_command (workers_, count_, "STATISTICS", 10) != 0)
+        return -1;
+
+    uint64_t *counters[] = {
+      &frontend_stats_->msg_in, &frontend_stats_->bytes_in,
+      &frontend_stats_->msg_out, &frontend_stats_->bytes_out,
+      &backend_stats_->msg_in, &backend_stats_->bytes_in,
+      &backend_stats_->msg_out, &backend_stats_->bytes_out};
+
+    zmq::msg_t msg;
+    int rc = msg.init ();
+    if (unlikely (rc < 0))
+        return -1;
+    for (int i = 0; i != count_; i++)
+        for (size_t j = 0; j != sizeof counters / sizeof counters[0]; j++) {
+            if (j == 0 && workers_[i].finished.load ())
+                break;
+            rc = workers_[i].control_out->recv (&msg, 0);
+            if (unlikely (rc < 0))
+                return close_and_return (&msg, -1);
+            if (msg.size () == 0) {
+                errno = EAGAIN;
+                return close_and_return (&msg, -1);
+            }
+            zmq_assert (msg.size () == sizeof (uint64_t));
+            uint64_t value;
+            memcpy (&value, msg.data (), sizeof value);
+            *counters[j] += value;
+        }
+    return close_and_return (&msg, 0);
+}
+#endif
+
+int zmq::proxy_mt (class socket_base_t **frontends_,
+                   class socket_base_t **backends_,
+                   int count_,
+                   class socket_base_t *control_)
+{
+    if (count_ <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ctx_t *ctx = frontends_[0]->get_ctx ();
+    proxy_worker_t *workers = new (std::nothrow) proxy_worker_t[count_];
+    alloc_assert (workers);
+
+    //  Connect a control pair to each loop before starting any of them,
+    //  so that no loop runs without a way to stop it.
+    int rc = 0;
+    int started = 0;
+    for (; started != count_; started++) {
+        proxy_worker_t &worker = workers[started];
+        worker.frontend = frontends_[started];
+        worker.backend = backends_[started];
+        worker.control_in = ctx->create_socket (ZMQ_PAIR);
+        worker.control_out = ctx->create_socket (ZMQ_PAIR);
+        if (!worker.control_in || !worker.control_out) {
+            if (worker.control_in)
+                worker.control_in->close ();
+            if (worker.control_out)
+                worker.control_out->close ();
+            rc = -1;
+            break;
+        }
+        char endpoint[64];
+        sprintf (endpoint, "inproc://proxy-mt-%p", (void *) &worker);
+        if (worker.control_in->bind (endpoint) != 0
+            || worker.control_out->connect (endpoint) != 0) {
+            worker.control_in->close ();
+            worker.control_out->close ();
+            rc = -1;
+            break;
+        }
+    }
+    if (rc == 0)
+        for (int i = 0; i != started; i++)
+            workers[i].thread.start (proxy_worker_routine, &workers[i]);
+
+    //  Steer all loops from the control socket. Without one, the loops
+    //  run until the context is terminated.
+    if (rc == 0 && control_) {
+        zmq_socket_stats_t frontend_stats;
+        zmq_socket_stats_t backend_stats;
+        msg_t msg;
+        rc = msg.init ();
+        while (rc == 0) {
+            rc = control_->recv (&msg, 0);
+            if (unlikely (rc < 0))
+                break;
+            if (msg.flags () & msg_t::more) {
+                errno = EINVAL;
+                rc = -1;
+                break;
+            }
+
+            //  A loop that failed cannot be restarted, so stop the others
+            //  and answer the command with the failure.
+            if (failed_worker (workers, started)) {
+                rc = -1;
+                break;
+            }
+
+            if ((msg.size () == 5 && memcmp (msg.data (), "PAUSE", 5) == 0)
+                || (msg.size () == 6
+                    && memcmp (msg.data (), "RESUME", 6) == 0))
+                rc = relay_command (workers, started, msg.data (),
+                                    msg.size ());
+            else if (msg.size () == 9
+                     && memcmp (msg.data (), "TERMINATE", 9) == 0) {
+                rc = relay_command (workers, started, msg.data (),
+                                    msg.size ());
+                break;
+            } else {
+#ifdef ZMQ_BUILD_DRAFT_API
+                if (msg.size () == 10
+                    && memcmp (msg.data (), "STATISTICS", 10) == 0) {
+                    memset (&frontend_stats, 0, sizeof (frontend_stats));
+                    memset (&backend_stats, 0, sizeof (backend_stats));
+                    rc = collect_stats (workers, started, &frontend_stats,
+                                        &backend_stats);
+                    if (rc == 0)
+                        rc = reply_stats (control_, &frontend_stats,
+                                          &backend_stats);
+                } else {
+#endif
+                    //  This is an API error, we assert
+                    puts ("E: invalid command sent to proxy");
+                    zmq_assert (false);
+#ifdef ZMQ_BUILD_DRAFT_API
+                }
+#endif
+            }
+        }
+        //  Keep errno of the failure across closing the message.
+        int err = errno;
+        msg.close ();
+        errno = err;
+
+        //  Tell the controller, which may be waiting for statistics, and
+        //  return the loop's error.
+        proxy_worker_t *failed = failed_worker (workers, started);
+        if (failed) {
+            relay_command (workers, started, "TERMINATE", 9);
+            if (msg.init_size (5) == 0) {
+                memcpy (msg.data (), "ERROR", 5);
+                if (control_->send (&msg, ZMQ_DONTWAIT) != 0)
+                    msg.close ();
+            }
+            errno = failed->err;
+        }
+    } else if (rc == 0) {
+        errno = ETERM;
+        rc = -1;
+    }
+
+    int err = errno;
+    for (int i = 0; i != started; i++) {
+        if (workers[i].thread.get_started ())
+            workers[i].thread.stop ();
+        workers[i].control_in->close ();
+        workers[i].control_out->close ();
+    }
+    delete[] workers;
+    errno = err;
+    return rc;
+}
@@ -37,6 +37,13 @@ int proxy (class socket_base_t *frontend_,
            class socket_base_t *capture_,
            class socket_base_t *control_ =
              NULL); // backward compatibility without this argument
+
+//  Runs one proxy loop per frontend/backend pair, each in its own thread,
+//  all steered from the single control socket.
+int proxy_mt (class socket_base_t **frontends_,
+              class socket_base_t **backends_,
+              int count_,
+              class socket_base_t *control_);
 }
 
 #endif
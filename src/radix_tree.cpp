@@ -0,0 +1,399 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "macros.hpp"
+#include "err.hpp"
+#include "radix_tree.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <algorithm>
+
+zmq::radix_tree_t::radix_tree_t () :
+    label (NULL),
+    label_size (0),
+    refcnt (0),
+    min (0),
+    count (0),
+    live_nodes (0)
+{
+}
+
+zmq::radix_tree_t::~radix_tree_t ()
+{
+    free (label);
+
+    if (count == 1) {
+        zmq_assert (next.node);
+        LIBZMQ_DELETE (next.node);
+    } else if (count > 1) {
+        for (unsigned short i = 0; i != count; ++i) {
+            LIBZMQ_DELETE (next.table[i]);
+        }
+        free (next.table);
+    }
+}
+
+bool zmq::radix_tree_t::add (unsigned char *prefix_, size_t size_)
+{
+    //  Consume the label, splitting it where the prefix diverges from it
+    //  or ends inside it.
+    if (label_size) {
+        size_t common = 0;
+        while (common < label_size && common < size_
+               && label[common] == prefix_[common])
+            ++common;
+        if (common < label_size)
+            split (common);
+        prefix_ += common;
+        size_ -= common;
+    }
+
+    //  We are at the node corresponding to the prefix. We are done.
+    if (!size_) {
+        ++refcnt;
+        return refcnt == 1;
+    }
+
+    unsigned char c = *prefix_;
+    if (c < min || c >= min + count) {
+        //  The character is out of range of currently handled
+        //  characters. We have to extend the table.
+        if (!count) {
+            min = c;
+            count = 1;
+            next.node = NULL;
+        } else if (count == 1) {
+            unsigned char oldc = min;
+            radix_tree_t *oldp = next.node;
+            count = (min < c ? c - min : min - c) + 1;
+            next.table =
+              (radix_tree_t **) malloc (sizeof (radix_tree_t *) * count);
+            alloc_assert (next.table);
+            for (unsigned short i = 0; i != count; ++i)
+                next.table[i] = 0;
+            min = std::min (min, c);
+            next.table[oldc - min] = oldp;
+        } else if (min < c) {
+            //  The new character is above the current character range.
+            unsigned short old_count = count;
+            count = c - min + 1;
+            next.table = (radix_tree_t **) realloc (
+              (void *) next.table, sizeof (radix_tree_t *) * count);
+            alloc_assert (next.table);
+            for (unsigned short i = old_count; i != count; i++)
+                next.table[i] = NULL;
+        } else {
+            //  The new character is below the current character range.
+            unsigned short old_count = count;
+            count = (min + old_count) - c;
+            next.table = (radix_tree_t **) realloc (
+              (void *) next.table, sizeof (radix_tree_t *) * count);
+            alloc_assert (next.table);
+            memmove (next.table + min - c, next.table,
+                     old_count * sizeof (radix_tree_t *));
+            for (unsigned short i = 0; i != min - c; i++)
+                next.table[i] = NULL;
+            min = c;
+        }
+    }
+
+    //  If next node does not exist, create one holding the rest of the
+    //  prefix as its label.
+    radix_tree_t **slot = count == 1 ? &next.node : &next.table[c - min];
+    if (!*slot) {
+        *slot = new (std::nothrow) radix_tree_t;
+        alloc_assert (*slot);
+        ++live_nodes;
+        if (size_ > 1) {
+            (*slot)->label_size = size_ - 1;
+            (*slot)->label = (unsigned char *) malloc (size_ - 1);
+            alloc_assert ((*slot)->label);
+            memcpy ((*slot)->label, prefix_ + 1, size_ - 1);
+        }
+    }
+    return (*slot)->add (prefix_ + 1, size_ - 1);
+}
+
+bool zmq::radix_tree_t::rm (unsigned char *prefix_, size_t size_)
+{
+    if (label_size) {
+        if (size_ < label_size || memcmp (prefix_, label, label_size) != 0)
+            return false;
+        prefix_ += label_size;
+        size_ -= label_size;
+    }
+
+    if (!size_) {
+        if (!refcnt)
+            return false;
+        refcnt--;
+        if (refcnt)
+            return false;
+        compact ();
+        return true;
+    }
+    unsigned char c = *prefix_;
+    if (!count || c < min || c >= min + count)
+        return false;
+
+    radix_tree_t *next_node = count == 1 ? next.node : next.table[c - min];
+
+    if (!next_node)
+        return false;
+
+    bool ret = next_node->rm (prefix_ + 1, size_ - 1);
+
+    //  Prune redundant nodes
+    if (next_node->is_redundant ()) {
+        LIBZMQ_DELETE (next_node);
+        zmq_assert (count > 0);
+
+        if (count == 1) {
+            next.node = 0;
+            count = 0;
+            --live_nodes;
+            zmq_assert (live_nodes == 0);
+        } else {
+            next.table[c - min] = 0;
+            zmq_assert (live_nodes > 1);
+            --live_nodes;
+
+            //  Compact the table if possible
+            if (live_nodes == 1) {
+                unsigned short i;
+                for (i = 0; i < count; ++i)
+                    if (next.table[i])
+                        break;
+
+                zmq_assert (i < count);
+                min += i;
+                count = 1;
+                radix_tree_t *oldp = next.table[i];
+                free (next.table);
+                next.node = oldp;
+            } else if (c == min) {
+                //  We can compact the table "from the left"
+                unsigned short i;
+                for (i = 1; i < count; ++i)
+                    if (next.table[i])
+                        break;
+
+                zmq_assert (i < count);
+                min += i;
+                count -= i;
+                radix_tree_t **old_table = next.table;
+                next.table =
+                  (radix_tree_t **) malloc (sizeof (radix_tree_t *) * count);
+                alloc_assert (next.table);
+                memmove (next.table, old_table + i,
+                         sizeof (radix_tree_t *) * count);
+                free (old_table);
+            } else if (c == min + count - 1) {
+                //  We can compact the table "from the right"
+                unsigned short i;
+                for (i = 1; i < count; ++i)
+                    if (next.table[count - 1 - i])
+                        break;
+
+                zmq_assert (i < count);
+                count -= i;
+                radix_tree_t **old_table = next.table;
+                next.table =
+                  (radix_tree_t **) malloc (sizeof (radix_tree_t *) * count);
+                alloc_assert (next.table);
+                memmove (next.table, old_table,
+                         sizeof (radix_tree_t *) * count);
+                free (old_table);
+            }
+        }
+        compact ();
+    }
+    return ret;
+}
+
+bool zmq::radix_tree_t::check (unsigned char *data_, size_t size_)
+{
+    //  This function is on critical path. It deliberately doesn't use
+    //  recursion to get a bit better performance.
+    radix_tree_t *current = this;
+    while (true) {
+        //  The label has to match as a whole before the node's own
+        //  subscription applies.
+        if (current->label_size) {
+            if (size_ < current->label_size
+                || memcmp (data_, current->label, current->label_size) != 0)
+                return false;
+            data_ += current->label_size;
+            size_ -= current->label_size;
+        }
+
+        //  We've found a corresponding subscription!
+        if (current->refcnt)
+            return true;
+
+        //  We've checked all the data and haven't found matching subscription.
+        if (!size_)
+            return false;
+
+        //  If there's no corresponding slot for the first character
+        //  of the prefix, the message does not match.
+        unsigned char c = *data_;
+        if (c < current->min || c >= current->min + current->count)
+            return false;
+
+        //  Move to the next character.
+        if (current->count == 1)
+            current = current->next.node;
+        else {
+            current = current->next.table[c - current->min];
+            if (!current)
+                return false;
+        }
+        data_++;
+        size_--;
+    }
+}
+
+void zmq::radix_tree_t::apply (
+  void (*func_) (unsigned char *data_, size_t size_, void *arg_), void *arg_)
+{
+    unsigned char *buff = NULL;
+    apply_helper (&buff, 0, 0, func_, arg_);
+    free (buff);
+}
+
+void zmq::radix_tree_t::apply_helper (unsigned char **buff_,
+                                      size_t buffsize_,
+                                      size_t maxbuffsize_,
+                                      void (*func_) (unsigned char *data_,
+                                                     size_t size_,
+                                                     void *arg_),
+                                      void *arg_)
+{
+    //  Adjust the buffer and append the label to it.
+    if (buffsize_ + label_size >= maxbuffsize_) {
+        maxbuffsize_ = buffsize_ + label_size + 256;
+        *buff_ = (unsigned char *) realloc (*buff_, maxbuffsize_);
+        alloc_assert (*buff_);
+    }
+    if (label_size) {
+        memcpy (*buff_ + buffsize_, label, label_size);
+        buffsize_ += label_size;
+    }
+
+    //  If this node is a subscription, apply the function.
+    if (refcnt)
+        func_ (*buff_, buffsize_, arg_);
+
+    //  If there are no subnodes in the tree, return.
+    if (count == 0)
+        return;
+
+    //  If there's one subnode (optimisation).
+    if (count == 1) {
+        (*buff_)[buffsize_] = min;
+        buffsize_++;
+        next.node->apply_helper (buff_, buffsize_, maxbuffsize_, func_, arg_);
+        return;
+    }
+
+    //  If there are multiple subnodes.
+    for (unsigned short c = 0; c != count; c++) {
+        (*buff_)[buffsize_] = min + c;
+        if (next.table[c])
+            next.table[c]->apply_helper (buff_, buffsize_ + 1, maxbuffsize_,
+                                         func_, arg_);
+    }
+}
+
+bool zmq::radix_tree_t::is_redundant () const
+{
+    return refcnt == 0 && live_nodes == 0;
+}
+
+void zmq::radix_tree_t::split (size_t common_)
+{
+    zmq_assert (common_ < label_size);
+
+    radix_tree_t *tail = new (std::nothrow) radix_tree_t;
+    alloc_assert (tail);
+    tail->refcnt = refcnt;
+    tail->min = min;
+    tail->count = count;
+    tail->live_nodes = live_nodes;
+    tail->next = next;
+    tail->label_size = label_size - common_ - 1;
+    if (tail->label_size) {
+        tail->label = (unsigned char *) malloc (tail->label_size);
+        alloc_assert (tail->label);
+        memcpy (tail->label, label + common_ + 1, tail->label_size);
+    }
+
+    refcnt = 0;
+    min = label[common_];
+    count = 1;
+    live_nodes = 1;
+    next.node = tail;
+    label_size = common_;
+    if (!label_size) {
+        free (label);
+        label = NULL;
+    }
+}
+
+void zmq::radix_tree_t::compact ()
+{
+    if (refcnt || count != 1 || !next.node)
+        return;
+
+    //  The new label is the old one, the character leading to the child
+    //  and the child's label.
+    radix_tree_t *child = next.node;
+    size_t size = label_size + 1 + child->label_size;
+    unsigned char *merged = (unsigned char *) realloc (label, size);
+    alloc_assert (merged);
+    merged[label_size] = min;
+    if (child->label_size)
+        memcpy (merged + label_size + 1, child->label, child->label_size);
+    label = merged;
+    label_size = size;
+
+    refcnt = child->refcnt;
+    min = child->min;
+    count = child->count;
+    live_nodes = child->live_nodes;
+    next = child->next;
+
+    child->count = 0;
+    LIBZMQ_DELETE (child);
+}
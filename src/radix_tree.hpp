@@ -27,8 +27,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef __ZMQ_TRIE_HPP_INCLUDED__
-#define __ZMQ_TRIE_HPP_INCLUDED__
+#ifndef __ZMQ_RADIX_TREE_HPP_INCLUDED__
+#define __ZMQ_RADIX_TREE_HPP_INCLUDED__
 
 #include <stddef.h>
 
@@ -36,24 +36,28 @@
 
 namespace zmq
 {
-class trie_t
+//  Path-compressed variant of trie_t. A node that would have a single
+//  child and no subscription of its own is folded into the node below
+//  it, which keeps the skipped bytes as its label. Long hierarchical
+//  prefixes thus take one node instead of one node per byte.
+class radix_tree_t
 {
   public:
-    trie_t ();
-    ~trie_t ();
+    radix_tree_t ();
+    ~radix_tree_t ();
 
-    //  Add key to the trie. Returns true if this is a new item in the trie
+    //  Add key to the tree. Returns true if this is a new item in the tree
     //  rather than a duplicate.
     bool add (unsigned char *prefix_, size_t size_);
 
-    //  Remove key from the trie. Returns true if the item is actually
-    //  removed from the trie.
+    //  Remove key from the tree. Returns true if the item is actually
+    //  removed from the tree.
     bool rm (unsigned char *prefix_, size_t size_);
 
-    //  Check whether particular key is in the trie.
+    //  Check whether particular key is in the tree.
     bool check (unsigned char *data_, size_t size_);
 
-    //  Apply the function supplied to each subscription in the trie.
+    //  Apply the function supplied to each subscription in the tree.
     void apply (void (*func_) (unsigned char *data_, size_t size_, void *arg_),
                 void *arg_);
 
@@ -67,18 +71,30 @@ class trie_t
                        void *arg_);
     bool is_redundant () const;
 
+    //  Splits the label at offset common_, moving the rest of the label,
+    //  the subscription and the subnodes of this node into a new child.
+    void split (size_t common_);
+
+    //  Folds the single child into this node if this node is not a
+    //  subscription itself.
+    void compact ();
+
+    //  Bytes following the character that leads to this node.
+    unsigned char *label;
+    size_t label_size;
+
     uint32_t refcnt;
     unsigned char min;
     unsigned short count;
     unsigned short live_nodes;
     union
     {
-        class trie_t *node;
-        class trie_t **table;
+        class radix_tree_t *node;
+        class radix_tree_t **table;
     } next;
 
-    trie_t (const trie_t &);
-    const trie_t &operator= (const trie_t &);
+    radix_tree_t (const radix_tree_t &);
+    const radix_tree_t &operator= (const radix_tree_t &);
 };
 }
 
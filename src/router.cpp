@@ -184,8 +184,8 @@ void zmq::router_t::xread_activated (pipe_t *pipe_)
 
 void zmq::router_t::xwrite_activated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
+    outpipes_t::iterator it = outpipes.begin ();
+    for (; it != outpipes.end (); ++it)
         if (it->second.pipe == pipe_)
             break;
 
@@ -222,6 +222,8 @@ int zmq::router_t::xsend (msg_t *msg_)
                     // Check whether pipe is full or not
                     bool pipe_full = !current_out->check_hwm ();
                     it->second.active = false;
+                    if (pipe_full && !mandatory)
+                        current_out->count_hwm_drop ();
                     current_out = NULL;
 
                     if (mandatory) {
@@ -428,8 +430,8 @@ bool zmq::router_t::xhas_out ()
         return true;
 
     bool has_out = false;
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
+    outpipes_t::iterator it = outpipes.begin ();
+    for (; it != outpipes.end (); ++it)
         has_out |= it->second.pipe->check_hwm ();
 
     return has_out;
@@ -440,6 +442,20 @@ const zmq::blob_t &zmq::router_t::get_credential () const
     return fq.get_credential ();
 }
 
+int zmq::router_t::xlookup_peer (const void *routing_id_,
+                                 size_t routing_id_size_,
+                                 pipe_t **pipe_)
+{
+    blob_t routing_id_blob ((unsigned char *) routing_id_, routing_id_size_);
+    outpipes_t::const_iterator it = outpipes.find (routing_id_blob);
+    if (it == outpipes.end ()) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+    *pipe_ = it->second.pipe;
+    return 0;
+}
+
 int zmq::router_t::get_peer_state (const void *routing_id_,
                                    size_t routing_id_size_) const
 {
@@ -518,16 +534,14 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_)
                     outpipe_t existing_outpipe = {it->second.pipe,
                                                   it->second.active};
 
-                    ok = outpipes
-                           .ZMQ_MAP_INSERT_OR_EMPLACE (
-                             ZMQ_MOVE (new_routing_id), existing_outpipe)
-                           .second;
-                    zmq_assert (ok);
-
                     //  Remove the existing routing id entry to allow the new
-                    //  connection to take the routing id.
+                    //  connection to take the routing id. This has to be
+                    //  done first as inserting invalidates the iterator.
                     outpipes.erase (it);
 
+                    ok = outpipes.insert (new_routing_id, existing_outpipe);
+                    zmq_assert (ok);
+
                     if (existing_outpipe.pipe == current_in)
                         terminate_current_in = true;
                     else
@@ -540,8 +554,7 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_)
     pipe_->set_router_socket_routing_id (routing_id);
     //  Add the record into output pipes lookup table
     outpipe_t outpipe = {pipe_, true};
-    ok = outpipes.ZMQ_MAP_INSERT_OR_EMPLACE (ZMQ_MOVE (routing_id), outpipe)
-           .second;
+    ok = outpipes.insert (routing_id, outpipe);
     zmq_assert (ok);
 
     return true;
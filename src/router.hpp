@@ -30,12 +30,12 @@
 #ifndef __ZMQ_ROUTER_HPP_INCLUDED__
 #define __ZMQ_ROUTER_HPP_INCLUDED__
 
-#include <map>
+#include <set>
 
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "stdint.hpp"
-#include "blob.hpp"
+#include "blob_map.hpp"
 #include "msg.hpp"
 #include "fq.hpp"
 
@@ -61,6 +61,9 @@ class router_t : public socket_base_t
     void xread_activated (zmq::pipe_t *pipe_);
     void xwrite_activated (zmq::pipe_t *pipe_);
     void xpipe_terminated (zmq::pipe_t *pipe_);
+    int xlookup_peer (const void *routing_id_,
+                      size_t routing_id_size_,
+                      zmq::pipe_t **pipe_);
     int get_peer_state (const void *identity, size_t identity_size) const;
 
   protected:
@@ -107,7 +110,7 @@ class router_t : public socket_base_t
     std::set<pipe_t *> anonymous_pipes;
 
     //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<blob_t, outpipe_t> outpipes_t;
+    typedef blob_map_t<outpipe_t> outpipes_t;
     outpipes_t outpipes;
 
     //  The pipe we are currently writing to.
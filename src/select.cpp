@@ -432,7 +432,9 @@ void zmq::select_t::select_family_entry (family_entry_t &family_entry_,
     }
 #endif
 
+    const uint64_t start = clock_t::now_us ();
     trigger_events (fd_entries, local_fds_set, rc);
+    account_busy (start);
 
     cleanup_retired (family_entry_);
 }
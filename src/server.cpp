@@ -28,6 +28,8 @@
 */
 
 #include "precompiled.hpp"
+#include <string.h>
+
 #include "macros.hpp"
 #include "server.hpp"
 #include "pipe.hpp"
@@ -176,6 +178,27 @@ bool zmq::server_t::xhas_out ()
     return true;
 }
 
+int zmq::server_t::xlookup_peer (const void *routing_id_,
+                                 size_t routing_id_size_,
+                                 pipe_t **pipe_)
+{
+    //  Routing ids of SERVER peers are the numbers zmq_msg_routing_id
+    //  returns.
+    if (routing_id_size_ != sizeof (uint32_t)) {
+        errno = EINVAL;
+        return -1;
+    }
+    uint32_t routing_id;
+    memcpy (&routing_id, routing_id_, sizeof routing_id);
+    outpipes_t::const_iterator it = outpipes.find (routing_id);
+    if (it == outpipes.end ()) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+    *pipe_ = it->second.pipe;
+    return 0;
+}
+
 const zmq::blob_t &zmq::server_t::get_credential () const
 {
     return fq.get_credential ();
@@ -60,6 +60,9 @@ class server_t : public socket_base_t
     void xread_activated (zmq::pipe_t *pipe_);
     void xwrite_activated (zmq::pipe_t *pipe_);
     void xpipe_terminated (zmq::pipe_t *pipe_);
+    int xlookup_peer (const void *routing_id_,
+                      size_t routing_id_size_,
+                      zmq::pipe_t **pipe_);
 
   protected:
     const blob_t &get_credential () const;
@@ -112,9 +112,13 @@ zmq::session_base_t::session_base_t (class io_thread_t *io_thread_,
     engine (NULL),
     socket (socket_),
     io_thread (io_thread_),
+    home_io_thread (io_thread_),
+    runner_tid (0),
+    migrating (false),
     has_linger_timer (false),
     addr (addr_)
 {
+    set_migratable (&runner_tid);
 }
 
 const char *zmq::session_base_t::get_endpoint () const
@@ -497,6 +501,34 @@ void zmq::session_base_t::process_term (int linger_)
         zap_pipe->terminate (false);
 }
 
+void zmq::session_base_t::process_migrate (uint64_t affinity_)
+{
+    //  Only sessions with an established connection move, along with
+    //  their engines.
+    io_thread_t *target = choose_io_thread (affinity_);
+    if (target && target != io_thread && engine && !pending
+        && !is_terminating () && engine->suspend ()) {
+        io_object_t::unplug ();
+        io_thread = target;
+        migrating = true;
+    }
+
+    //  Have the commands for the session routed to the thread it ends up
+    //  in. The session resumes there once all the commands sent to it
+    //  before have been processed.
+    send_reroute (home_io_thread, this, io_thread);
+}
+
+void zmq::session_base_t::process_adopt ()
+{
+    if (!migrating)
+        return;
+    migrating = false;
+
+    io_object_t::plug (io_thread);
+    engine->resume (io_thread);
+}
+
 void zmq::session_base_t::timer_event (int id_)
 {
     //  Linger period expired. We can proceed with termination even though
@@ -511,6 +543,8 @@ void zmq::session_base_t::timer_event (int id_)
 
 void zmq::session_base_t::reconnect ()
 {
+    socket->get_stats ().reconnects.add (1);
+
     //  For delayed connect situations, terminate the pipe
     //  and reestablish later on
     if (pipe && options.immediate == 1 && addr->protocol != "pgm"
@@ -577,7 +611,7 @@ void zmq::session_base_t::start_connecting (bool wait_)
     }
 
 #if !defined ZMQ_HAVE_WINDOWS && !defined ZMQ_HAVE_OPENVMS
-    if (addr->protocol == "ipc") {
+    if (addr->protocol == "ipc" || addr->protocol == "shm") {
         ipc_connecter_t *connecter = new (std::nothrow)
           ipc_connecter_t (io_thread, this, options, addr, wait_);
         alloc_assert (connecter);
@@ -113,6 +113,8 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     void process_plug ();
     void process_attach (zmq::i_engine *engine_);
     void process_term (int linger_);
+    void process_migrate (uint64_t affinity_);
+    void process_adopt ();
 
     //  i_poll_events handlers.
     void timer_event (int id_);
@@ -152,6 +154,19 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     //  the engines into the same thread.
     zmq::io_thread_t *io_thread;
 
+    //  I/O thread the session was created in. Commands for the session
+    //  and its pipes keep being sent there, and are forwarded to the
+    //  session's current thread if it has been migrated.
+    zmq::io_thread_t *const home_io_thread;
+
+    //  ID of the I/O thread processing the commands for the session and
+    //  its pipes, maintained by the home I/O thread.
+    uint32_t runner_tid;
+
+    //  True iff the session has been detached from its I/O thread and is
+    //  on its way to another one.
+    bool migrating;
+
     //  ID of the linger timer
     enum
     {
@@ -0,0 +1,444 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "shm_engine.hpp"
+
+#if defined HAVE_MEMFD_CREATE
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "config.hpp"
+#include "err.hpp"
+#include "likely.hpp"
+#include "macros.hpp"
+
+//  First byte sent over the socket, carrying the descriptor of the ring.
+//  Differs from the first byte of a ZMTP greeting, so that a peer using
+//  ipc:// instead of shm:// is rejected.
+static const unsigned char ring_marker = 0xa5;
+
+zmq::shm_engine_t::shm_engine_t (fd_t fd_,
+                                 const options_t &options_,
+                                 const std::string &endpoint_) :
+    stream_engine_t (fd_, options_, endpoint_),
+    tx_segment (NULL),
+    tx_segment_size (0),
+    rx_segment (NULL),
+    rx_segment_size (0),
+    wake_fd (retired_fd),
+    wake_handle ((handle_t) NULL),
+    tx_blocked (false),
+    peer_closed (false),
+    has_read_timer (false)
+{
+}
+
+zmq::shm_engine_t::~shm_engine_t ()
+{
+    if (tx_segment) {
+        const int rc = munmap (tx_segment, tx_segment_size);
+        errno_assert (rc == 0);
+    }
+    if (rx_segment) {
+        const int rc = munmap (rx_segment, rx_segment_size);
+        errno_assert (rc == 0);
+    }
+    if (wake_fd != retired_fd) {
+        const int rc = ::close (wake_fd);
+        errno_assert (rc == 0);
+    }
+}
+
+int zmq::shm_engine_t::init ()
+{
+    wake_fd = dup (s);
+    if (wake_fd == -1) {
+        wake_fd = retired_fd;
+        return -1;
+    }
+
+    //  The segment is sealed against resizing, so that the peer cannot
+    //  make our accesses to it fault by truncating it.
+    const size_t size = shm_ring_t::segment_size (shm_ring_size);
+    const int fd = memfd_create ("zmq-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1)
+        return -1;
+    int rc = ftruncate (fd, size);
+    if (rc == 0)
+        rc = fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+    if (rc == 0) {
+        void *segment =
+          mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (segment == MAP_FAILED)
+            rc = -1;
+        else {
+            tx_segment = segment;
+            tx_segment_size = size;
+            tx.create (tx_segment, shm_ring_size);
+        }
+    }
+
+    //  Pass the descriptor to the peer. The socket has just been
+    //  connected, so there is room for this in its buffer.
+    if (rc == 0) {
+        unsigned char marker = ring_marker;
+        struct iovec iov;
+        iov.iov_base = &marker;
+        iov.iov_len = sizeof marker;
+
+        union
+        {
+            struct cmsghdr align;
+            char buf[CMSG_SPACE (sizeof (int))];
+        } control;
+        memset (&control, 0, sizeof control);
+
+        struct msghdr msg;
+        memset (&msg, 0, sizeof msg);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof control.buf;
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+        memcpy (CMSG_DATA (cmsg), &fd, sizeof fd);
+
+        if (sendmsg (s, &msg, MSG_NOSIGNAL) != 1)
+            rc = -1;
+    }
+
+    const int err = errno;
+    const int rc2 = ::close (fd);
+    errno_assert (rc2 == 0);
+    errno = err;
+    return rc;
+}
+
+void zmq::shm_engine_t::in_event ()
+{
+    poll_peer ();
+    process_input ();
+}
+
+void zmq::shm_engine_t::out_event ()
+{
+    stream_engine_t::out_event ();
+
+    //  The socket is always writable, so do not poll it for output while
+    //  the ring is full. Wait for the peer to wake us up instead.
+    if (unlikely (tx_blocked) && !io_error) {
+        reset_pollout (handle);
+        if (!wake_handle)
+            wake_handle = add_fd (wake_fd);
+        set_pollin (wake_handle);
+    }
+}
+
+void zmq::shm_engine_t::timer_event (int id_)
+{
+    if (id_ != read_timer_id) {
+        stream_engine_t::timer_event (id_);
+        return;
+    }
+    has_read_timer = false;
+    process_input ();
+}
+
+int zmq::shm_engine_t::read (void *data_, size_t size_)
+{
+    if (unlikely (!rx.attached ())) {
+        if (peer_closed)
+            return 0;
+        errno = EAGAIN;
+        return -1;
+    }
+
+    const int nbytes = rx.read (data_, size_);
+    if (unlikely (nbytes == -1)) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (nbytes > 0 && rx.wake_writer ())
+        wake_peer ();
+
+    //  Wait for a wake-up if the ring has been drained; otherwise come
+    //  back for the rest once the data read now have been processed.
+    if (!rx.reader_sleep ())
+        schedule_read ();
+
+    if (nbytes > 0)
+        return nbytes;
+    if (peer_closed)
+        return 0;
+    errno = EAGAIN;
+    return -1;
+}
+
+int zmq::shm_engine_t::write (const void *data1_,
+                              size_t size1_,
+                              const void *data2_,
+                              size_t size2_)
+{
+    if (unlikely (peer_closed)) {
+        errno = EPIPE;
+        return -1;
+    }
+
+    int nbytes = tx.write (data1_, size1_);
+    if (nbytes == (int) size1_ && size2_ > 0) {
+        const int rc = tx.write (data2_, size2_);
+        nbytes = rc == -1 ? -1 : nbytes + rc;
+    }
+    if (unlikely (nbytes == -1)) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (nbytes > 0 && tx.wake_reader ())
+        wake_peer ();
+
+    if ((size_t) nbytes < size1_ + size2_ && tx.writer_sleep ())
+        tx_blocked = true;
+
+    return nbytes;
+}
+
+void zmq::shm_engine_t::unplug ()
+{
+    if (has_read_timer) {
+        cancel_timer (read_timer_id);
+        has_read_timer = false;
+    }
+    if (wake_handle) {
+        rm_fd (wake_handle);
+        wake_handle = (handle_t) NULL;
+    }
+    stream_engine_t::unplug ();
+}
+
+bool zmq::shm_engine_t::suspend ()
+{
+    if (io_error)
+        return false;
+
+    //  The flags are kept to restore the registrations later on.
+    if (has_read_timer)
+        cancel_timer (read_timer_id);
+    if (wake_handle) {
+        rm_fd (wake_handle);
+        wake_handle = (handle_t) NULL;
+    }
+
+    if (stream_engine_t::suspend ())
+        return true;
+
+    restore_polling ();
+    return false;
+}
+
+void zmq::shm_engine_t::resume (io_thread_t *io_thread_)
+{
+    stream_engine_t::resume (io_thread_);
+    if (tx_blocked)
+        reset_pollout (handle);
+    restore_polling ();
+}
+
+void zmq::shm_engine_t::restore_polling ()
+{
+    if (has_read_timer)
+        add_timer (0, read_timer_id);
+    if (tx_blocked) {
+        wake_handle = add_fd (wake_fd);
+        set_pollin (wake_handle);
+    }
+}
+
+int zmq::shm_engine_t::receive_ring ()
+{
+    unsigned char marker = 0;
+    struct iovec iov;
+    iov.iov_base = &marker;
+    iov.iov_len = sizeof marker;
+
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE (sizeof (int))];
+    } control;
+
+    struct msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+
+    const ssize_t nbytes = recvmsg (s, &msg, MSG_CMSG_CLOEXEC);
+    if (nbytes == 0)
+        return 0;
+    if (nbytes == -1)
+        return -1;
+
+    //  The control buffer has room for more than one descriptor, and the
+    //  peer may send several. Keep the first and close all the others;
+    //  the ring is only accepted if there was exactly one.
+    int fd = -1;
+    int fds = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg); cmsg;
+         cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        const size_t count = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+        const unsigned char *data = CMSG_DATA (cmsg);
+        for (size_t i = 0; i != count; i++) {
+            int received;
+            memcpy (&received, data + i * sizeof (int), sizeof received);
+            if (fds++ == 0)
+                fd = received;
+            else {
+                const int rc = ::close (received);
+                errno_assert (rc == 0);
+            }
+        }
+    }
+
+    //  Only map segments whose size is sealed, so they can neither shrink
+    //  under our feet nor be grown past what we mapped. F_GET_SEALS fails
+    //  on descriptors that do not support sealing.
+    const int required_seals = F_SEAL_SHRINK | F_SEAL_GROW;
+    const int seals = fd != -1 ? fcntl (fd, F_GET_SEALS) : -1;
+    struct stat st;
+    void *segment = MAP_FAILED;
+    if (fds == 1 && marker == ring_marker && !(msg.msg_flags & MSG_CTRUNC)
+        && seals != -1 && (seals & required_seals) == required_seals
+        && fstat (fd, &st) == 0 && st.st_size > 0)
+        segment = mmap (NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+    if (fd != -1) {
+        const int rc = ::close (fd);
+        errno_assert (rc == 0);
+    }
+    if (segment == MAP_FAILED) {
+        errno = EPROTO;
+        return -1;
+    }
+
+    if (rx.attach (segment, (size_t) st.st_size) == -1) {
+        const int rc = munmap (segment, (size_t) st.st_size);
+        errno_assert (rc == 0);
+        errno = EPROTO;
+        return -1;
+    }
+    rx_segment = segment;
+    rx_segment_size = (size_t) st.st_size;
+    return 1;
+}
+
+void zmq::shm_engine_t::poll_peer ()
+{
+    if (unlikely (!rx.attached ())) {
+        const int rc = receive_ring ();
+        if (rc == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (rc != 1) {
+            peer_closed = true;
+            return;
+        }
+    }
+
+    //  Consume the wake-ups. They carry no data; the rings are checked
+    //  anyway.
+    unsigned char buf[64];
+    ssize_t nbytes;
+    do
+        nbytes = ::recv (s, buf, sizeof buf, 0);
+    while (nbytes == (ssize_t) sizeof buf);
+    if (nbytes == 0
+        || (nbytes == -1 && errno != EAGAIN && errno != EWOULDBLOCK
+            && errno != EINTR))
+        peer_closed = true;
+}
+
+void zmq::shm_engine_t::wake_peer ()
+{
+    //  If the socket buffer is full, the peer has wake-ups pending
+    //  already. If the peer has gone away, the engine learns about it
+    //  when polling the socket.
+    const unsigned char token = 0;
+    const ssize_t rc = ::send (s, &token, sizeof token, MSG_NOSIGNAL);
+    LIBZMQ_UNUSED (rc);
+}
+
+void zmq::shm_engine_t::process_input ()
+{
+    if (unlikely (io_error))
+        return;
+
+    if (tx_blocked && tx.writable ()) {
+        tx_blocked = false;
+        reset_pollin (wake_handle);
+        set_pollout (handle);
+    }
+
+    //  While the input is stopped, the engine only gets woken up to resume
+    //  the output or because the peer has gone away. In the latter case
+    //  stop polling; the error is reported when the input is restarted.
+    if (input_stopped) {
+        if (peer_closed) {
+            if (wake_handle) {
+                rm_fd (wake_handle);
+                wake_handle = (handle_t) NULL;
+            }
+            rm_fd (handle);
+            io_error = true;
+        }
+        return;
+    }
+
+    stream_engine_t::in_event ();
+}
+
+void zmq::shm_engine_t::schedule_read ()
+{
+    if (!has_read_timer) {
+        add_timer (0, read_timer_id);
+        has_read_timer = true;
+    }
+}
+
+#endif
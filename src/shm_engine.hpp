@@ -0,0 +1,138 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SHM_ENGINE_HPP_INCLUDED__
+#define __ZMQ_SHM_ENGINE_HPP_INCLUDED__
+
+#if defined HAVE_MEMFD_CREATE
+
+#include "stream_engine.hpp"
+#include "shm_ring.hpp"
+
+namespace zmq
+{
+//  Engine for shm:// connections. Peers on the same host rendezvous over
+//  a UNIX domain socket. Each side then creates a ring in shared memory
+//  for the data it sends and passes it to the peer over the socket.
+//  From then on the socket only carries one-byte wake-ups, sent when the
+//  peer waits for data or for room in a ring. ZMTP runs over the rings
+//  unchanged, so all socket types and security mechanisms work.
+
+class shm_engine_t : public stream_engine_t
+{
+  public:
+    shm_engine_t (fd_t fd_,
+                  const options_t &options_,
+                  const std::string &endpoint_);
+    ~shm_engine_t ();
+
+    //  Creates the ring this engine writes to and sends it to the peer.
+    //  Must be called before the engine is plugged.
+    int init ();
+
+    //  i_engine interface implementation.
+    bool suspend ();
+    void resume (zmq::io_thread_t *io_thread_);
+
+    //  i_poll_events interface implementation.
+    void in_event ();
+    void out_event ();
+    void timer_event (int id_);
+
+  protected:
+    int read (void *data_, size_t size_);
+    int write (const void *data1_,
+               size_t size1_,
+               const void *data2_,
+               size_t size2_);
+    void unplug ();
+
+  private:
+    //  Maps the ring the peer writes to once it has arrived. Returns 1
+    //  on success, 0 if the peer has closed the connection, or -1 with
+    //  errno set.
+    int receive_ring ();
+
+    //  Picks up the peer's ring if necessary and consumes pending
+    //  wake-ups. Notes if the peer has gone away.
+    void poll_peer ();
+
+    //  Wakes up the peer.
+    void wake_peer ();
+
+    //  Resumes output if the peer has made room in the outbound ring,
+    //  then processes the input unless it is stopped.
+    void process_input ();
+
+    //  Arranges for in_event to be called again soon, for the data left
+    //  in the inbound ring.
+    void schedule_read ();
+
+    //  Registers the pending read and the wait for room in the outbound
+    //  ring with the poller again, after the engine has been suspended.
+    void restore_polling ();
+
+    //  Outbound ring, created by this engine.
+    shm_ring_t tx;
+    void *tx_segment;
+    size_t tx_segment_size;
+
+    //  Inbound ring, created by the peer.
+    shm_ring_t rx;
+    void *rx_segment;
+    size_t rx_segment_size;
+
+    //  Duplicate of the socket, polled for wake-ups while the outbound
+    //  ring is full. Registered separately, so that this works even if
+    //  the engine has stopped reading input.
+    fd_t wake_fd;
+    handle_t wake_handle;
+
+    //  True iff the outbound ring is full and the engine waits for the
+    //  peer to make room.
+    bool tx_blocked;
+
+    //  True iff the peer has closed the connection. Data left in the
+    //  inbound ring are still delivered.
+    bool peer_closed;
+
+    enum
+    {
+        read_timer_id = 0x90
+    };
+    bool has_read_timer;
+
+    shm_engine_t (const shm_engine_t &);
+    const shm_engine_t &operator= (const shm_engine_t &);
+};
+}
+
+#endif
+
+#endif
@@ -0,0 +1,249 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SHM_RING_HPP_INCLUDED__
+#define __ZMQ_SHM_RING_HPP_INCLUDED__
+
+#if defined HAVE_MEMFD_CREATE
+
+#include <algorithm>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "config.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Single-producer single-consumer byte ring placed in memory shared by
+//  two processes. The writer and the reader each own one of the indices;
+//  the other side only reads it. Either side sets a flag before it waits
+//  for the other one, so that a wake-up has to be sent only in that case.
+//  The ring is used by a single writer and a single reader; the methods
+//  below say which side may call them.
+
+class shm_ring_t
+{
+  public:
+    //  Size of the memory segment holding a ring of the given capacity.
+    static size_t segment_size (size_t capacity_)
+    {
+        return sizeof (header_t) + capacity_;
+    }
+
+    inline shm_ring_t () : header (NULL), data (NULL), mask (0) {}
+
+    //  Initialises a new, empty ring in the segment. The capacity must
+    //  be a power of two.
+    inline void create (void *segment_, size_t capacity_)
+    {
+        header = (header_t *) segment_;
+        memset (header, 0, sizeof (header_t));
+        header->magic = magic;
+        header->capacity = capacity_;
+        data = (unsigned char *) segment_ + sizeof (header_t);
+        mask = capacity_ - 1;
+    }
+
+    //  Attaches to a ring created by the peer in a segment of size_ bytes.
+    //  Returns -1 if the segment does not hold a valid ring.
+    inline int attach (void *segment_, size_t size_)
+    {
+        header_t *h = (header_t *) segment_;
+        if (size_ < sizeof (header_t) || h->magic != magic
+            || h->capacity != size_ - sizeof (header_t) || h->capacity == 0
+            || (h->capacity & (h->capacity - 1)) != 0)
+            return -1;
+        header = h;
+        data = (unsigned char *) segment_ + sizeof (header_t);
+        mask = (size_t) h->capacity - 1;
+        return 0;
+    }
+
+    inline bool attached () const { return header != NULL; }
+
+    //  Writer. Copies as much of the data as fits into the ring and
+    //  returns the number of bytes copied, or -1 if the indices have
+    //  been corrupted.
+    inline int write (const void *data_, size_t size_)
+    {
+        const uint64_t head = __atomic_load_n (&header->head, __ATOMIC_RELAXED);
+        const uint64_t tail =
+          __atomic_load_n (&header->tail, __ATOMIC_ACQUIRE);
+        if (head - tail > mask + 1)
+            return -1;
+        size_t n = (size_t) (mask + 1 - (head - tail));
+        if (n > size_)
+            n = size_;
+        if (n > (size_t) INT_MAX)
+            n = (size_t) INT_MAX;
+        copy_in (head & mask, data_, n);
+        __atomic_store_n (&header->head, head + n, __ATOMIC_RELEASE);
+        return (int) n;
+    }
+
+    //  Reader. Copies up to size_ bytes out of the ring and returns the
+    //  number of bytes copied, or -1 if the indices have been corrupted.
+    inline int read (void *data_, size_t size_)
+    {
+        const uint64_t tail = __atomic_load_n (&header->tail, __ATOMIC_RELAXED);
+        const uint64_t head =
+          __atomic_load_n (&header->head, __ATOMIC_ACQUIRE);
+        if (head - tail > mask + 1)
+            return -1;
+        size_t n = (size_t) (head - tail);
+        if (n > size_)
+            n = size_;
+        if (n > (size_t) INT_MAX)
+            n = (size_t) INT_MAX;
+        copy_out (tail & mask, data_, n);
+        __atomic_store_n (&header->tail, tail + n, __ATOMIC_RELEASE);
+        return (int) n;
+    }
+
+    //  Writer. Returns true if there is room for at least one byte.
+    inline bool writable () const
+    {
+        return __atomic_load_n (&header->head, __ATOMIC_RELAXED)
+                 - __atomic_load_n (&header->tail, __ATOMIC_ACQUIRE)
+               <= mask;
+    }
+
+    //  Reader. Announces that the reader is about to wait for data.
+    //  Returns false, and does not wait, if data have arrived meanwhile.
+    inline bool reader_sleep ()
+    {
+        __atomic_store_n (&header->reader_sleeping, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence (__ATOMIC_SEQ_CST);
+        if (__atomic_load_n (&header->head, __ATOMIC_ACQUIRE)
+            == __atomic_load_n (&header->tail, __ATOMIC_RELAXED))
+            return true;
+        __atomic_exchange_n (&header->reader_sleeping, 0, __ATOMIC_SEQ_CST);
+        return false;
+    }
+
+    //  Writer. Announces that the writer is about to wait for room in
+    //  the ring. Returns false, and does not wait, if room has been made
+    //  meanwhile.
+    inline bool writer_sleep ()
+    {
+        __atomic_store_n (&header->writer_waiting, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence (__ATOMIC_SEQ_CST);
+        if (!writable ())
+            return true;
+        __atomic_exchange_n (&header->writer_waiting, 0, __ATOMIC_SEQ_CST);
+        return false;
+    }
+
+    //  Writer, after writing. Returns true if the reader is waiting and
+    //  has to be woken up.
+    inline bool wake_reader ()
+    {
+        //  Pairs with the fence in reader_sleep: either the reader sees
+        //  the data just written, or we see its flag.
+        __atomic_thread_fence (__ATOMIC_SEQ_CST);
+        if (!__atomic_load_n (&header->reader_sleeping, __ATOMIC_RELAXED))
+            return false;
+        return __atomic_exchange_n (&header->reader_sleeping, 0,
+                                    __ATOMIC_SEQ_CST)
+               != 0;
+    }
+
+    //  Reader, after reading. Returns true if the writer is waiting and
+    //  has to be woken up. The writer is left waiting until half of the
+    //  ring is free, so that it resumes with a large chunk of room rather
+    //  than being woken for every read.
+    inline bool wake_writer ()
+    {
+        __atomic_thread_fence (__ATOMIC_SEQ_CST);
+        if (!__atomic_load_n (&header->writer_waiting, __ATOMIC_RELAXED))
+            return false;
+        if (__atomic_load_n (&header->head, __ATOMIC_RELAXED)
+              - __atomic_load_n (&header->tail, __ATOMIC_RELAXED)
+            > (mask + 1) / 2)
+            return false;
+        return __atomic_exchange_n (&header->writer_waiting, 0,
+                                    __ATOMIC_SEQ_CST)
+               != 0;
+    }
+
+  private:
+    enum
+    {
+        //  "ZMQSHM" followed by the layout version.
+        magic_hi = 0x5a4d5153,
+        magic_lo = 0x484d0001
+    };
+    static const uint64_t magic = ((uint64_t) magic_hi << 32) | magic_lo;
+
+    //  The indices count bytes written and read since the ring was
+    //  created. Each of them sits on its own cache line together with
+    //  the flag of the side that owns it.
+    struct header_t
+    {
+        uint64_t magic;
+        uint64_t capacity;
+        unsigned char header_pad[cache_line_size - 2 * sizeof (uint64_t)];
+        uint64_t head;
+        uint32_t writer_waiting;
+        unsigned char writer_pad[cache_line_size - sizeof (uint64_t)
+                                 - sizeof (uint32_t)];
+        uint64_t tail;
+        uint32_t reader_sleeping;
+        unsigned char reader_pad[cache_line_size - sizeof (uint64_t)
+                                 - sizeof (uint32_t)];
+    };
+
+    inline void copy_in (size_t pos_, const void *data_, size_t size_)
+    {
+        const size_t first = std::min (size_, mask + 1 - pos_);
+        memcpy (data + pos_, data_, first);
+        memcpy (data, (const unsigned char *) data_ + first, size_ - first);
+    }
+
+    inline void copy_out (size_t pos_, void *data_, size_t size_)
+    {
+        const size_t first = std::min (size_, mask + 1 - pos_);
+        memcpy (data_, data + pos_, first);
+        memcpy ((unsigned char *) data_ + first, data, size_ - first);
+    }
+
+    header_t *header;
+    unsigned char *data;
+    size_t mask;
+
+    shm_ring_t (const shm_ring_t &);
+    const shm_ring_t &operator= (const shm_ring_t &);
+};
+}
+
+#endif
+
+#endif
@@ -195,6 +195,8 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_,
     handle ((poller_t::handle_t) NULL),
     last_tsc (0),
     ticks (0),
+    poll_rate (inbound_poll_rate),
+    command_delay (max_command_delay),
     rcvmore (false),
     monitor_socket (NULL),
     monitor_events (0),
@@ -301,6 +303,10 @@ int zmq::socket_base_t::check_protocol (const std::string &protocol_)
         // TIPC transport is only available on Linux.
         && protocol_ != "tipc"
 #endif
+#if defined HAVE_MEMFD_CREATE
+        //  The shm transport passes memfd segments between the peers.
+        && protocol_ != "shm"
+#endif
 #if defined ZMQ_HAVE_NORM
         && protocol_ != "norm"
 #endif
@@ -339,6 +345,8 @@ void zmq::socket_base_t::attach_pipe (pipe_t *pipe_, bool subscribe_to_all_)
 {
     //  First, register the pipe so that we can terminate it later on.
     pipe_->set_event_sink (this);
+    pipe_->set_stats (&stats);
+    pipe_->set_deferred_flushes (&deferred_flushes);
     pipes.push_back (pipe_);
 
     //  Let the derived socket type know about new pipe.
@@ -487,6 +495,33 @@ int zmq::socket_base_t::leave (const char *group_)
     return rc;
 }
 
+int zmq::socket_base_t::migrate (uint64_t affinity_)
+{
+    scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+
+    //  Check whether the library haven't been shut down yet.
+    if (unlikely (ctx_terminated)) {
+        errno = ETERM;
+        return -1;
+    }
+
+    //  Process pending commands, if any, so that the sessions launched
+    //  meanwhile are migrated as well.
+    int rc = process_commands (0, false);
+    if (unlikely (rc != 0))
+        return -1;
+
+    if (!choose_io_thread (affinity_)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  The sessions pick their new I/O threads themselves, each at the
+    //  time it receives the command.
+    own_t::process_migrate (affinity_);
+    return 0;
+}
+
 void zmq::socket_base_t::add_signaler (signaler_t *s_)
 {
     zmq_assert (thread_safe);
@@ -628,9 +663,9 @@ int zmq::socket_base_t::bind (const char *addr_)
     }
 
 #if !defined ZMQ_HAVE_WINDOWS && !defined ZMQ_HAVE_OPENVMS
-    if (protocol == "ipc") {
-        ipc_listener_t *listener =
-          new (std::nothrow) ipc_listener_t (io_thread, this, options);
+    if (protocol == "ipc" || protocol == "shm") {
+        ipc_listener_t *listener = new (std::nothrow)
+          ipc_listener_t (io_thread, this, options, protocol);
         alloc_assert (listener);
         int rc = listener->set_address (address.c_str ());
         if (rc != 0) {
@@ -884,7 +919,7 @@ int zmq::socket_base_t::connect (const char *addr_)
         paddr->resolved.tcp_addr = NULL;
     }
 #if !defined ZMQ_HAVE_WINDOWS && !defined ZMQ_HAVE_OPENVMS
-    else if (protocol == "ipc") {
+    else if (protocol == "ipc" || protocol == "shm") {
         paddr->resolved.ipc_addr = new (std::nothrow) ipc_address_t ();
         alloc_assert (paddr->resolved.ipc_addr);
         int rc = paddr->resolved.ipc_addr->resolve (address.c_str ());
@@ -1101,7 +1136,32 @@ int zmq::socket_base_t::term_endpoint (const char *addr_)
 int zmq::socket_base_t::send (msg_t *msg_, int flags_)
 {
     scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+    return send_one (msg_, flags_);
+}
+
+int zmq::socket_base_t::send_many (msg_t *msgs_, size_t count_, int flags_)
+{
+    scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+
+    //  All but the last message are sent as a batch, so that each peer is
+    //  woken up once for the whole array.
+    size_t sent = 0;
+    while (sent != count_) {
+        const int flags = sent + 1 == count_ ? flags_ : flags_ | ZMQ_SNDBATCH;
+        if (send_one (&msgs_[sent], flags) != 0)
+            break;
+        sent++;
+    }
 
+    //  Sending stopped short of the last message.
+    if (!(flags_ & ZMQ_SNDBATCH))
+        flush_deferred ();
+
+    return sent ? (int) sent : -1;
+}
+
+int zmq::socket_base_t::send_one (msg_t *msg_, int flags_)
+{
     //  Check whether the library haven't been shut down yet.
     if (unlikely (ctx_terminated)) {
         errno = ETERM;
@@ -1129,18 +1189,39 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
 
     msg_->reset_metadata ();
 
-    //  Try to send the message using method in each socket class
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    msg_->set_stamp (clock_t::now_ns ());
+#endif
+
+    //  The message is consumed by xsend; remember what to account for.
+    const size_t size = msg_->size ();
+    const uint64_t complete = (flags_ & ZMQ_SNDMORE) ? 0 : 1;
+
+    //  Try to send the message using method in each socket class. Pipes
+    //  written to as part of a batch are flushed once the batch is over.
+    deferred_flushes.active = (flags_ & ZMQ_SNDBATCH) != 0;
     rc = xsend (msg_);
+    deferred_flushes.active = false;
     if (rc == 0) {
+        stats.msgs_out.add (complete);
+        stats.bytes_out.add (size);
+        if (!(flags_ & ZMQ_SNDBATCH))
+            flush_deferred ();
         return 0;
     }
     if (unlikely (errno != EAGAIN)) {
         return -1;
     }
+    stats.mutes.add (1);
+
+    //  The peers cannot make room for more messages before they get
+    //  the ones batched so far.
+    flush_deferred ();
 
     //  In case of non-blocking send we'll simply propagate
     //  the error - including EAGAIN - up the stack.
     if ((flags_ & ZMQ_DONTWAIT) || options.sndtimeo == 0) {
+        stats.eagains.add (1);
         return -1;
     }
 
@@ -1165,19 +1246,60 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
         if (timeout > 0) {
             timeout = (int) (end - clock.now_ms ());
             if (timeout <= 0) {
+                stats.eagains.add (1);
                 errno = EAGAIN;
                 return -1;
             }
         }
     }
 
+    stats.msgs_out.add (complete);
+    stats.bytes_out.add (size);
     return 0;
 }
 
 int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
 {
     scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+    return recv_one (msg_, flags_);
+}
+
+int zmq::socket_base_t::recv_many (msg_t *msgs_, size_t count_, int flags_)
+{
+    scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+
+    //  Check all the messages up front, so that a message is never
+    //  received into an invalid one.
+    for (size_t i = 0; i != count_; i++)
+        if (unlikely (!msgs_[i].check ())) {
+            errno = EFAULT;
+            return -1;
+        }
+
+    //  Wait for the first message as recv does.
+    if (recv_one (&msgs_[0], flags_) != 0)
+        return -1;
 
+    //  Then take whatever is already queued, without waiting.
+    size_t received = 1;
+    while (received != count_) {
+        if (++ticks >= (options.adaptive_poll_rate ? poll_rate
+                                                   : (int) inbound_poll_rate)) {
+            if (unlikely (process_commands (0, false, true) != 0))
+                break;
+            ticks = 0;
+        }
+        if (xrecv (&msgs_[received]) != 0)
+            break;
+        extract_flags (&msgs_[received]);
+        received++;
+    }
+
+    return (int) received;
+}
+
+int zmq::socket_base_t::recv_one (msg_t *msg_, int flags_)
+{
     //  Check whether the library haven't been shut down yet.
     if (unlikely (ctx_terminated)) {
         errno = ETERM;
@@ -1198,8 +1320,9 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
     //  Note that 'recv' uses different command throttling algorithm (the one
     //  described above) from the one used by 'send'. This is because counting
     //  ticks is more efficient than doing RDTSC all the time.
-    if (++ticks == inbound_poll_rate) {
-        if (unlikely (process_commands (0, false) != 0)) {
+    if (++ticks
+        >= (options.adaptive_poll_rate ? poll_rate : (int) inbound_poll_rate)) {
+        if (unlikely (process_commands (0, false, true) != 0)) {
             return -1;
         }
         ticks = 0;
@@ -1229,6 +1352,8 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
 
         rc = xrecv (msg_);
         if (rc < 0) {
+            if (errno == EAGAIN)
+                stats.eagains.add (1);
             return rc;
         }
         extract_flags (msg_);
@@ -1241,6 +1366,38 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
     int timeout = options.rcvtimeo;
     uint64_t end = timeout < 0 ? 0 : (clock.now_ms () + timeout);
 
+    //  If busy polling is enabled, keep checking for messages for a while
+    //  before falling asleep on the mailbox. Commands are only processed
+    //  once the mailbox reports some are available.
+    if (options.busy_poll_us > 0 && !thread_safe) {
+        const uint64_t spin_end = clock.now_us () + options.busy_poll_us;
+        do {
+            if (((mailbox_t *) mailbox)->check_read ()
+                && unlikely (process_commands (0, false) != 0)) {
+                return -1;
+            }
+            rc = xrecv (msg_);
+            if (rc == 0) {
+                ticks = 0;
+                extract_flags (msg_);
+                return 0;
+            }
+            if (unlikely (errno != EAGAIN)) {
+                return -1;
+            }
+        } while (clock.now_us () < spin_end
+                 && (timeout < 0 || clock.now_ms () < end));
+
+        if (timeout > 0) {
+            timeout = (int) (end - clock.now_ms ());
+            if (timeout <= 0) {
+                stats.eagains.add (1);
+                errno = EAGAIN;
+                return -1;
+            }
+        }
+    }
+
     //  In blocking scenario, commands are processed over and over again until
     //  we are able to fetch a message.
     bool block = (ticks != 0);
@@ -1260,6 +1417,7 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
         if (timeout > 0) {
             timeout = (int) (end - clock.now_ms ());
             if (timeout <= 0) {
+                stats.eagains.add (1);
                 errno = EAGAIN;
                 return -1;
             }
@@ -1332,7 +1490,9 @@ void zmq::socket_base_t::start_reaping (poller_t *poller_)
     check_destroy ();
 }
 
-int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
+int zmq::socket_base_t::process_commands (int timeout_,
+                                          bool throttle_,
+                                          bool adapt_)
 {
     int rc;
     command_t cmd;
@@ -1356,13 +1516,19 @@ int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
             //  Check whether TSC haven't jumped backwards (in case of migration
             //  between CPU cores) and whether certain time have elapsed since
             //  last command processing. If it didn't do nothing.
-            if (tsc >= last_tsc && tsc - last_tsc <= max_command_delay)
+            const uint64_t delay =
+              options.adaptive_poll_rate ? command_delay
+                                         : (uint64_t) max_command_delay;
+            if (tsc >= last_tsc && tsc - last_tsc <= delay)
                 return 0;
             last_tsc = tsc;
         }
 
         //  Check whether there are any commands pending for this thread.
         rc = mailbox->recv (&cmd, 0);
+
+        if ((throttle_ || adapt_) && options.adaptive_poll_rate)
+            adapt_poll_rate (rc == 0);
     }
 
     //  Process all available commands.
@@ -1384,6 +1550,21 @@ int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
     return 0;
 }
 
+void zmq::socket_base_t::adapt_poll_rate (bool commands_found_)
+{
+    if (commands_found_)
+        poll_rate = std::max (poll_rate / 2, (int) min_inbound_poll_rate);
+    else
+        poll_rate =
+          std::min (poll_rate + poll_rate / 8 + 1, (int) max_inbound_poll_rate);
+
+    //  Sends check for commands by time rather than by message count.
+    //  Scale the delay with the interval, but never beyond the fixed one.
+    command_delay = (uint64_t) max_command_delay
+                    * std::min (poll_rate, (int) inbound_poll_rate)
+                    / inbound_poll_rate;
+}
+
 void zmq::socket_base_t::process_stop ()
 {
     //  Here, someone have called zmq_ctx_term while the socket was still alive.
@@ -1474,6 +1655,17 @@ int zmq::socket_base_t::xleave (const char *group_)
     return -1;
 }
 
+int zmq::socket_base_t::xlookup_peer (const void *routing_id_,
+                                      size_t routing_id_size_,
+                                      pipe_t **pipe_)
+{
+    LIBZMQ_UNUSED (routing_id_);
+    LIBZMQ_UNUSED (routing_id_size_);
+    LIBZMQ_UNUSED (pipe_);
+    errno = ENOTSUP;
+    return -1;
+}
+
 int zmq::socket_base_t::xrecv (msg_t *)
 {
     errno = ENOTSUP;
@@ -1593,6 +1785,65 @@ void zmq::socket_base_t::extract_flags (msg_t *msg_)
 
     //  Remove MORE flag.
     rcvmore = msg_->flags () & msg_t::more ? true : false;
+
+    if (!rcvmore)
+        stats.msgs_in.add (1);
+    stats.bytes_in.add (msg_->size ());
+
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    if (msg_->stamp ())
+        stats.latency[latency_pipe_in].record (clock_t::now_ns ()
+                                               - msg_->stamp ());
+#endif
+}
+
+void zmq::socket_base_t::flush_deferred ()
+{
+    if (likely (deferred_flushes.pipes.empty ()))
+        return;
+
+    for (size_t i = 0; i != deferred_flushes.pipes.size (); i++)
+        deferred_flushes.pipes[i]->deferred_flush ();
+    deferred_flushes.pipes.clear ();
+}
+
+int zmq::socket_base_t::get_linger ()
+{
+    return options.linger.load ();
+}
+
+zmq::socket_stats_t &zmq::socket_base_t::get_stats ()
+{
+    return stats;
+}
+
+void zmq::socket_base_t::snapshot_stats (stats_snapshot_t *stats_)
+{
+    //  The counters may be read while another thread uses the socket.
+    stats_->msgs_in = stats.msgs_in.get ();
+    stats_->bytes_in = stats.bytes_in.get ();
+    stats_->msgs_out = stats.msgs_out.get ();
+    stats_->bytes_out = stats.bytes_out.get ();
+    stats_->hwm_drops = stats.hwm_drops.get ();
+    stats_->eagains = stats.eagains.get ();
+    stats_->reconnects = stats.reconnects.get ();
+    stats_->mutes = stats.mutes.get ();
+    stats_->queue_depth = stats.queue_depth.get ();
+    stats_->zerocopy_writes = stats.zerocopy_writes.get ();
+}
+
+int zmq::socket_base_t::snapshot_peer_stats (const void *routing_id_,
+                                             size_t routing_id_size_,
+                                             stats_snapshot_t *stats_)
+{
+    scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+
+    pipe_t *pipe;
+    const int rc = xlookup_peer (routing_id_, routing_id_size_, &pipe);
+    if (rc != 0)
+        return rc;
+    pipe->get_stats (stats_);
+    return 0;
 }
 
 int zmq::socket_base_t::monitor (const char *addr_, int events_)
@@ -45,6 +45,7 @@
 #include "stdint.hpp"
 #include "clock.hpp"
 #include "pipe.hpp"
+#include "socket_stats.hpp"
 
 extern "C" {
 void zmq_free_event (void *data, void *hint);
@@ -86,6 +87,11 @@ class socket_base_t : public own_t,
     int term_endpoint (const char *addr_);
     int send (zmq::msg_t *msg_, int flags_);
     int recv (zmq::msg_t *msg_, int flags_);
+
+    //  Send or receive up to count_ messages under a single lock. Return
+    //  the number of messages transferred, or -1 if there were none.
+    int send_many (zmq::msg_t *msgs_, size_t count_, int flags_);
+    int recv_many (zmq::msg_t *msgs_, size_t count_, int flags_);
     void add_signaler (signaler_t *s);
     void remove_signaler (signaler_t *s);
     int close ();
@@ -99,6 +105,10 @@ class socket_base_t : public own_t,
     int join (const char *group);
     int leave (const char *group);
 
+    //  Moves the socket's connections to the I/O threads chosen for
+    //  the affinity_ bitmask.
+    int migrate (uint64_t affinity_);
+
     //  Using this function reaper thread ask the socket to register with
     //  its poller.
     void start_reaping (poller_t *poller_);
@@ -139,6 +149,20 @@ class socket_base_t : public own_t,
     virtual int get_peer_state (const void *identity,
                                 size_t identity_size) const;
 
+    //  Current ZMQ_LINGER value. It may be read from any thread.
+    int get_linger ();
+
+    //  Statistics of the socket. Other threads may only use the ones
+    //  that are not plain counters.
+    socket_stats_t &get_stats ();
+
+    //  Copy the statistics of the socket, or of the pipe to the peer
+    //  with the given routing id, on behalf of the socket's user.
+    void snapshot_stats (stats_snapshot_t *stats_);
+    int snapshot_peer_stats (const void *routing_id_,
+                             size_t routing_id_size_,
+                             stats_snapshot_t *stats_);
+
   protected:
     socket_base_t (zmq::ctx_t *parent_,
                    uint32_t tid_,
@@ -180,6 +204,12 @@ class socket_base_t : public own_t,
     virtual int xjoin (const char *group_);
     virtual int xleave (const char *group_);
 
+    //  Finds the pipe to the peer with the given routing id. The default
+    //  implementation assumes peers cannot be addressed.
+    virtual int xlookup_peer (const void *routing_id_,
+                              size_t routing_id_size_,
+                              pipe_t **pipe_);
+
     //  Delay actual destruction of the socket.
     void process_destroy ();
 
@@ -213,7 +243,8 @@ class socket_base_t : public own_t,
     void check_destroy ();
 
     //  Moves the flags from the message to local variables,
-    //  to be later retrieved by getsockopt.
+    //  to be later retrieved by getsockopt, and accounts for the
+    //  received message in the statistics.
     void extract_flags (msg_t *msg_);
 
     //  Used to check whether the object is a socket.
@@ -241,8 +272,22 @@ class socket_base_t : public own_t,
     //  Processes commands sent to this socket (if any). If timeout is -1,
     //  returns only after at least one command was processed.
     //  If throttle argument is true, commands are processed at most once
-    //  in a predefined time period.
-    int process_commands (int timeout_, bool throttle_);
+    //  in a predefined time period. If adapt argument is true, the check
+    //  for commands is a periodic one and its outcome is used to adapt
+    //  the polling interval.
+    int process_commands (int timeout_, bool throttle_, bool adapt_ = false);
+
+    //  Shortens the polling interval if commands were found by a periodic
+    //  check and lengthens it otherwise.
+    void adapt_poll_rate (bool commands_found_);
+
+    //  Flushes the pipes whose flushes were deferred by batched sends,
+    //  waking their readers up.
+    void flush_deferred ();
+
+    //  send and recv without locking the socket.
+    int send_one (msg_t *msg_, int flags_);
+    int recv_one (msg_t *msg_, int flags_);
 
     //  Handlers for incoming commands.
     void process_stop ();
@@ -269,9 +314,20 @@ class socket_base_t : public own_t,
     //  Number of messages received since last command processing.
     int ticks;
 
+    //  Number of messages to receive, and CPU ticks to wait while sending,
+    //  between checks for commands when ZMQ_ADAPTIVE_POLL_RATE is set.
+    int poll_rate;
+    uint64_t command_delay;
+
     //  True if the last message received had MORE flag set.
     bool rcvmore;
 
+    //  Traffic statistics, see zmq_socket_stats.
+    socket_stats_t stats;
+
+    //  Pipes written to by sends with ZMQ_SNDBATCH and not flushed yet.
+    deferred_flushes_t deferred_flushes;
+
     //  Improves efficiency of time measurement.
     clock_t clock;
 
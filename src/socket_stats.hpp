@@ -0,0 +1,325 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SOCKET_STATS_HPP_INCLUDED__
+#define __ZMQ_SOCKET_STATS_HPP_INCLUDED__
+
+#include "stdint.hpp"
+
+#if defined ZMQ_FORCE_MUTEXES
+#define ZMQ_STAT_COUNTER_MUTEX
+#elif defined ZMQ_HAVE_ATOMIC_INTRINSICS
+#define ZMQ_STAT_COUNTER_INTRINSIC
+#elif (defined __cplusplus && __cplusplus >= 201103L)                          \
+  || (defined _MSC_VER && _MSC_VER >= 1900)
+#define ZMQ_STAT_COUNTER_CXX11
+#else
+#define ZMQ_STAT_COUNTER_MUTEX
+#endif
+
+#if defined ZMQ_STAT_COUNTER_MUTEX
+#include "mutex.hpp"
+#elif defined ZMQ_STAT_COUNTER_CXX11
+#include <atomic>
+#endif
+
+namespace zmq
+{
+//  64-bit statistics counter. Updates are relaxed atomic operations so
+//  that the counter can be read from any thread at any time without
+//  ordering any other memory accesses on the hot path.
+
+class stat_counter_t
+{
+  public:
+    inline stat_counter_t () : value (0) {}
+
+    //  Adds increment_ to the counter. Gauges are decreased by adding
+    //  the two's complement of the decrement.
+    inline void add (uint64_t increment_)
+    {
+#if defined ZMQ_STAT_COUNTER_INTRINSIC
+        __atomic_fetch_add (&value, increment_, __ATOMIC_RELAXED);
+#elif defined ZMQ_STAT_COUNTER_CXX11
+        value.fetch_add (increment_, std::memory_order_relaxed);
+#else
+        sync.lock ();
+        value += increment_;
+        sync.unlock ();
+#endif
+    }
+
+    inline uint64_t get ()
+    {
+#if defined ZMQ_STAT_COUNTER_INTRINSIC
+        return __atomic_load_n (&value, __ATOMIC_RELAXED);
+#elif defined ZMQ_STAT_COUNTER_CXX11
+        return value.load (std::memory_order_relaxed);
+#else
+        sync.lock ();
+        uint64_t result = value;
+        sync.unlock ();
+        return result;
+#endif
+    }
+
+  private:
+#if defined ZMQ_STAT_COUNTER_CXX11
+    std::atomic<uint64_t> value;
+#else
+    uint64_t value;
+#endif
+
+#if defined ZMQ_STAT_COUNTER_MUTEX
+    mutex_t sync;
+#endif
+
+    stat_counter_t (const stat_counter_t &);
+    const stat_counter_t &operator= (const stat_counter_t &);
+};
+
+//  64-bit statistics counter updated by a single thread at a time, the
+//  one using the socket, and read from any thread. Updates are a relaxed
+//  load and store rather than an atomic read-modify-write, so they cost
+//  no more than updating a plain integer.
+
+class owned_stat_counter_t
+{
+  public:
+    inline owned_stat_counter_t () : value (0) {}
+
+    //  Adds increment_ to the counter. Gauges are decreased by adding
+    //  the two's complement of the decrement.
+    inline void add (uint64_t increment_)
+    {
+#if defined ZMQ_STAT_COUNTER_INTRINSIC
+        __atomic_store_n (&value,
+                          __atomic_load_n (&value, __ATOMIC_RELAXED)
+                            + increment_,
+                          __ATOMIC_RELAXED);
+#elif defined ZMQ_STAT_COUNTER_CXX11
+        value.store (value.load (std::memory_order_relaxed) + increment_,
+                     std::memory_order_relaxed);
+#else
+        sync.lock ();
+        value += increment_;
+        sync.unlock ();
+#endif
+    }
+
+    inline uint64_t get ()
+    {
+#if defined ZMQ_STAT_COUNTER_INTRINSIC
+        return __atomic_load_n (&value, __ATOMIC_RELAXED);
+#elif defined ZMQ_STAT_COUNTER_CXX11
+        return value.load (std::memory_order_relaxed);
+#else
+        sync.lock ();
+        uint64_t result = value;
+        sync.unlock ();
+        return result;
+#endif
+    }
+
+  private:
+#if defined ZMQ_STAT_COUNTER_CXX11
+    std::atomic<uint64_t> value;
+#else
+    uint64_t value;
+#endif
+
+#if defined ZMQ_STAT_COUNTER_MUTEX
+    mutex_t sync;
+#endif
+
+    owned_stat_counter_t (const owned_stat_counter_t &);
+    const owned_stat_counter_t &operator= (const owned_stat_counter_t &);
+};
+
+#ifdef ZMQ_BUILD_LATENCY_STATS
+
+//  Log-linear histogram of latencies in nanoseconds. Each power of two
+//  is split into sub_buckets equal buckets, so that every bucket is at
+//  most 1/sub_buckets wide relative to its values, as in HDR histograms.
+
+class latency_histogram_t
+{
+  public:
+    enum
+    {
+        sub_buckets = 4,
+        buckets = 64 * sub_buckets
+    };
+
+    inline void record (uint64_t value_)
+    {
+        counts[bucket (value_)].add (1);
+        total.add (1);
+    }
+
+    inline uint64_t count () { return total.get (); }
+
+    //  Returns the highest value that falls into the same bucket as the
+    //  sample at the given percentile (0 to 100), or 0 if the histogram
+    //  is empty. Concurrent updates may make the result slightly stale.
+    inline uint64_t percentile (double percentile_)
+    {
+        const uint64_t samples = total.get ();
+        if (samples == 0)
+            return 0;
+        uint64_t rank = (uint64_t) (samples * percentile_ / 100.0 + 0.5);
+        if (rank == 0)
+            rank = 1;
+        uint64_t seen = 0;
+        int last = 0;
+        for (int i = 0; i != buckets; i++) {
+            const uint64_t n = counts[i].get ();
+            if (n == 0)
+                continue;
+            last = i;
+            seen += n;
+            if (seen >= rank)
+                return highest_value (i);
+        }
+        return highest_value (last);
+    }
+
+  private:
+    static inline int bucket (uint64_t value_)
+    {
+        if (value_ < sub_buckets)
+            return (int) value_;
+#if defined __GNUC__
+        const int msb = 63 - __builtin_clzll (value_);
+#else
+        int msb = 0;
+        for (uint64_t v = value_; v > 1; v >>= 1)
+            msb++;
+#endif
+        //  sub_buckets is 2^2.
+        const int shift = msb - 2;
+        return (shift + 1) * sub_buckets
+               + (int) ((value_ >> shift) & (sub_buckets - 1));
+    }
+
+    static inline uint64_t highest_value (int bucket_)
+    {
+        if (bucket_ < sub_buckets)
+            return (uint64_t) bucket_;
+        const int shift = bucket_ / sub_buckets - 1;
+        const uint64_t lowest = (uint64_t) (sub_buckets + bucket_ % sub_buckets)
+                                << shift;
+        return lowest + ((uint64_t) 1 << shift) - 1;
+    }
+
+    stat_counter_t counts[buckets];
+    stat_counter_t total;
+};
+
+//  Stages of a message's way through the library. The values match the
+//  ZMQ_LATENCY_* constants.
+enum latency_stage_t
+{
+    //  From zmq_send to the write into a pipe.
+    latency_send = 0,
+    //  From the write into a pipe to the engine encoding the message.
+    latency_pipe_out = 1,
+    //  From encoding a batch to the batch being written to the network.
+    latency_wire_out = 2,
+    //  From reading a batch from the network to decoding the message.
+    latency_wire_in = 3,
+    //  From the write into a pipe to zmq_recv returning the message.
+    latency_pipe_in = 4,
+    latency_stages = 5
+};
+
+#endif
+
+//  Statistics of a socket or of the pipe to one of its peers, as copied
+//  out by zmq_socket_stats and zmq_socket_peer_stats.
+struct stats_snapshot_t
+{
+    uint64_t msgs_in;
+    uint64_t bytes_in;
+    uint64_t msgs_out;
+    uint64_t bytes_out;
+    uint64_t hwm_drops;
+    uint64_t eagains;
+    uint64_t reconnects;
+    uint64_t mutes;
+    uint64_t queue_depth;
+    uint64_t zerocopy_writes;
+};
+
+//  Statistics kept by each socket, see zmq_socket_stats. The owned
+//  counters are updated by the thread using the socket, like the rest of
+//  its state; the others from the I/O threads as well. All of them may
+//  be read from any thread.
+struct socket_stats_t
+{
+    //  Complete messages and bytes received and sent by the application.
+    owned_stat_counter_t msgs_in;
+    owned_stat_counter_t bytes_in;
+    owned_stat_counter_t msgs_out;
+    owned_stat_counter_t bytes_out;
+
+    //  Message copies dropped because the pipe to a peer was full,
+    //  including those to peers no longer connected.
+    owned_stat_counter_t hwm_drops;
+
+    //  Send and receive calls that failed with EAGAIN.
+    owned_stat_counter_t eagains;
+
+    //  Sends that found the socket in the mute state, whether they then
+    //  blocked or failed.
+    owned_stat_counter_t mutes;
+
+    //  Messages written to the pipes that the peers have not read yet,
+    //  kept up to date by the pipes.
+    owned_stat_counter_t queue_depth;
+
+    //  Connections re-established after being lost.
+    stat_counter_t reconnects;
+
+    //  Message parts the kernel transmitted without copying them.
+    stat_counter_t zerocopy_writes;
+
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    //  Per-stage latencies of message parts passing the socket, see
+    //  zmq_socket_latency.
+    latency_histogram_t latency[latency_stages];
+#endif
+};
+}
+
+#undef ZMQ_STAT_COUNTER_MUTEX
+#undef ZMQ_STAT_COUNTER_INTRINSIC
+#undef ZMQ_STAT_COUNTER_CXX11
+
+#endif
@@ -85,8 +85,8 @@ void zmq::stream_t::xread_activated (pipe_t *pipe_)
 
 void zmq::stream_t::xwrite_activated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
+    outpipes_t::iterator it = outpipes.begin ();
+    for (; it != outpipes.end (); ++it)
         if (it->second.pipe == pipe_)
             break;
 
@@ -171,6 +171,20 @@ int zmq::stream_t::xsend (msg_t *msg_)
     return 0;
 }
 
+int zmq::stream_t::xlookup_peer (const void *routing_id_,
+                                 size_t routing_id_size_,
+                                 pipe_t **pipe_)
+{
+    blob_t routing_id_blob ((unsigned char *) routing_id_, routing_id_size_);
+    outpipes_t::const_iterator it = outpipes.find (routing_id_blob);
+    if (it == outpipes.end ()) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+    *pipe_ = it->second.pipe;
+    return 0;
+}
+
 int zmq::stream_t::xsetsockopt (int option_,
                                 const void *optval_,
                                 size_t optvallen_)
@@ -312,8 +326,6 @@ void zmq::stream_t::identify_peer (pipe_t *pipe_)
     pipe_->set_router_socket_routing_id (routing_id);
     //  Add the record into output pipes lookup table
     outpipe_t outpipe = {pipe_, true};
-    const bool ok =
-      outpipes.ZMQ_MAP_INSERT_OR_EMPLACE (ZMQ_MOVE (routing_id), outpipe)
-        .second;
+    const bool ok = outpipes.insert (routing_id, outpipe);
     zmq_assert (ok);
 }
@@ -30,9 +30,8 @@
 #ifndef __ZMQ_STREAM_HPP_INCLUDED__
 #define __ZMQ_STREAM_HPP_INCLUDED__
 
-#include <map>
-
 #include "router.hpp"
+#include "blob_map.hpp"
 
 namespace zmq
 {
@@ -54,6 +53,9 @@ class stream_t : public socket_base_t
     void xread_activated (zmq::pipe_t *pipe_);
     void xwrite_activated (zmq::pipe_t *pipe_);
     void xpipe_terminated (zmq::pipe_t *pipe_);
+    int xlookup_peer (const void *routing_id_,
+                      size_t routing_id_size_,
+                      zmq::pipe_t **pipe_);
     int xsetsockopt (int option_, const void *optval_, size_t optvallen_);
 
   private:
@@ -83,7 +85,7 @@ class stream_t : public socket_base_t
     };
 
     //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<blob_t, outpipe_t> outpipes_t;
+    typedef blob_map_t<outpipe_t> outpipes_t;
     outpipes_t outpipes;
 
     //  The pipe we are currently writing to.
@@ -62,18 +62,40 @@
 #include "likely.hpp"
 #include "wire.hpp"
 
+#ifdef ZMQ_BUILD_LATENCY_STATS
+#include "clock.hpp"
+#endif
+
 zmq::stream_engine_t::stream_engine_t (fd_t fd_,
                                        const options_t &options_,
                                        const std::string &endpoint_) :
     s (fd_),
-    as_server (false),
     handle ((handle_t) NULL),
+    io_error (false),
+    input_stopped (false),
+    as_server (false),
     inpos (NULL),
     insize (0),
     decoder (NULL),
     outpos (NULL),
     outsize (0),
     encoder (NULL),
+    in_batch_limit (options_.in_batch_size,
+                    options_.adaptive_batch_size,
+                    in_batch_size),
+    out_batch_limit (options_.out_batch_size,
+                     options_.adaptive_batch_size,
+                     out_batch_size),
+    gatherpos (NULL),
+    gathersize (0),
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    in_stamp (0),
+    out_stamp (0),
+#endif
+    zerocopy (false),
+    zerocopy_count (0),
+    io_thread (NULL),
+    lingering (false),
     metadata (NULL),
     handshaking (true),
     greeting_size (v2_greeting_size),
@@ -84,12 +106,11 @@ zmq::stream_engine_t::stream_engine_t (fd_t fd_,
     plugged (false),
     next_msg (&stream_engine_t::routing_id_msg),
     process_msg (&stream_engine_t::process_routing_id_msg),
-    io_error (false),
     subscription_required (false),
     mechanism (NULL),
-    input_stopped (false),
     output_stopped (false),
     has_handshake_timer (false),
+    has_linger_timer (false),
     has_ttl_timer (false),
     has_timeout_timer (false),
     has_heartbeat_timer (false),
@@ -141,6 +162,22 @@ zmq::stream_engine_t::stream_engine_t (fd_t fd_,
 zmq::stream_engine_t::~stream_engine_t ()
 {
     zmq_assert (!plugged);
+    zmq_assert (!lingering);
+
+    //  Messages still referenced by the kernel cannot be released while
+    //  the data may be transmitted from them. Once the linger period is
+    //  over, reset the connection to discard unsent data.
+    if (!zerocopy_writes.empty ()) {
+        process_zerocopy_completions ();
+        if (!zerocopy_writes.empty () && s != retired_fd) {
+            struct linger lng;
+            lng.l_onoff = 1;
+            lng.l_linger = 0;
+            const int rc = setsockopt (s, SOL_SOCKET, SO_LINGER,
+                                       (const char *) &lng, sizeof lng);
+            LIBZMQ_UNUSED (rc);
+        }
+    }
 
     if (s != retired_fd) {
 #ifdef ZMQ_HAVE_WINDOWS
@@ -162,6 +199,12 @@ zmq::stream_engine_t::~stream_engine_t ()
     int rc = tx_msg.close ();
     errno_assert (rc == 0);
 
+    for (zerocopy_writes_t::iterator it = zerocopy_writes.begin ();
+         it != zerocopy_writes.end (); ++it) {
+        rc = it->msg.close ();
+        errno_assert (rc == 0);
+    }
+
     //  Drop reference to metadata and destroy it if we are
     //  the only user.
     if (metadata != NULL) {
@@ -188,16 +231,21 @@ void zmq::stream_engine_t::plug (io_thread_t *io_thread_,
     socket = session->get_socket ();
 
     //  Connect to I/O threads poller object.
+    io_thread = io_thread_;
     io_object_t::plug (io_thread_);
     handle = add_fd (s);
     io_error = false;
 
+    if (options.tcp_zerocopy_threshold > 0)
+        zerocopy = tcp_enable_zerocopy (s) == 0;
+
     if (options.raw_socket) {
         // no handshaking for raw sock, instantiate raw encoder and decoders
-        encoder = new (std::nothrow) raw_encoder_t (out_batch_size);
+        encoder = new (std::nothrow) raw_encoder_t (options.out_batch_size);
         alloc_assert (encoder);
+        encoder->set_gather_threshold (out_gather_threshold);
 
-        decoder = new (std::nothrow) raw_decoder_t (in_batch_size);
+        decoder = new (std::nothrow) raw_decoder_t (options.in_batch_size);
         alloc_assert (decoder);
 
         // disable handshaking for raw socket
@@ -242,6 +290,46 @@ void zmq::stream_engine_t::plug (io_thread_t *io_thread_,
     in_event ();
 }
 
+bool zmq::stream_engine_t::suspend ()
+{
+    zmq_assert (plugged);
+
+    //  Connections move only once the message flow has started.
+    if (handshaking || io_error)
+        return false;
+
+    //  The heartbeat timers are restarted in the new I/O thread. A TTL
+    //  timer is restarted by the next PING from the peer.
+    if (has_ttl_timer) {
+        cancel_timer (heartbeat_ttl_timer_id);
+        has_ttl_timer = false;
+    }
+    if (has_timeout_timer)
+        cancel_timer (heartbeat_timeout_timer_id);
+    if (has_heartbeat_timer)
+        cancel_timer (heartbeat_ivl_timer_id);
+
+    rm_fd (handle);
+    io_object_t::unplug ();
+    return true;
+}
+
+void zmq::stream_engine_t::resume (io_thread_t *io_thread_)
+{
+    io_thread = io_thread_;
+    io_object_t::plug (io_thread_);
+    handle = add_fd (s);
+    if (!input_stopped)
+        set_pollin (handle);
+    if (!output_stopped)
+        set_pollout (handle);
+
+    if (has_heartbeat_timer)
+        add_timer (options.heartbeat_interval, heartbeat_ivl_timer_id);
+    if (has_timeout_timer)
+        add_timer (heartbeat_timeout, heartbeat_timeout_timer_id);
+}
+
 void zmq::stream_engine_t::unplug ()
 {
     zmq_assert (plugged);
@@ -280,13 +368,66 @@ void zmq::stream_engine_t::unplug ()
 void zmq::stream_engine_t::terminate ()
 {
     unplug ();
-    delete this;
+    linger ();
+}
+
+void zmq::stream_engine_t::linger ()
+{
+    zmq_assert (!plugged);
+
+    //  The linger period of the socket applies to data the kernel has not
+    //  sent yet just as it does to queued messages. The socket outlives
+    //  its sessions, and so is still there to ask.
+    const int linger_ivl = socket->get_linger ();
+    socket = NULL;
+
+    if (!zerocopy_writes.empty ())
+        process_zerocopy_completions ();
+    if (zerocopy_writes.empty () || linger_ivl == 0) {
+        delete this;
+        return;
+    }
+
+    //  Completions are reported as socket errors, which are polled for
+    //  even with no events requested. The peer need not wait for them to
+    //  learn that no more data follow.
+    io_object_t::plug (io_thread);
+    handle = add_fd (s);
+#ifndef ZMQ_HAVE_WINDOWS
+    ::shutdown (s, SHUT_WR);
+#endif
+    lingering = true;
+    if (linger_ivl > 0) {
+        add_timer (linger_ivl, linger_timer_id);
+        has_linger_timer = true;
+    }
 }
 
 void zmq::stream_engine_t::in_event ()
 {
+    if (unlikely (lingering)) {
+        process_zerocopy_completions ();
+        if (zerocopy_writes.empty ()) {
+            if (has_linger_timer) {
+                cancel_timer (linger_timer_id);
+                has_linger_timer = false;
+            }
+            rm_fd (handle);
+            io_object_t::unplug ();
+            lingering = false;
+            delete this;
+        }
+        return;
+    }
+
     zmq_assert (!io_error);
 
+    //  Zero-copy completions are signalled as socket errors. Having
+    //  processed them, do not mistake them for an I/O error below.
+    if (unlikely (!zerocopy_writes.empty ()))
+        if (process_zerocopy_completions () && input_stopped)
+            return;
+
     //  If still handshaking, receive and process the greeting message.
     if (unlikely (handshaking))
         if (!handshake ())
@@ -309,8 +450,10 @@ void zmq::stream_engine_t::in_event ()
         //  number of bytes read will be always limited.
         size_t bufsize = 0;
         decoder->get_buffer (&inpos, &bufsize);
+        if (bufsize > in_batch_limit.get ())
+            bufsize = in_batch_limit.get ();
 
-        const int rc = tcp_read (s, inpos, bufsize);
+        const int rc = read (inpos, bufsize);
 
         if (rc == 0) {
             // connection closed by peer
@@ -326,6 +469,10 @@ void zmq::stream_engine_t::in_event ()
 
         //  Adjust input size
         insize = static_cast<size_t> (rc);
+#ifdef ZMQ_BUILD_LATENCY_STATS
+        in_stamp = clock_t::now_ns ();
+#endif
+        in_batch_limit.update (insize);
         // Adjust buffer size to received bytes
         decoder->resize_buffer (insize);
     }
@@ -340,6 +487,11 @@ void zmq::stream_engine_t::in_event ()
         insize -= processed;
         if (rc == 0 || rc == -1)
             break;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+        const uint64_t now = clock_t::now_ns ();
+        socket->get_stats ().latency[latency_wire_in].record (now - in_stamp);
+        decoder->msg ()->set_stamp (now);
+#endif
         rc = (this->*process_msg) (decoder->msg ());
         if (rc == -1)
             break;
@@ -364,7 +516,7 @@ void zmq::stream_engine_t::out_event ()
     zmq_assert (!io_error);
 
     //  If write buffer is empty, try to read new data from the encoder.
-    if (!outsize) {
+    if (!outsize && !gathersize) {
         //  Even when we stop polling as soon as there is no
         //  data to send, the poller may invoke out_event one
         //  more time due to 'speculative write' optimisation.
@@ -374,22 +526,41 @@ void zmq::stream_engine_t::out_event ()
         }
 
         outpos = NULL;
-        outsize = encoder->encode (&outpos, 0);
+        outsize = encoder->encode (&outpos, out_batch_limit.get ());
+        gathersize = encoder->gather (&gatherpos);
 
-        while (outsize < (size_t) out_batch_size) {
+        //  Once the encoder stops in front of a large message part, no more
+        //  messages can be batched until that part is written out.
+        while (!gathersize && outsize < out_batch_limit.get ()) {
             if ((this->*next_msg) (&tx_msg) == -1)
                 break;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+            if (tx_msg.stamp ()) {
+                const uint64_t now = clock_t::now_ns ();
+                socket->get_stats ().latency[latency_pipe_out].record (
+                  now - tx_msg.stamp ());
+                if (!out_stamp)
+                    out_stamp = now;
+            }
+#endif
             encoder->load_msg (&tx_msg);
             unsigned char *bufptr = outpos + outsize;
-            size_t n = encoder->encode (&bufptr, out_batch_size - outsize);
+            size_t n =
+              encoder->encode (&bufptr, out_batch_limit.get () - outsize);
             zmq_assert (n > 0);
             if (outpos == NULL)
                 outpos = bufptr;
             outsize += n;
+            gathersize = encoder->gather (&gatherpos);
         }
 
+        //  A batch cut short by a large message part says nothing about
+        //  the traffic.
+        if (!gathersize)
+            out_batch_limit.update (outsize);
+
         //  If there is no data to send, stop polling for output.
-        if (outsize == 0) {
+        if (outsize == 0 && gathersize == 0) {
             output_stopped = true;
             reset_pollout (handle);
             return;
@@ -401,7 +572,10 @@ void zmq::stream_engine_t::out_event ()
     //  arbitrarily large. However, we assume that underlying TCP layer has
     //  limited transmission buffer and thus the actual number of bytes
     //  written should be reasonably modest.
-    const int nbytes = tcp_write (s, outpos, outsize);
+    const int nbytes =
+      zerocopy && gathersize >= (size_t) options.tcp_zerocopy_threshold
+        ? write_zerocopy ()
+        : write (outpos, outsize, gatherpos, gathersize);
 
     //  IO error has occurred. We stop waiting for output events.
     //  The engine is not terminated until we detect input error;
@@ -411,8 +585,25 @@ void zmq::stream_engine_t::out_event ()
         return;
     }
 
-    outpos += nbytes;
-    outsize -= nbytes;
+    size_t written = static_cast<size_t> (nbytes);
+    if (written >= outsize) {
+        written -= outsize;
+        outpos += outsize;
+        outsize = 0;
+        gatherpos += written;
+        gathersize -= written;
+    } else {
+        outpos += written;
+        outsize -= written;
+    }
+
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    if (out_stamp && !outsize && !gathersize) {
+        socket->get_stats ().latency[latency_wire_out].record (
+          clock_t::now_ns () - out_stamp);
+        out_stamp = 0;
+    }
+#endif
 
     //  If we are still handshaking and there are no data
     //  to send, stop polling for output.
@@ -421,6 +612,76 @@ void zmq::stream_engine_t::out_event ()
             reset_pollout (handle);
 }
 
+int zmq::stream_engine_t::write_zerocopy ()
+{
+    //  The output batch is reused as soon as it is written, so it must
+    //  not be referenced by the kernel. Write it separately.
+    int nbytes = 0;
+    if (outsize) {
+        nbytes = tcp_write (s, outpos, outsize);
+        if (nbytes != (int) outsize)
+            return nbytes;
+    }
+
+    bool zerocopied = false;
+    const int rc = tcp_write_zerocopy (s, gatherpos, gathersize, &zerocopied);
+    if (rc == -1)
+        return -1;
+
+    //  The in-place part belongs to tx_msg. Keep a reference to it until
+    //  the kernel is done with the data.
+    if (zerocopied) {
+        socket->get_stats ().zerocopy_writes.add (1);
+        zerocopy_write_t zcw;
+        zcw.id = zerocopy_count++;
+        zcw.completed = false;
+        int rc2 = zcw.msg.init ();
+        errno_assert (rc2 == 0);
+        rc2 = zcw.msg.copy (tx_msg);
+        errno_assert (rc2 == 0);
+        zerocopy_writes.push_back (zcw);
+    }
+
+    return nbytes + rc;
+}
+
+int zmq::stream_engine_t::read (void *data_, size_t size_)
+{
+    return tcp_read (s, data_, size_);
+}
+
+int zmq::stream_engine_t::write (const void *data1_,
+                                 size_t size1_,
+                                 const void *data2_,
+                                 size_t size2_)
+{
+    return tcp_write_gather (s, data1_, size1_, data2_, size2_);
+}
+
+bool zmq::stream_engine_t::process_zerocopy_completions ()
+{
+    bool processed = false;
+    uint32_t lo;
+    uint32_t hi;
+    while (tcp_read_zerocopy_completion (s, &lo, &hi) == 0) {
+        processed = true;
+        for (zerocopy_writes_t::iterator it = zerocopy_writes.begin ();
+             it != zerocopy_writes.end (); ++it)
+            if ((int32_t) (it->id - lo) >= 0 && (int32_t) (hi - it->id) >= 0)
+                it->completed = true;
+    }
+
+    //  Completions may be reported out of order; release messages in
+    //  order of writing.
+    while (!zerocopy_writes.empty () && zerocopy_writes.front ().completed) {
+        const int rc = zerocopy_writes.front ().msg.close ();
+        errno_assert (rc == 0);
+        zerocopy_writes.pop_front ();
+    }
+
+    return processed;
+}
+
 void zmq::stream_engine_t::restart_output ()
 {
     if (unlikely (io_error))
@@ -461,6 +722,11 @@ void zmq::stream_engine_t::restart_input ()
         insize -= processed;
         if (rc == 0 || rc == -1)
             break;
+#ifdef ZMQ_BUILD_LATENCY_STATS
+        const uint64_t now = clock_t::now_ns ();
+        socket->get_stats ().latency[latency_wire_in].record (now - in_stamp);
+        decoder->msg ()->set_stamp (now);
+#endif
         rc = (this->*process_msg) (decoder->msg ());
         if (rc == -1)
             break;
@@ -488,8 +754,8 @@ bool zmq::stream_engine_t::handshake ()
     zmq_assert (greeting_bytes_read < greeting_size);
     //  Receive the greeting.
     while (greeting_bytes_read < greeting_size) {
-        const int n = tcp_read (s, greeting_recv + greeting_bytes_read,
-                                greeting_size - greeting_bytes_read);
+        const int n = read (greeting_recv + greeting_bytes_read,
+                            greeting_size - greeting_bytes_read);
         if (n == 0) {
             errno = EPIPE;
             error (connection_error);
@@ -574,11 +840,11 @@ bool zmq::stream_engine_t::handshake ()
             return false;
         }
 
-        encoder = new (std::nothrow) v1_encoder_t (out_batch_size);
+        encoder = new (std::nothrow) v1_encoder_t (options.out_batch_size);
         alloc_assert (encoder);
 
-        decoder =
-          new (std::nothrow) v1_decoder_t (in_batch_size, options.maxmsgsize);
+        decoder = new (std::nothrow)
+          v1_decoder_t (options.in_batch_size, options.maxmsgsize);
         alloc_assert (decoder);
 
         //  We have already sent the message header.
@@ -620,11 +886,11 @@ bool zmq::stream_engine_t::handshake ()
             return false;
         }
 
-        encoder = new (std::nothrow) v1_encoder_t (out_batch_size);
+        encoder = new (std::nothrow) v1_encoder_t (options.out_batch_size);
         alloc_assert (encoder);
 
-        decoder =
-          new (std::nothrow) v1_decoder_t (in_batch_size, options.maxmsgsize);
+        decoder = new (std::nothrow)
+          v1_decoder_t (options.in_batch_size, options.maxmsgsize);
         alloc_assert (decoder);
     } else if (greeting_recv[revision_pos] == ZMTP_2_0) {
         if (session->zap_enabled ()) {
@@ -633,18 +899,18 @@ bool zmq::stream_engine_t::handshake ()
             return false;
         }
 
-        encoder = new (std::nothrow) v2_encoder_t (out_batch_size);
+        encoder = new (std::nothrow) v2_encoder_t (options.out_batch_size);
         alloc_assert (encoder);
 
-        decoder =
-          new (std::nothrow) v2_decoder_t (in_batch_size, options.maxmsgsize);
+        decoder = new (std::nothrow)
+          v2_decoder_t (options.in_batch_size, options.maxmsgsize);
         alloc_assert (decoder);
     } else {
-        encoder = new (std::nothrow) v2_encoder_t (out_batch_size);
+        encoder = new (std::nothrow) v2_encoder_t (options.out_batch_size);
         alloc_assert (encoder);
 
-        decoder =
-          new (std::nothrow) v2_decoder_t (in_batch_size, options.maxmsgsize);
+        decoder = new (std::nothrow)
+          v2_decoder_t (options.in_batch_size, options.maxmsgsize);
         alloc_assert (decoder);
 
         if (options.mechanism == ZMQ_NULL
@@ -705,6 +971,9 @@ bool zmq::stream_engine_t::handshake ()
         process_msg = &stream_engine_t::process_handshake_command;
     }
 
+    //  Write large message parts in place rather than copying them.
+    encoder->set_gather_threshold (out_gather_threshold);
+
     // Start polling for output if necessary.
     if (outsize == 0)
         set_pollout (handle);
@@ -982,7 +1251,7 @@ void zmq::stream_engine_t::error (error_reason_t reason)
     session->flush ();
     session->engine_error (reason);
     unplug ();
-    delete this;
+    linger ();
 }
 
 void zmq::stream_engine_t::set_handshake_timer ()
@@ -1012,7 +1281,14 @@ bool zmq::stream_engine_t::init_properties (properties_t &properties)
 
 void zmq::stream_engine_t::timer_event (int id_)
 {
-    if (id_ == handshake_timer_id) {
+    if (id_ == linger_timer_id) {
+        //  The destructor resets the connection and releases the messages.
+        has_linger_timer = false;
+        rm_fd (handle);
+        io_object_t::unplug ();
+        lingering = false;
+        delete this;
+    } else if (id_ == handshake_timer_id) {
         has_handshake_timer = false;
         //  handshake timer expired before handshake completed, so engine fail
         error (timeout_error);
@@ -31,7 +31,9 @@
 #define __ZMQ_STREAM_ENGINE_HPP_INCLUDED__
 
 #include <stddef.h>
+#include <deque>
 
+#include "batch_limit.hpp"
 #include "fd.hpp"
 #include "i_engine.hpp"
 #include "io_object.hpp"
@@ -40,6 +42,7 @@
 #include "options.hpp"
 #include "socket_base.hpp"
 #include "metadata.hpp"
+#include "msg.hpp"
 
 namespace zmq
 {
@@ -79,6 +82,8 @@ class stream_engine_t : public io_object_t, public i_engine
     void restart_input ();
     void restart_output ();
     void zap_msg_available ();
+    bool suspend ();
+    void resume (zmq::io_thread_t *io_thread_);
     const char *get_endpoint () const;
 
     //  i_poll_events interface implementation.
@@ -86,10 +91,34 @@ class stream_engine_t : public io_object_t, public i_engine
     void out_event ();
     void timer_event (int id_);
 
-  private:
+  protected:
+    //  Reads up to size_ bytes from the connection. Returns the number of
+    //  bytes read, zero if the peer has closed the connection, or -1 with
+    //  errno set (EAGAIN if there are no data available at the moment).
+    virtual int read (void *data_, size_t size_);
+
+    //  Writes data from two buffers, one after another, to the connection.
+    //  Returns the number of bytes written (even zero is considered to be
+    //  a success), or -1 on error.
+    virtual int write (const void *data1_,
+                       size_t size1_,
+                       const void *data2_,
+                       size_t size2_);
+
     //  Unplug the engine from the session.
-    void unplug ();
+    virtual void unplug ();
+
+    //  Underlying socket.
+    fd_t s;
 
+    handle_t handle;
+
+    bool io_error;
+
+    //  True iff the engine couldn't consume the last decoded message.
+    bool input_stopped;
+
+  private:
     //  Function to handle network disconnections.
     void error (error_reason_t reason);
 
@@ -127,20 +156,29 @@ class stream_engine_t : public io_object_t, public i_engine
     typedef metadata_t::dict_t properties_t;
     bool init_properties (properties_t &properties);
 
+    //  Writes the output batch followed by the in-place message part,
+    //  handing the latter to the kernel without copying it.
+    int write_zerocopy ();
+
+    //  Releases messages whose zero-copy transmission has completed.
+    //  Returns true if any completion was processed.
+    bool process_zerocopy_completions ();
+
+    //  Deletes the engine once it is unplugged from the session. While
+    //  the kernel still references messages written without copying, the
+    //  engine stays in its I/O thread until their completions arrive or
+    //  the linger period runs out.
+    void linger ();
+
     int produce_ping_message (msg_t *msg_);
     int process_heartbeat_message (msg_t *msg_);
     int produce_pong_message (msg_t *msg_);
 
-    //  Underlying socket.
-    fd_t s;
-
     //  True iff this is server's engine.
     bool as_server;
 
     msg_t tx_msg;
 
-    handle_t handle;
-
     unsigned char *inpos;
     size_t insize;
     i_decoder *decoder;
@@ -149,6 +187,47 @@ class stream_engine_t : public io_object_t, public i_engine
     size_t outsize;
     i_encoder *encoder;
 
+    //  Maximal number of bytes to read or to batch for writing at once.
+    batch_limit_t in_batch_limit;
+    batch_limit_t out_batch_limit;
+
+    //  Large message part referenced in place by the encoder. It is
+    //  written right after the data in the output batch.
+    unsigned char *gatherpos;
+    size_t gathersize;
+
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    //  Times the data in the input buffer was read and the first message
+    //  of the output batch was encoded, 0 if the output batch is not
+    //  being timed.
+    uint64_t in_stamp;
+    uint64_t out_stamp;
+#endif
+
+    //  True iff zero-copy transmission is enabled on the socket.
+    bool zerocopy;
+
+    //  Message kept alive until the kernel completes zero-copy write
+    //  number 'id' (writes are numbered from zero).
+    struct zerocopy_write_t
+    {
+        uint32_t id;
+        bool completed;
+        msg_t msg;
+    };
+    typedef std::deque<zerocopy_write_t> zerocopy_writes_t;
+    zerocopy_writes_t zerocopy_writes;
+
+    //  Number of zero-copy writes issued so far.
+    uint32_t zerocopy_count;
+
+    //  I/O thread the engine is plugged into.
+    zmq::io_thread_t *io_thread;
+
+    //  True iff the engine, unplugged from the session, waits for its
+    //  zero-copy writes to complete.
+    bool lingering;
+
     //  Metadata to be attached to received messages. May be NULL.
     metadata_t *metadata;
 
@@ -189,8 +268,6 @@ class stream_engine_t : public io_object_t, public i_engine
 
     int (stream_engine_t::*process_msg) (msg_t *msg_);
 
-    bool io_error;
-
     //  Indicates whether the engine is to inject a phantom
     //  subscription message into the incoming stream.
     //  Needed to support old peers.
@@ -198,9 +275,6 @@ class stream_engine_t : public io_object_t, public i_engine
 
     mechanism_t *mechanism;
 
-    //  True iff the engine couldn't consume the last decoded message.
-    bool input_stopped;
-
     //  True iff the engine doesn't have any message to encode.
     bool output_stopped;
 
@@ -213,6 +287,14 @@ class stream_engine_t : public io_object_t, public i_engine
     //  True is linger timer is running.
     bool has_handshake_timer;
 
+    //  ID of the timer bounding how long the engine lingers.
+    enum
+    {
+        linger_timer_id = 0x41
+    };
+
+    bool has_linger_timer;
+
     //  Heartbeat stuff
     enum
     {
@@ -33,18 +33,28 @@
 #include "tcp.hpp"
 #include "err.hpp"
 
+#include <string.h>
+
 #if !defined ZMQ_HAVE_WINDOWS
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <sys/uio.h>
 #endif
 
 #if defined ZMQ_HAVE_OPENVMS
 #include <ioctl.h>
 #endif
 
+#if defined ZMQ_HAVE_LINUX && defined SO_ZEROCOPY && defined MSG_ZEROCOPY
+#include <linux/errqueue.h>
+#if defined SO_EE_ORIGIN_ZEROCOPY
+#define ZMQ_HAVE_TCP_ZEROCOPY
+#endif
+#endif
+
 int zmq::tune_tcp_socket (fd_t s_)
 {
     //  Disable Nagle's algorithm. We are doing data batching on 0MQ level,
@@ -247,6 +257,164 @@ int zmq::tcp_write (fd_t s_, const void *data_, size_t size_)
 #endif
 }
 
+int zmq::tcp_write_gather (fd_t s_,
+                           const void *data1_,
+                           size_t size1_,
+                           const void *data2_,
+                           size_t size2_)
+{
+    if (size1_ == 0)
+        return tcp_write (s_, data2_, size2_);
+    if (size2_ == 0)
+        return tcp_write (s_, data1_, size1_);
+
+#ifdef ZMQ_HAVE_WINDOWS
+
+    WSABUF bufs[2];
+    bufs[0].buf = (char *) data1_;
+    bufs[0].len = (ULONG) size1_;
+    bufs[1].buf = (char *) data2_;
+    bufs[1].len = (ULONG) size2_;
+
+    DWORD nbytes = 0;
+    const int rc = WSASend (s_, bufs, 2, &nbytes, 0, NULL, NULL);
+
+    //  The error handling mirrors tcp_write.
+    if (rc == SOCKET_ERROR) {
+        const int last_error = WSAGetLastError ();
+        if (last_error == WSAEWOULDBLOCK || last_error == WSAENOBUFS)
+            return 0;
+        wsa_assert (last_error == WSAENETDOWN || last_error == WSAENETRESET
+                    || last_error == WSAEHOSTUNREACH
+                    || last_error == WSAECONNABORTED
+                    || last_error == WSAETIMEDOUT
+                    || last_error == WSAECONNRESET);
+        return -1;
+    }
+
+    return static_cast<int> (nbytes);
+
+#else
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<void *> (data1_);
+    iov[0].iov_len = size1_;
+    iov[1].iov_base = const_cast<void *> (data2_);
+    iov[1].iov_len = size2_;
+
+    struct msghdr hdr;
+    memset (&hdr, 0, sizeof hdr);
+    hdr.msg_iov = iov;
+    hdr.msg_iovlen = 2;
+
+    const ssize_t nbytes = sendmsg (s_, &hdr, 0);
+
+    //  The error handling mirrors tcp_write.
+    if (nbytes == -1
+        && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return 0;
+
+    if (nbytes == -1) {
+        errno_assert (errno != EACCES && errno != EBADF && errno != EDESTADDRREQ
+                      && errno != EFAULT && errno != EISCONN
+                      && errno != EMSGSIZE && errno != ENOMEM
+                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
+        return -1;
+    }
+
+    return static_cast<int> (nbytes);
+
+#endif
+}
+
+int zmq::tcp_enable_zerocopy (fd_t s_)
+{
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    int on = 1;
+    return setsockopt (s_, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof on);
+#else
+    LIBZMQ_UNUSED (s_);
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
+int zmq::tcp_write_zerocopy (fd_t s_,
+                             const void *data_,
+                             size_t size_,
+                             bool *zerocopy_)
+{
+    *zerocopy_ = false;
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    const ssize_t nbytes = send (s_, data_, size_, MSG_ZEROCOPY);
+    if (nbytes > 0) {
+        *zerocopy_ = true;
+        return static_cast<int> (nbytes);
+    }
+
+    //  Out of memory for pinning user pages; fall back to a plain write.
+    //  Other errors are handled by tcp_write in the same way.
+    if (nbytes == -1 && errno == ENOBUFS)
+        return tcp_write (s_, data_, size_);
+    if (nbytes == -1
+        && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return 0;
+    if (nbytes == -1) {
+        errno_assert (errno != EACCES && errno != EBADF && errno != EDESTADDRREQ
+                      && errno != EFAULT && errno != EISCONN
+                      && errno != EMSGSIZE && errno != ENOMEM
+                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
+        return -1;
+    }
+    return static_cast<int> (nbytes);
+#else
+    return tcp_write (s_, data_, size_);
+#endif
+}
+
+int zmq::tcp_read_zerocopy_completion (fd_t s_, uint32_t *lo_, uint32_t *hi_)
+{
+#if defined ZMQ_HAVE_TCP_ZEROCOPY
+    char control[CMSG_SPACE (sizeof (struct sock_extended_err))
+                 + CMSG_SPACE (sizeof (struct sockaddr_in6))];
+    struct msghdr hdr;
+
+    while (true) {
+        memset (&hdr, 0, sizeof hdr);
+        hdr.msg_control = control;
+        hdr.msg_controllen = sizeof control;
+
+        const int rc = recvmsg (s_, &hdr, MSG_ERRQUEUE);
+        if (rc == -1) {
+            errno_assert (errno == EAGAIN || errno == EWOULDBLOCK
+                          || errno == EINTR);
+            return -1;
+        }
+
+        //  Skip anything that is not a zero-copy notification.
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR (&hdr); cm;
+             cm = CMSG_NXTHDR (&hdr, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                  || (cm->cmsg_level == SOL_IPV6
+                      && cm->cmsg_type == IPV6_RECVERR)))
+                continue;
+            const struct sock_extended_err *err =
+              (const struct sock_extended_err *) CMSG_DATA (cm);
+            if (err->ee_errno != 0
+                || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            *lo_ = err->ee_info;
+            *hi_ = err->ee_data;
+            return 0;
+        }
+    }
+#else
+    LIBZMQ_UNUSED (s_);
+    LIBZMQ_UNUSED (lo_);
+    LIBZMQ_UNUSED (hi_);
+    return -1;
+#endif
+}
+
 int zmq::tcp_read (fd_t s_, void *data_, size_t size_)
 {
 #ifdef ZMQ_HAVE_WINDOWS
@@ -31,6 +31,7 @@
 #define __ZMQ_TCP_HPP_INCLUDED__
 
 #include "fd.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
@@ -58,6 +59,32 @@ int tune_tcp_maxrt (fd_t sockfd_, int timeout_);
 //  of error or orderly shutdown by the other peer -1 is returned.
 int tcp_write (fd_t s_, const void *data_, size_t size_);
 
+//  Same as tcp_write, except that data are taken from two buffers, one
+//  after another, and written using a single system call.
+int tcp_write_gather (fd_t s_,
+                      const void *data1_,
+                      size_t size1_,
+                      const void *data2_,
+                      size_t size2_);
+
+//  Enables zero-copy transmission (MSG_ZEROCOPY) on the socket.
+//  Returns -1 if it is not supported by the OS or the socket type.
+int tcp_enable_zerocopy (fd_t s_);
+
+//  Same as tcp_write, except that the data are not copied into the kernel
+//  if possible. In that case zerocopy_ is set to true and the data must
+//  remain unchanged until the kernel reports completion of the write,
+//  see tcp_read_zerocopy_completion.
+int tcp_write_zerocopy (fd_t s_,
+                        const void *data_,
+                        size_t size_,
+                        bool *zerocopy_);
+
+//  Retrieves a zero-copy completion notification from the socket.
+//  Writes lo_ through hi_ (numbered from zero, in the order of zero-copy
+//  writes) have completed. Returns -1 if there are no pending completions.
+int tcp_read_zerocopy_completion (fd_t s_, uint32_t *lo_, uint32_t *hi_);
+
 //  Reads data from the socket (up to 'size' bytes).
 //  Returns the number of bytes actually read or -1 on error.
 //  Zero indicates the peer has closed the connection.
@@ -0,0 +1,309 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "precompiled.hpp"
+#include "timer_wheel.hpp"
+#include "i_poll_events.hpp"
+#include "err.hpp"
+
+const uint32_t zmq::timer_wheel_t::nil;
+
+zmq::timer_wheel_t::timer_wheel_t (uint64_t now_) :
+    current (now_),
+    free_nodes (nil),
+    count (0),
+    scheduled (0),
+    buckets (64, nil)
+{
+    for (int i = 0; i != lists; i++)
+        heads[i].head = heads[i].tail = nil;
+}
+
+zmq::timer_wheel_t::~timer_wheel_t ()
+{
+}
+
+bool zmq::timer_wheel_t::empty () const
+{
+    return count == 0;
+}
+
+void zmq::timer_wheel_t::add (uint64_t expiration_,
+                              i_poll_events *sink_,
+                              int id_)
+{
+    uint32_t node;
+    if (free_nodes != nil) {
+        node = free_nodes;
+        free_nodes = nodes[node].next;
+    } else {
+        nodes.push_back (node_t ());
+        node = static_cast<uint32_t> (nodes.size () - 1);
+    }
+    nodes[node].expiration = expiration_;
+    nodes[node].sink = sink_;
+    nodes[node].id = id_;
+
+    if (++count > buckets.size ())
+        rehash ();
+    const uint32_t b = bucket (sink_, id_);
+    nodes[node].bucket_next = buckets[b];
+    buckets[b] = node;
+
+    place (node);
+}
+
+void zmq::timer_wheel_t::cancel (i_poll_events *sink_, int id_)
+{
+    //  Find the timer to expire first among those matching.
+    uint32_t found = nil;
+    for (uint32_t node = buckets[bucket (sink_, id_)]; node != nil;
+         node = nodes[node].bucket_next)
+        if (nodes[node].sink == sink_ && nodes[node].id == id_
+            && (found == nil
+                || nodes[node].expiration < nodes[found].expiration))
+            found = node;
+
+    //  Timer not found.
+    zmq_assert (found != nil);
+
+    release (found);
+}
+
+uint64_t zmq::timer_wheel_t::execute (uint64_t now_)
+{
+    //  Timers added with expiration in the past go first.
+    while (heads[due_list].head != nil)
+        fire (due_list);
+
+    while (current <= now_) {
+        if (scheduled == 0) {
+            current = now_ + 1;
+            break;
+        }
+        tick (now_);
+    }
+
+    //  Timers the handlers have added with expiration in the past are
+    //  executed straight away.
+    while (heads[due_list].head != nil)
+        fire (due_list);
+
+    if (count == 0)
+        return 0;
+
+    const uint64_t wait = next_tick () - now_;
+    return wait < 0x7fffffff ? wait : 0x7fffffff;
+}
+
+uint64_t zmq::timer_wheel_t::next_tick () const
+{
+    //  Slots starting at current have not been cascaded yet.
+    const uint64_t top = slot_bits * levels;
+    if ((current & (((uint64_t) 1 << top) - 1)) == 0
+        && heads[overflow_list].head != nil)
+        return current;
+    for (int level = levels - 1; level != 0; level--) {
+        const int shift = slot_bits * level;
+        if ((current & (((uint64_t) 1 << shift) - 1)) == 0
+            && heads[level * slots
+                     + static_cast<uint32_t> ((current >> shift)
+                                              & (slots - 1))]
+                   .head
+                 != nil)
+            return current;
+    }
+
+    //  A timer on the lowest level expires at the tick of its slot. One
+    //  on a higher level expires no sooner than its slot is cascaded,
+    //  which happens after all the slots of the levels below are passed.
+    for (int level = 0; level != levels; level++) {
+        const int shift = slot_bits * level;
+        const uint64_t base = current >> (shift + slot_bits)
+                                          << (shift + slot_bits);
+        const uint32_t index =
+          static_cast<uint32_t> ((current >> shift) & (slots - 1));
+        for (uint32_t slot = level == 0 ? index : index + 1; slot < slots;
+             slot++)
+            if (heads[level * slots + slot].head != nil)
+                return base | (uint64_t) slot << shift;
+    }
+
+    //  Only timers beyond the top level are left.
+    return ((current >> top) + 1) << top;
+}
+
+void zmq::timer_wheel_t::place (uint32_t node_)
+{
+    const uint64_t expiration = nodes[node_].expiration;
+    if (expiration < current) {
+        link (due_list, node_);
+        return;
+    }
+
+    //  Use the lowest level whose slots are not yet passed by current
+    //  before the timer expires.
+    for (int level = 0; level != levels; level++) {
+        const int shift = slot_bits * level;
+        if (expiration >> (shift + slot_bits)
+            == current >> (shift + slot_bits)) {
+            link (level * slots
+                    + static_cast<uint32_t> ((expiration >> shift)
+                                             & (slots - 1)),
+                  node_);
+            return;
+        }
+    }
+    link (overflow_list, node_);
+}
+
+void zmq::timer_wheel_t::link (uint32_t list_, uint32_t node_)
+{
+    node_t &node = nodes[node_];
+    node.list = list_;
+    node.next = nil;
+    node.prev = heads[list_].tail;
+    if (node.prev == nil)
+        heads[list_].head = node_;
+    else
+        nodes[node.prev].next = node_;
+    heads[list_].tail = node_;
+
+    if (list_ != due_list)
+        scheduled++;
+}
+
+void zmq::timer_wheel_t::unlink (uint32_t node_)
+{
+    const node_t &node = nodes[node_];
+    if (node.prev == nil)
+        heads[node.list].head = node.next;
+    else
+        nodes[node.prev].next = node.next;
+    if (node.next == nil)
+        heads[node.list].tail = node.prev;
+    else
+        nodes[node.next].prev = node.prev;
+
+    if (node.list != due_list)
+        scheduled--;
+}
+
+void zmq::timer_wheel_t::release (uint32_t node_)
+{
+    uint32_t *prev = &buckets[bucket (nodes[node_].sink, nodes[node_].id)];
+    while (*prev != node_)
+        prev = &nodes[*prev].bucket_next;
+    *prev = nodes[node_].bucket_next;
+
+    unlink (node_);
+    nodes[node_].next = free_nodes;
+    free_nodes = node_;
+    count--;
+}
+
+void zmq::timer_wheel_t::fire (uint32_t list_)
+{
+    const uint32_t node = heads[list_].head;
+    i_poll_events *sink = nodes[node].sink;
+    const int id = nodes[node].id;
+
+    //  Release the timer before executing it, as the handler may well add
+    //  or cancel other timers.
+    release (node);
+    sink->timer_event (id);
+}
+
+void zmq::timer_wheel_t::cascade (uint32_t list_)
+{
+    //  Detach the list first, so that the timers to stay beyond the top
+    //  level do not get back into the list being processed.
+    uint32_t node = heads[list_].head;
+    heads[list_].head = heads[list_].tail = nil;
+    while (node != nil) {
+        const uint32_t next = nodes[node].next;
+        scheduled--;
+        place (node);
+        node = next;
+    }
+}
+
+void zmq::timer_wheel_t::tick (uint64_t now_)
+{
+    const uint64_t t = current;
+
+    //  Move the timers of the higher level slots starting at this tick
+    //  down, the highest level first, as its timers may land in a slot
+    //  of the level below that starts at this tick too.
+    if ((t & (((uint64_t) 1 << (slot_bits * levels)) - 1)) == 0)
+        cascade (overflow_list);
+    for (int level = levels - 1; level != 0; level--) {
+        const int shift = slot_bits * level;
+        if ((t & (((uint64_t) 1 << shift) - 1)) == 0)
+            cascade (level * slots
+                     + static_cast<uint32_t> ((t >> shift) & (slots - 1)));
+    }
+
+    const uint32_t slot = static_cast<uint32_t> (t & (slots - 1));
+    while (heads[slot].head != nil)
+        fire (slot);
+
+    //  Skip the ticks with nothing to do.
+    current = t + 1;
+    if (scheduled != 0) {
+        const uint64_t next = next_tick ();
+        current = next < now_ + 1 ? next : now_ + 1;
+    }
+}
+
+uint32_t zmq::timer_wheel_t::bucket (i_poll_events *sink_, int id_) const
+{
+    uint64_t hash = (uint64_t) (size_t) sink_ * 0x9e3779b97f4a7c15ULL;
+    hash ^= (uint64_t) (uint32_t) id_ * 0xc2b2ae3d27d4eb4fULL;
+    hash ^= hash >> 29;
+    return static_cast<uint32_t> (hash & (buckets.size () - 1));
+}
+
+void zmq::timer_wheel_t::rehash ()
+{
+    std::vector<uint32_t> old (buckets.size () * 2, nil);
+    buckets.swap (old);
+    for (std::vector<uint32_t>::const_iterator it = old.begin ();
+         it != old.end (); ++it) {
+        uint32_t node = *it;
+        while (node != nil) {
+            const uint32_t next = nodes[node].bucket_next;
+            const uint32_t b = bucket (nodes[node].sink, nodes[node].id);
+            nodes[node].bucket_next = buckets[b];
+            buckets[b] = node;
+            node = next;
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+#define __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+
+#include <vector>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+struct i_poll_events;
+
+//  Hierarchical timer wheel holding the timers of a poller. There are
+//  four levels of 256 slots; a slot on level n spans 256^n milliseconds,
+//  so the levels together cover 2^32 milliseconds ahead. Timers are
+//  moved one level down as their slot comes due. Adding and cancelling
+//  a timer takes constant time and the timers are kept in one vector
+//  of nodes, so there is no allocation per timer once the vector has
+//  grown large enough.
+class timer_wheel_t
+{
+  public:
+    //  now_ is the current time in milliseconds.
+    timer_wheel_t (uint64_t now_);
+    ~timer_wheel_t ();
+
+    bool empty () const;
+
+    //  Adds a timer to expire at expiration_ milliseconds. After the
+    //  expiration, timer_event on sink_ object will be called with
+    //  argument set to id_.
+    void add (uint64_t expiration_, i_poll_events *sink_, int id_);
+
+    //  Cancels the timer created by sink_ object with ID equal to id_.
+    //  If there are several such timers, the one to expire first is
+    //  cancelled.
+    void cancel (i_poll_events *sink_, int id_);
+
+    //  Executes the timers that are due at now_. Returns number of
+    //  milliseconds to wait before calling it again or 0 meaning
+    //  "no timers". The returned time may be shorter than the time
+    //  to the next expiration, if that timer is not on the lowest
+    //  level yet.
+    uint64_t execute (uint64_t now_);
+
+  private:
+    enum
+    {
+        slot_bits = 8,
+        slots = 1 << slot_bits,
+        levels = 4,
+
+        //  Besides the slots of the levels there are two more lists:
+        //  one for the timers beyond the top level and one for those
+        //  added with expiration in the past.
+        overflow_list = levels * slots,
+        due_list,
+        lists
+    };
+
+    static const uint32_t nil = 0xffffffff;
+
+    struct node_t
+    {
+        uint64_t expiration;
+        i_poll_events *sink;
+        int id;
+
+        //  Neighbours in the list the timer is in, or the next free node.
+        uint32_t prev;
+        uint32_t next;
+        uint32_t list;
+
+        //  Next node in the same hash bucket.
+        uint32_t bucket_next;
+    };
+
+    struct list_t
+    {
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    //  Puts the timer in the list for its expiration.
+    void place (uint32_t node_);
+
+    void link (uint32_t list_, uint32_t node_);
+    void unlink (uint32_t node_);
+
+    //  Removes the timer from its list and from the hash table, and
+    //  returns its node to the free ones.
+    void release (uint32_t node_);
+
+    //  Removes the first timer from the list and executes it.
+    void fire (uint32_t list_);
+
+    //  Moves the timers of the list one level down.
+    void cascade (uint32_t list_);
+
+    //  Returns the next tick that may have some work to do. There
+    //  must be some timers on the levels or in the overflow list.
+    uint64_t next_tick () const;
+
+    //  Processes the tick current, then advances current to the next
+    //  tick that may have some work to do.
+    void tick (uint64_t now_);
+
+    uint32_t bucket (i_poll_events *sink_, int id_) const;
+    void rehash ();
+
+    //  The tick, i.e. millisecond, to process next.
+    uint64_t current;
+
+    std::vector<node_t> nodes;
+    uint32_t free_nodes;
+
+    list_t heads[lists];
+
+    //  Number of timers, and number of timers on the levels or in the
+    //  overflow list.
+    size_t count;
+    size_t scheduled;
+
+    //  Hash table finding the timers by sink and ID, with the nodes of
+    //  each bucket chained by bucket_next.
+    std::vector<uint32_t> buckets;
+
+    timer_wheel_t (const timer_wheel_t &);
+    const timer_wheel_t &operator= (const timer_wheel_t &);
+};
+}
+
+#endif
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "precompiled.hpp"
+#include <limits.h>
 
 #if !defined ZMQ_HAVE_WINDOWS
 #include <sys/types.h>
@@ -51,7 +52,19 @@ zmq::udp_engine_t::udp_engine_t (const options_t &options_) :
     address (NULL),
     options (options_),
     send_enabled (false),
-    recv_enabled (false)
+    recv_enabled (false),
+#if defined HAVE_SENDMMSG
+    out_count (0),
+    out_next (0)
+#else
+    out_size (0)
+#endif
+#if defined HAVE_RECVMMSG
+    ,
+    in_batch (NULL),
+    in_count (0),
+    in_next (0)
+#endif
 {
 }
 
@@ -69,6 +82,19 @@ zmq::udp_engine_t::~udp_engine_t ()
 #endif
         fd = retired_fd;
     }
+
+#if defined HAVE_SENDMMSG
+    for (int i = out_next; i < out_count; i++) {
+        int rc = out_group_msgs[i].close ();
+        errno_assert (rc == 0);
+        rc = out_body_msgs[i].close ();
+        errno_assert (rc == 0);
+    }
+#endif
+
+#if defined HAVE_RECVMMSG
+    free (in_batch);
+#endif
 }
 
 int zmq::udp_engine_t::init (address_t *address_, bool send_, bool recv_)
@@ -86,6 +112,22 @@ int zmq::udp_engine_t::init (address_t *address_, bool send_, bool recv_)
 
     unblock_socket (fd);
 
+#if defined HAVE_RECVMMSG
+    if (recv_enabled) {
+        in_batch = (unsigned char *) malloc (udp_batch_size * MAX_UDP_MSG);
+        alloc_assert (in_batch);
+
+        memset (in_msgs, 0, sizeof in_msgs);
+        for (int i = 0; i < udp_batch_size; i++) {
+            in_iovs[i].iov_base = in_batch + i * MAX_UDP_MSG;
+            in_iovs[i].iov_len = MAX_UDP_MSG;
+            in_msgs[i].msg_hdr.msg_iov = &in_iovs[i];
+            in_msgs[i].msg_hdr.msg_iovlen = 1;
+            in_msgs[i].msg_hdr.msg_name = &in_addresses[i];
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -187,9 +229,11 @@ void zmq::udp_engine_t::sockaddr_to_msg (zmq::msg_t *msg, sockaddr_in *addr)
     strcat (address, port);
 }
 
-int zmq::udp_engine_t::resolve_raw_address (char *name_, size_t length_)
+int zmq::udp_engine_t::resolve_raw_address (char *name_,
+                                            size_t length_,
+                                            sockaddr_in *address_)
 {
-    memset (&raw_address, 0, sizeof raw_address);
+    memset (address_, 0, sizeof *address_);
 
     const char *delimiter = NULL;
 
@@ -220,11 +264,11 @@ int zmq::udp_engine_t::resolve_raw_address (char *name_, size_t length_)
         return -1;
     }
 
-    raw_address.sin_family = AF_INET;
-    raw_address.sin_port = htons (port);
-    raw_address.sin_addr.s_addr = inet_addr (addr_str.c_str ());
+    address_->sin_family = AF_INET;
+    address_->sin_port = htons (port);
+    address_->sin_addr.s_addr = inet_addr (addr_str.c_str ());
 
-    if (raw_address.sin_addr.s_addr == INADDR_NONE) {
+    if (address_->sin_addr.s_addr == INADDR_NONE) {
         errno = EINVAL;
         return -1;
     }
@@ -232,62 +276,168 @@ int zmq::udp_engine_t::resolve_raw_address (char *name_, size_t length_)
     return 0;
 }
 
-void zmq::udp_engine_t::out_event ()
+int zmq::udp_engine_t::pull_datagram (msg_t *group_msg_,
+                                      msg_t *body_msg_,
+                                      sockaddr_in *raw_address_)
 {
-    msg_t group_msg;
-    int rc = session->pull_msg (&group_msg);
-    errno_assert (rc == 0 || (rc == -1 && errno == EAGAIN));
+    while (true) {
+        int rc = session->pull_msg (group_msg_);
+        errno_assert (rc == 0 || (rc == -1 && errno == EAGAIN));
+        if (rc != 0)
+            return -1;
+
+        rc = session->pull_msg (body_msg_);
+
+        //  Raw datagrams carry the body only, others the group name and
+        //  its size as well.
+        const size_t group_size = group_msg_->size ();
+        const size_t body_size = body_msg_->size ();
+        bool valid;
+        if (options.raw_socket)
+            valid = body_size <= MAX_UDP_MSG
+                    && resolve_raw_address ((char *) group_msg_->data (),
+                                            group_size, raw_address_)
+                         == 0;
+        else
+            valid = group_size <= UCHAR_MAX
+                    && 1 + group_size + body_size <= MAX_UDP_MSG;
+        if (valid)
+            return 0;
+
+        //  We discard the message if it cannot be sent
+        rc = group_msg_->close ();
+        errno_assert (rc == 0);
 
-    if (rc == 0) {
-        msg_t body_msg;
-        rc = session->pull_msg (&body_msg);
+        rc = body_msg_->close ();
+        errno_assert (rc == 0);
+    }
+}
 
-        size_t group_size = group_msg.size ();
-        size_t body_size = body_msg.size ();
-        size_t size;
+bool zmq::udp_engine_t::send_pending ()
+{
+#if defined HAVE_SENDMMSG
+    while (out_next < out_count) {
+        const int rc =
+          sendmmsg (fd, out_msgs + out_next, out_count - out_next, 0);
+        if (rc == -1) {
+            errno_assert (errno == EAGAIN || errno == EWOULDBLOCK
+                          || errno == EINTR);
+            return false;
+        }
 
-        if (options.raw_socket) {
-            rc = resolve_raw_address ((char *) group_msg.data (), group_size);
+        for (int i = out_next; i < out_next + rc; i++) {
+            int rc2 = out_group_msgs[i].close ();
+            errno_assert (rc2 == 0);
 
-            //  We discard the message if address is not valid
-            if (rc != 0) {
-                rc = group_msg.close ();
-                errno_assert (rc == 0);
+            rc2 = out_body_msgs[i].close ();
+            errno_assert (rc2 == 0);
+        }
+        out_next += rc;
+    }
+#else
+    if (out_size == 0)
+        return true;
 
-                body_msg.close ();
-                errno_assert (rc == 0);
+#ifdef ZMQ_HAVE_WINDOWS
+    const int rc = sendto (fd, (const char *) out_buffer, (int) out_size, 0,
+                           out_address, (int) out_addrlen);
+    if (rc == SOCKET_ERROR) {
+        wsa_assert (WSAGetLastError () == WSAEWOULDBLOCK);
+        return false;
+    }
+#else
+    const ssize_t rc =
+      sendto (fd, out_buffer, out_size, 0, out_address, out_addrlen);
+    if (rc == -1) {
+        errno_assert (errno == EAGAIN || errno == EWOULDBLOCK
+                      || errno == EINTR);
+        return false;
+    }
+#endif
+    out_size = 0;
+#endif
+    return true;
+}
 
-                return;
-            }
+void zmq::udp_engine_t::out_event ()
+{
+    //  Datagrams the socket could not take before go first. Polling for
+    //  output goes on until they are sent.
+    if (!send_pending ())
+        return;
 
-            size = body_size;
+#if defined HAVE_SENDMMSG
+    //  Gather up to udp_batch_size datagrams straight from the messages
+    //  and hand them to the kernel in a single call.
+    out_count = 0;
+    out_next = 0;
+    while (out_count < udp_batch_size) {
+        msg_t *group_msg = &out_group_msgs[out_count];
+        msg_t *body_msg = &out_body_msgs[out_count];
+        if (pull_datagram (group_msg, body_msg, &out_addresses[out_count])
+            != 0)
+            break;
+
+        memset (&out_msgs[out_count], 0, sizeof out_msgs[out_count]);
+        struct msghdr *hdr = &out_msgs[out_count].msg_hdr;
+        struct iovec *iov = out_iovs[out_count];
+        hdr->msg_iov = iov;
 
-            memcpy (out_buffer, body_msg.data (), body_size);
+        if (options.raw_socket) {
+            iov[0].iov_base = body_msg->data ();
+            iov[0].iov_len = body_msg->size ();
+            hdr->msg_iovlen = 1;
+            hdr->msg_name = &out_addresses[out_count];
+            hdr->msg_namelen = sizeof (sockaddr_in);
         } else {
-            size = group_size + body_size + 1;
-
-            // TODO: check if larger than maximum size
-            out_buffer[0] = (unsigned char) group_size;
-            memcpy (out_buffer + 1, group_msg.data (), group_size);
-            memcpy (out_buffer + 1 + group_size, body_msg.data (), body_size);
+            const size_t group_size = group_msg->size ();
+            out_group_sizes[out_count] = (unsigned char) group_size;
+            iov[0].iov_base = &out_group_sizes[out_count];
+            iov[0].iov_len = 1;
+            iov[1].iov_base = group_msg->data ();
+            iov[1].iov_len = group_size;
+            iov[2].iov_base = body_msg->data ();
+            iov[2].iov_len = body_msg->size ();
+            hdr->msg_iovlen = 3;
+            hdr->msg_name = (void *) out_address;
+            hdr->msg_namelen = out_addrlen;
         }
 
-        rc = group_msg.close ();
-        errno_assert (rc == 0);
-
-        body_msg.close ();
-        errno_assert (rc == 0);
+        out_count++;
+    }
 
-#ifdef ZMQ_HAVE_WINDOWS
-        rc = sendto (fd, (const char *) out_buffer, (int) size, 0, out_address,
-                     (int) out_addrlen);
-        wsa_assert (rc != SOCKET_ERROR);
+    if (out_count == 0) {
+        reset_pollout (handle);
+        return;
+    }
 #else
-        rc = sendto (fd, out_buffer, size, 0, out_address, out_addrlen);
-        errno_assert (rc != -1);
-#endif
-    } else
+    msg_t group_msg;
+    msg_t body_msg;
+    if (pull_datagram (&group_msg, &body_msg, &raw_address) != 0) {
         reset_pollout (handle);
+        return;
+    }
+
+    const size_t group_size = group_msg.size ();
+    const size_t body_size = body_msg.size ();
+    if (options.raw_socket) {
+        memcpy (out_buffer, body_msg.data (), body_size);
+        out_size = body_size;
+    } else {
+        out_buffer[0] = (unsigned char) group_size;
+        memcpy (out_buffer + 1, group_msg.data (), group_size);
+        memcpy (out_buffer + 1 + group_size, body_msg.data (), body_size);
+        out_size = 1 + group_size + body_size;
+    }
+
+    int rc = group_msg.close ();
+    errno_assert (rc == 0);
+
+    rc = body_msg.close ();
+    errno_assert (rc == 0);
+#endif
+
+    send_pending ();
 }
 
 const char *zmq::udp_engine_t::get_endpoint () const
@@ -310,6 +460,36 @@ void zmq::udp_engine_t::restart_output ()
 
 void zmq::udp_engine_t::in_event ()
 {
+#if defined HAVE_RECVMMSG
+    //  Datagrams left over from the previous batch are pushed first.
+    if (in_next == in_count) {
+        for (int i = 0; i < udp_batch_size; i++)
+            in_msgs[i].msg_hdr.msg_namelen = sizeof (sockaddr_in);
+
+        const int n = recvmmsg (fd, in_msgs, udp_batch_size, 0, NULL);
+        if (n == -1) {
+            errno_assert (errno != EBADF && errno != EFAULT
+                          && errno != ENOMEM && errno != ENOTSOCK);
+            return;
+        }
+        in_count = n;
+        in_next = 0;
+    }
+
+    while (in_next < in_count) {
+        const int rc =
+          push_datagram (in_batch + in_next * MAX_UDP_MSG,
+                         (int) in_msgs[in_next].msg_len, &in_addresses[in_next]);
+
+        //  Pipe is full
+        if (rc != 0) {
+            reset_pollin (handle);
+            break;
+        }
+        in_next++;
+    }
+    session->flush ();
+#else
     struct sockaddr_in in_address;
     socklen_t in_addrlen = sizeof (sockaddr_in);
 #ifdef ZMQ_HAVE_WINDOWS
@@ -330,30 +510,45 @@ void zmq::udp_engine_t::in_event ()
         return;
     }
 #endif
+    const int rc = push_datagram (in_buffer, nbytes, &in_address);
+
+    //  Pipe is full
+    if (rc != 0) {
+        reset_pollin (handle);
+        return;
+    }
+    session->flush ();
+#endif
+}
+
+int zmq::udp_engine_t::push_datagram (const unsigned char *buffer_,
+                                      int nbytes_,
+                                      sockaddr_in *address_)
+{
     int rc;
     int body_size;
     int body_offset;
     msg_t msg;
 
     if (options.raw_socket) {
-        sockaddr_to_msg (&msg, &in_address);
+        sockaddr_to_msg (&msg, address_);
 
-        body_size = nbytes;
+        body_size = nbytes_;
         body_offset = 0;
     } else {
-        char *group_buffer = (char *) in_buffer + 1;
-        int group_size = in_buffer[0];
+        const char *group_buffer = (const char *) buffer_ + 1;
+        int group_size = buffer_[0];
+
+        //  This doesn't fit, just ingore
+        if (nbytes_ - 1 < group_size)
+            return 0;
 
         rc = msg.init_size (group_size);
         errno_assert (rc == 0);
         msg.set_flags (msg_t::more);
         memcpy (msg.data (), group_buffer, group_size);
 
-        //  This doesn't fit, just ingore
-        if (nbytes - 1 < group_size)
-            return;
-
-        body_size = nbytes - 1 - group_size;
+        body_size = nbytes_ - 1 - group_size;
         body_offset = 1 + group_size;
     }
 
@@ -365,20 +560,21 @@ void zmq::udp_engine_t::in_event ()
         rc = msg.close ();
         errno_assert (rc == 0);
 
-        reset_pollin (handle);
-        return;
+        errno = EAGAIN;
+        return -1;
     }
 
     rc = msg.close ();
     errno_assert (rc == 0);
     rc = msg.init_size (body_size);
     errno_assert (rc == 0);
-    memcpy (msg.data (), in_buffer + body_offset, body_size);
+    memcpy (msg.data (), buffer_ + body_offset, body_size);
     rc = session->push_msg (&msg);
     errno_assert (rc == 0);
     rc = msg.close ();
     errno_assert (rc == 0);
-    session->flush ();
+
+    return 0;
 }
 
 void zmq::udp_engine_t::restart_input ()
@@ -7,6 +7,12 @@
 #include "address.hpp"
 #include "udp_address.hpp"
 #include "msg.hpp"
+#include "config.hpp"
+
+#if defined HAVE_RECVMMSG || defined HAVE_SENDMMSG
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
 
 #define MAX_UDP_MSG 8192
 
@@ -41,15 +47,40 @@ class udp_engine_t : public io_object_t, public i_engine
 
     void zap_msg_available (){};
 
+    //  Datagram engines stay in the I/O thread they were plugged into.
+    bool suspend () { return false; }
+    void resume (zmq::io_thread_t *) {}
+
     void in_event ();
     void out_event ();
 
     const char *get_endpoint () const;
 
   private:
-    int resolve_raw_address (char *addr_, size_t length_);
+    int resolve_raw_address (char *addr_,
+                             size_t length_,
+                             sockaddr_in *address_);
     void sockaddr_to_msg (zmq::msg_t *msg, sockaddr_in *addr);
 
+    //  Sends the pending datagrams. Returns false if the socket could not
+    //  take them all.
+    bool send_pending ();
+
+    //  Pulls the group and body of the next datagram to send from the
+    //  session, resolving the address of raw datagrams. Messages with
+    //  invalid addresses or too large to fit a datagram are discarded.
+    //  Returns -1 with errno set to EAGAIN if there are no more.
+    int pull_datagram (msg_t *group_msg_,
+                       msg_t *body_msg_,
+                       sockaddr_in *raw_address_);
+
+    //  Pushes a received datagram to the session. Returns -1 with errno
+    //  set to EAGAIN if the pipe is full; the datagram is not consumed
+    //  in that case.
+    int push_datagram (const unsigned char *buffer_,
+                       int nbytes_,
+                       sockaddr_in *address_);
+
     bool plugged;
 
     fd_t fd;
@@ -63,10 +94,44 @@ class udp_engine_t : public io_object_t, public i_engine
     const struct sockaddr *out_address;
     socklen_t out_addrlen;
 
-    unsigned char out_buffer[MAX_UDP_MSG];
+#if !defined HAVE_RECVMMSG
     unsigned char in_buffer[MAX_UDP_MSG];
+#endif
     bool send_enabled;
     bool recv_enabled;
+
+#if defined HAVE_SENDMMSG
+    //  Datagrams pulled from the session for a single sendmmsg call,
+    //  gathered straight from their messages. Those the kernel did not
+    //  take yet, from index out_next on, are sent once the socket is
+    //  writable again.
+    msg_t out_group_msgs[udp_batch_size];
+    msg_t out_body_msgs[udp_batch_size];
+    struct mmsghdr out_msgs[udp_batch_size];
+    struct iovec out_iovs[udp_batch_size][3];
+    unsigned char out_group_sizes[udp_batch_size];
+    sockaddr_in out_addresses[udp_batch_size];
+    int out_count;
+    int out_next;
+#else
+    //  Datagram to send and its size, zero if there is none.
+    unsigned char out_buffer[MAX_UDP_MSG];
+    size_t out_size;
+#endif
+
+#if defined HAVE_RECVMMSG
+    //  Receive buffers for up to udp_batch_size datagrams, read in
+    //  a single recvmmsg call.
+    unsigned char *in_batch;
+    struct mmsghdr in_msgs[udp_batch_size];
+    struct iovec in_iovs[udp_batch_size];
+    sockaddr_in in_addresses[udp_batch_size];
+
+    //  Number of datagrams received by the last recvmmsg call and the
+    //  index of the first one not yet pushed to the session.
+    int in_count;
+    int in_next;
+#endif
 };
 }
 
@@ -31,6 +31,7 @@
 #define __ZMQ_YPIPE_HPP_INCLUDED__
 
 #include "atomic_ptr.hpp"
+#include "config.hpp"
 #include "yqueue.hpp"
 #include "ypipe_base.hpp"
 
@@ -189,17 +190,24 @@ template <typename T, int N> class ypipe_t : public ypipe_base_t<T>
     //  exclusively by writer thread.
     T *w;
 
+    //  Points to the first item to be flushed in the future.
+    T *f;
+
+    unsigned char writer_pad[cache_line_size];
+
     //  Points to the first un-prefetched item. This variable is used
-    //  exclusively by reader thread.
+    //  exclusively by reader thread. It caches the value of 'c', so that
+    //  the reader touches 'c' only once it has read everything up to it.
     T *r;
 
-    //  Points to the first item to be flushed in the future.
-    T *f;
+    unsigned char reader_pad[cache_line_size];
 
     //  The single point of contention between writer and reader thread.
     //  Points past the last flushed item. If it is NULL,
     //  reader is asleep. This pointer should be always accessed using
-    //  atomic operations.
+    //  atomic operations. It is kept apart from 'w', 'f' and 'r' so that
+    //  updating it does not invalidate the cache line either thread
+    //  works on between synchronisations.
     atomic_ptr_t<T> c;
 
     //  Disable copying of ypipe object.
@@ -35,6 +35,7 @@
 
 #include "err.hpp"
 #include "atomic_ptr.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -52,11 +53,11 @@ namespace zmq
 //  actual memory allocation is required).
 #ifdef HAVE_POSIX_MEMALIGN
 // ALIGN is the memory alignment size to use in the case where we have
-// posix_memalign available. Default value is 64, this alignment will
-// prevent two queue chunks from occupying the same CPU cache line on
-// architectures where cache lines are <= 64 bytes (e.g. most things
-// except POWER).
-template <typename T, int N, size_t ALIGN = 64> class yqueue_t
+// posix_memalign available. Default value is cache_line_size (64), this
+// alignment will prevent two queue chunks from occupying the same CPU
+// cache line on architectures where cache lines are <= 64 bytes (e.g.
+// most things except POWER).
+template <typename T, int N, size_t ALIGN = cache_line_size> class yqueue_t
 #else
 template <typename T, int N> class yqueue_t
 #endif
@@ -194,12 +195,16 @@ template <typename T, int N> class yqueue_t
     //  while begin & end positions are always valid. Begin position is
     //  accessed exclusively be queue reader (front/pop), while back and
     //  end positions are accessed exclusively by queue writer (back/push).
+    //  The reader's and the writer's positions live on different cache
+    //  lines, so that moving one does not evict the other.
     chunk_t *begin_chunk;
     int begin_pos;
+    unsigned char reader_pad[cache_line_size];
     chunk_t *back_chunk;
     int back_pos;
     chunk_t *end_chunk;
     int end_pos;
+    unsigned char writer_pad[cache_line_size];
 
     //  People are likely to produce and consume at similar rates.  In
     //  this scenario holding onto the most recently freed chunk saves
@@ -284,6 +284,94 @@ int zmq_leave (void *s_, const char *group_)
     return s->leave (group_);
 }
 
+int zmq_socket_migrate (void *s_, uint64_t affinity_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    return s->migrate (affinity_);
+}
+
+static void copy_stats (const zmq::stats_snapshot_t &stats_,
+                        zmq_socket_statistics_t *out_)
+{
+    out_->msgs_in = stats_.msgs_in;
+    out_->bytes_in = stats_.bytes_in;
+    out_->msgs_out = stats_.msgs_out;
+    out_->bytes_out = stats_.bytes_out;
+    out_->hwm_drops = stats_.hwm_drops;
+    out_->eagains = stats_.eagains;
+    out_->reconnects = stats_.reconnects;
+    out_->mutes = stats_.mutes;
+    out_->queue_depth = stats_.queue_depth;
+    out_->zerocopy_writes = stats_.zerocopy_writes;
+}
+
+int zmq_socket_stats (void *s_, zmq_socket_statistics_t *stats_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    if (!stats_) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    zmq::stats_snapshot_t stats;
+    s->snapshot_stats (&stats);
+    copy_stats (stats, stats_);
+    return 0;
+}
+
+int zmq_socket_peer_stats (void *s_,
+                           const void *routing_id_,
+                           size_t routing_id_size_,
+                           zmq_socket_statistics_t *stats_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    if (!stats_ || (!routing_id_ && routing_id_size_)) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    zmq::stats_snapshot_t stats;
+    if (s->snapshot_peer_stats (routing_id_, routing_id_size_, &stats) != 0)
+        return -1;
+    copy_stats (stats, stats_);
+    return 0;
+}
+
+int zmq_socket_latency (void *s_, int stage_, zmq_latency_stats_t *stats_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    if (!stats_) {
+        errno = EFAULT;
+        return -1;
+    }
+#ifdef ZMQ_BUILD_LATENCY_STATS
+    if (stage_ < 0 || stage_ >= zmq::latency_stages) {
+        errno = EINVAL;
+        return -1;
+    }
+    zmq::latency_histogram_t &histogram = s->get_stats ().latency[stage_];
+    stats_->count = histogram.count ();
+    stats_->p50 = histogram.percentile (50);
+    stats_->p90 = histogram.percentile (90);
+    stats_->p99 = histogram.percentile (99);
+    stats_->p999 = histogram.percentile (99.9);
+    stats_->max = histogram.percentile (100);
+    return 0;
+#else
+    (void) stage_;
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
 int zmq_bind (void *s_, const char *addr_)
 {
     zmq::socket_base_t *s = as_socket_base_t (s_);
@@ -585,6 +673,38 @@ int zmq_msg_recv (zmq_msg_t *msg_, void *s_, int flags_)
     return s_recvmsg (s, msg_, flags_);
 }
 
+//  The vectored functions return the number of messages transferred as
+//  an int, so at most INT_MAX messages are transferred per call.
+
+static inline size_t s_msg_count (size_t count_)
+{
+    return count_ < (size_t) INT_MAX ? count_ : (size_t) INT_MAX;
+}
+
+int zmq_msg_send_many (zmq_msg_t *msgs_, size_t count_, void *s_, int flags_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    if (unlikely (!msgs_ || count_ == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return s->send_many ((zmq::msg_t *) msgs_, s_msg_count (count_), flags_);
+}
+
+int zmq_msg_recv_many (zmq_msg_t *msgs_, size_t count_, void *s_, int flags_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    if (unlikely (!msgs_ || count_ == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return s->recv_many ((zmq::msg_t *) msgs_, s_msg_count (count_), flags_);
+}
+
 int zmq_msg_close (zmq_msg_t *msg_)
 {
     return ((zmq::msg_t *) msg_)->close ();
@@ -1457,6 +1577,25 @@ int zmq_proxy_steerable (void *frontend_,
       (zmq::socket_base_t *) capture_, (zmq::socket_base_t *) control_);
 }
 
+int zmq_proxy_mt (void **frontends_,
+                  void **backends_,
+                  int count_,
+                  void *control_)
+{
+    if (!frontends_ || !backends_) {
+        errno = EFAULT;
+        return -1;
+    }
+    for (int i = 0; i < count_; i++)
+        if (!frontends_[i] || !backends_[i]) {
+            errno = EFAULT;
+            return -1;
+        }
+    return zmq::proxy_mt ((zmq::socket_base_t **) frontends_,
+                          (zmq::socket_base_t **) backends_, count_,
+                          (zmq::socket_base_t *) control_);
+}
+
 //  The deprecated device functionality
 
 int zmq_device (int /* type */, void *frontend_, void *backend_)
@@ -1473,6 +1612,10 @@ int zmq_has (const char *capability)
     if (strcmp (capability, "ipc") == 0)
         return true;
 #endif
+#if defined(HAVE_MEMFD_CREATE)
+    if (strcmp (capability, "shm") == 0)
+        return true;
+#endif
 #if defined(ZMQ_HAVE_OPENPGM)
     if (strcmp (capability, "pgm") == 0)
         return true;
@@ -56,6 +56,15 @@ unsigned long zmq_stopwatch_intermediate (void *watch_);
 #define ZMQ_BINDTODEVICE 92
 #define ZMQ_ZAP_ENFORCE_DOMAIN 93
 #define ZMQ_LOOPBACK_FASTPATH 94
+#define ZMQ_TCP_ZEROCOPY_THRESHOLD 95
+#define ZMQ_BUSY_POLL_US 96
+#define ZMQ_IN_BATCH_SIZE 97
+#define ZMQ_OUT_BATCH_SIZE 98
+#define ZMQ_ADAPTIVE_BATCH_SIZE 99
+#define ZMQ_ADAPTIVE_POLL_RATE 100
+
+/*  DRAFT Send/recv options.                                                  */
+#define ZMQ_SNDBATCH 4
 
 /*  DRAFT 0MQ socket events and monitoring                                    */
 /*  Unspecified system errors during handshake. Event value is an errno.      */
@@ -99,16 +108,65 @@ unsigned long zmq_stopwatch_intermediate (void *watch_);
 #define ZMQ_THREAD_AFFINITY_CPU_ADD 7
 #define ZMQ_THREAD_AFFINITY_CPU_REMOVE 8
 #define ZMQ_THREAD_NAME_PREFIX 9
+#define ZMQ_MSG_POOL 10
+#define ZMQ_IO_THREAD_CPU_ADD 11
 
 /*  DRAFT Socket methods.                                                     */
 int zmq_join (void *s, const char *group);
 int zmq_leave (void *s, const char *group);
+int zmq_socket_migrate (void *s, uint64_t affinity);
+
+/*  DRAFT Socket statistics.                                                  */
+typedef struct zmq_socket_statistics_t
+{
+    uint64_t msgs_in;
+    uint64_t bytes_in;
+    uint64_t msgs_out;
+    uint64_t bytes_out;
+    uint64_t hwm_drops;
+    uint64_t eagains;
+    uint64_t reconnects;
+    uint64_t mutes;
+    uint64_t queue_depth;
+    uint64_t zerocopy_writes;
+} zmq_socket_statistics_t;
+
+int zmq_socket_stats (void *s, zmq_socket_statistics_t *stats);
+int zmq_socket_peer_stats (void *s,
+                           const void *routing_id,
+                           size_t routing_id_size,
+                           zmq_socket_statistics_t *stats);
+
+/*  DRAFT Message latency statistics, in nanoseconds. Only collected when     */
+/*  the library is built with latency statistics enabled.                     */
+#define ZMQ_LATENCY_SEND 0
+#define ZMQ_LATENCY_PIPE_OUT 1
+#define ZMQ_LATENCY_WIRE_OUT 2
+#define ZMQ_LATENCY_WIRE_IN 3
+#define ZMQ_LATENCY_PIPE_IN 4
+
+typedef struct zmq_latency_stats_t
+{
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+} zmq_latency_stats_t;
+
+int zmq_socket_latency (void *s, int stage, zmq_latency_stats_t *stats);
 
 /*  DRAFT Msg methods.                                                        */
 int zmq_msg_set_routing_id (zmq_msg_t *msg, uint32_t routing_id);
 uint32_t zmq_msg_routing_id (zmq_msg_t *msg);
 int zmq_msg_set_group (zmq_msg_t *msg, const char *group);
 const char *zmq_msg_group (zmq_msg_t *msg);
+int zmq_msg_send_many (zmq_msg_t *msgs, size_t count, void *s, int flags);
+int zmq_msg_recv_many (zmq_msg_t *msgs, size_t count, void *s, int flags);
+
+/*  DRAFT Message proxying                                                    */
+int zmq_proxy_mt (void **frontends, void **backends, int count, void *control);
 
 /*  DRAFT Msg property names.                                                 */
 #define ZMQ_MSG_PROPERTY_ROUTING_ID "Routing-Id"
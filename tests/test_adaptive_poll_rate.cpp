@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+//  Streams messages through a pipe with a small high water mark, so that
+//  the sender keeps waiting for activate_write commands while the receiver
+//  keeps finding messages available.
+
+#define MESSAGES 100000
+
+int main (void)
+{
+    setup_test_environment ();
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+
+    int adaptive;
+    size_t size = sizeof adaptive;
+    int rc = zmq_getsockopt (push, ZMQ_ADAPTIVE_POLL_RATE, &adaptive, &size);
+    assert (rc == 0);
+    assert (adaptive == 0);
+
+    adaptive = 2;
+    rc = zmq_setsockopt (push, ZMQ_ADAPTIVE_POLL_RATE, &adaptive,
+                         sizeof adaptive);
+    assert (rc == -1);
+    assert (errno == EINVAL);
+
+    adaptive = 1;
+    rc = zmq_setsockopt (push, ZMQ_ADAPTIVE_POLL_RATE, &adaptive,
+                         sizeof adaptive);
+    assert (rc == 0);
+    rc = zmq_setsockopt (pull, ZMQ_ADAPTIVE_POLL_RATE, &adaptive,
+                         sizeof adaptive);
+    assert (rc == 0);
+    rc = zmq_getsockopt (pull, ZMQ_ADAPTIVE_POLL_RATE, &adaptive, &size);
+    assert (rc == 0);
+    assert (adaptive == 1);
+
+    int hwm = 10;
+    rc = zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+
+    rc = zmq_bind (pull, "inproc://adaptive");
+    assert (rc == 0);
+    rc = zmq_connect (push, "inproc://adaptive");
+    assert (rc == 0);
+
+    //  Alternate between filling the pipe and draining it, without ever
+    //  blocking on either side.
+    int sent = 0;
+    int received = 0;
+    char buffer[8];
+    while (received < MESSAGES) {
+        while (sent < MESSAGES) {
+            rc = zmq_send (push, "ABC", 3, ZMQ_DONTWAIT);
+            if (rc == -1) {
+                assert (errno == EAGAIN);
+                break;
+            }
+            assert (rc == 3);
+            sent++;
+        }
+        while (true) {
+            rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+            if (rc == -1) {
+                assert (errno == EAGAIN);
+                break;
+            }
+            assert (rc == 3);
+            received++;
+        }
+    }
+    assert (sent == MESSAGES);
+
+    rc = zmq_close (push);
+    assert (rc == 0);
+    rc = zmq_close (pull);
+    assert (rc == 0);
+
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "testutil.hpp"
+
+void test_option (void *ctx)
+{
+    void *sock = zmq_socket (ctx, ZMQ_REP);
+    assert (sock);
+
+    int value;
+    size_t size = sizeof value;
+    int rc = zmq_getsockopt (sock, ZMQ_BUSY_POLL_US, &value, &size);
+    assert (rc == 0);
+    assert (value == 0);
+
+    value = -1;
+    rc = zmq_setsockopt (sock, ZMQ_BUSY_POLL_US, &value, sizeof value);
+    assert (rc == -1);
+    assert (errno == EINVAL);
+
+    value = 100;
+    rc = zmq_setsockopt (sock, ZMQ_BUSY_POLL_US, &value, sizeof value);
+    assert (rc == 0);
+    rc = zmq_getsockopt (sock, ZMQ_BUSY_POLL_US, &value, &size);
+    assert (rc == 0);
+    assert (value == 100);
+
+    rc = zmq_close (sock);
+    assert (rc == 0);
+}
+
+void test_roundtrips (void *ctx, const char *endpoint)
+{
+    void *rep = zmq_socket (ctx, ZMQ_REP);
+    assert (rep);
+    void *req = zmq_socket (ctx, ZMQ_REQ);
+    assert (req);
+
+    //  Spin for long enough to catch most of the replies.
+    int busy_poll = 10000;
+    int rc =
+      zmq_setsockopt (rep, ZMQ_BUSY_POLL_US, &busy_poll, sizeof busy_poll);
+    assert (rc == 0);
+    rc = zmq_setsockopt (req, ZMQ_BUSY_POLL_US, &busy_poll, sizeof busy_poll);
+    assert (rc == 0);
+
+    rc = zmq_bind (rep, endpoint);
+    assert (rc == 0);
+    char my_endpoint[MAX_SOCKET_STRING];
+    size_t len = sizeof my_endpoint;
+    rc = zmq_getsockopt (rep, ZMQ_LAST_ENDPOINT, my_endpoint, &len);
+    assert (rc == 0);
+    rc = zmq_connect (req, my_endpoint);
+    assert (rc == 0);
+
+    for (int i = 0; i < 100; i++)
+        bounce (rep, req);
+
+    close_zero_linger (req);
+    close_zero_linger (rep);
+}
+
+void test_timeout (void *ctx)
+{
+    void *rep = zmq_socket (ctx, ZMQ_REP);
+    assert (rep);
+
+    //  The receive timeout ends busy polling.
+    int busy_poll = 5000000;
+    int rc =
+      zmq_setsockopt (rep, ZMQ_BUSY_POLL_US, &busy_poll, sizeof busy_poll);
+    assert (rc == 0);
+    int timeout = 50;
+    rc = zmq_setsockopt (rep, ZMQ_RCVTIMEO, &timeout, sizeof timeout);
+    assert (rc == 0);
+    rc = zmq_bind (rep, "inproc://timeout");
+    assert (rc == 0);
+
+    char buffer[32];
+    void *watch = zmq_stopwatch_start ();
+    rc = zmq_recv (rep, buffer, sizeof buffer, 0);
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    assert (rc == -1);
+    assert (errno == EAGAIN);
+    assert (elapsed >= 40000);
+    assert (elapsed < 2000000);
+
+    rc = zmq_close (rep);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    test_option (ctx);
+    test_roundtrips (ctx, "inproc://busy_poll");
+    test_roundtrips (ctx, "tcp://127.0.0.1:*");
+    test_timeout (ctx);
+
+    int rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
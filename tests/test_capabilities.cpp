@@ -37,6 +37,12 @@ int main (void)
     assert (!zmq_has ("ipc"));
 #endif
 
+#if defined(HAVE_MEMFD_CREATE)
+    assert (zmq_has ("shm"));
+#else
+    assert (!zmq_has ("shm"));
+#endif
+
 #if defined(ZMQ_HAVE_OPENPGM)
     assert (zmq_has ("pgm"));
 #else
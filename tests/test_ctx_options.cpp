@@ -36,6 +36,8 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <unistd.h> // for sleep()
+#include <dirent.h>
+#include <sched.h>
 
 #define TEST_POLICY                                                            \
     (SCHED_OTHER) // NOTE: SCHED_OTHER is the default Linux scheduler
@@ -138,6 +140,21 @@ void test_ctx_thread_opts (void *ctx)
 #endif
 
 
+#ifdef ZMQ_IO_THREAD_CPU_ADD
+    // test per-I/O-thread affinity: I/O threads are pinned to the CPUs
+    // added, one CPU each, in turn; where threads cannot be pinned, the
+    // option is rejected
+    rc = zmq_ctx_set (ctx, ZMQ_IO_THREAD_CPU_ADD, 0);
+#ifdef ZMQ_HAVE_PTHREAD_SET_AFFINITY
+    assert (rc == 0);
+#else
+    assert (rc == -1 && errno == EINVAL);
+#endif
+    rc = zmq_ctx_set (ctx, ZMQ_IO_THREAD_CPU_ADD, -1);
+    assert (rc == -1 && errno == EINVAL);
+#endif
+
+
 #ifdef ZMQ_THREAD_NAME_PREFIX
     // test thread name prefix:
 
@@ -147,6 +164,166 @@ void test_ctx_thread_opts (void *ctx)
 }
 
 
+#if defined ZMQ_IO_THREAD_CPU_ADD && defined ZMQ_HAVE_LINUX                  \
+  && defined ZMQ_HAVE_PTHREAD_SET_AFFINITY
+//  Counts the threads whose name starts with prefix_ and that may run on
+//  cpu_ only.
+int count_threads_on_cpu (const char *prefix_, int cpu_)
+{
+    DIR *tasks = opendir ("/proc/self/task");
+    assert (tasks);
+    int count = 0;
+    while (struct dirent *task = readdir (tasks)) {
+        if (task->d_name[0] == '.')
+            continue;
+        char path[300];
+        snprintf (path, sizeof path, "/proc/self/task/%s/comm", task->d_name);
+        FILE *comm = fopen (path, "r");
+        if (!comm)
+            continue;
+        char name[32] = "";
+        char *rc = fgets (name, sizeof name, comm);
+        fclose (comm);
+        if (!rc || strncmp (name, prefix_, strlen (prefix_)) != 0)
+            continue;
+
+        cpu_set_t cpus;
+        if (sched_getaffinity ((pid_t) atoi (task->d_name), sizeof cpus, &cpus)
+            == 0
+            && CPU_COUNT (&cpus) == 1 && CPU_ISSET (cpu_, &cpus))
+            count++;
+    }
+    closedir (tasks);
+    return count;
+}
+
+void test_io_thread_affinity ()
+{
+    //  Pin the I/O threads to the last CPU the process may run on.
+    cpu_set_t allowed;
+    int rc = sched_getaffinity (0, sizeof allowed, &allowed);
+    assert (rc == 0);
+    int cpu = CPU_SETSIZE - 1;
+    while (!CPU_ISSET (cpu, &allowed))
+        cpu--;
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+    rc = zmq_ctx_set (ctx, ZMQ_IO_THREADS, 2);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_THREAD_NAME_PREFIX, 4321);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_IO_THREAD_CPU_ADD, cpu);
+    assert (rc == 0);
+
+    //  Creating the first socket launches the threads, which pin themselves
+    //  once running. The reaper keeps the affinity of the process, so it
+    //  is only counted if that is the same CPU.
+    void *socket = zmq_socket (ctx, ZMQ_DEALER);
+    assert (socket);
+    const int expected = CPU_COUNT (&allowed) == 1 ? 3 : 2;
+    int pinned = 0;
+    for (int i = 0; i < 100; i++) {
+        pinned = count_threads_on_cpu ("4321/ZMQbg/", cpu);
+        if (pinned == expected)
+            break;
+        msleep (10);
+    }
+    assert (pinned == expected);
+
+    rc = zmq_close (socket);
+    assert (rc == 0);
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+}
+#endif
+
+
+#ifdef ZMQ_MSG_POOL
+void free_data (void *data_, void *hint_)
+{
+    free (data_);
+    *(int *) hint_ += 1;
+}
+
+void test_msg_pool (void *ctx)
+{
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_POOL) == 0);
+    int rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_POOL) == 1);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:*");
+    assert (rc == 0);
+    //  The context has IPv6 enabled, so the endpoint may be longer than
+    //  MAX_SOCKET_STRING.
+    char my_endpoint[256];
+    size_t len = sizeof my_endpoint;
+    rc = zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, my_endpoint, &len);
+    assert (rc == 0);
+    rc = zmq_connect (sc, my_endpoint);
+    assert (rc == 0);
+
+    //  Sizes below, within and above the pooled size classes. Messages are
+    //  allocated by the sending thread and the I/O thread, and freed by
+    //  the I/O thread and the receiving thread respectively.
+    const size_t sizes[] = {50, 100, 500, 1000, 4000, 8000, 20000};
+    const size_t size_count = sizeof sizes / sizeof sizes[0];
+    for (int round = 0; round < 100; round++) {
+        for (size_t i = 0; i < size_count; i++) {
+            zmq_msg_t msg;
+            rc = zmq_msg_init_size (&msg, sizes[i]);
+            assert (rc == 0);
+            memset (zmq_msg_data (&msg), (int) (round + i), sizes[i]);
+            rc = zmq_msg_send (&msg, sc, 0);
+            assert (rc == (int) sizes[i]);
+        }
+        for (size_t i = 0; i < size_count; i++) {
+            zmq_msg_t msg;
+            rc = zmq_msg_init (&msg);
+            assert (rc == 0);
+            rc = zmq_msg_recv (&msg, sb, 0);
+            assert (rc == (int) sizes[i]);
+            const unsigned char *data =
+              (const unsigned char *) zmq_msg_data (&msg);
+            assert (data[0] == (unsigned char) (round + i));
+            assert (data[sizes[i] - 1] == (unsigned char) (round + i));
+            rc = zmq_msg_close (&msg);
+            assert (rc == 0);
+        }
+    }
+
+    //  Messages with user supplied storage and shared messages.
+    int freed = 0;
+    zmq_msg_t msg;
+    rc = zmq_msg_init_data (&msg, malloc (100), 100, free_data, &freed);
+    assert (rc == 0);
+    zmq_msg_t copy;
+    rc = zmq_msg_init (&copy);
+    assert (rc == 0);
+    rc = zmq_msg_copy (&copy, &msg);
+    assert (rc == 0);
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+
+    //  Messages allocated from the pool can be closed after disabling it.
+    rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 0);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_POOL) == 0);
+    assert (freed == 0);
+    rc = zmq_msg_close (&copy);
+    assert (rc == 0);
+    assert (freed == 1);
+
+    close_zero_linger (sc);
+    close_zero_linger (sb);
+}
+#endif
+
 int main (void)
 {
     setup_test_environment ();
@@ -174,6 +351,15 @@ int main (void)
 
     test_ctx_thread_opts (ctx);
 
+#if defined ZMQ_IO_THREAD_CPU_ADD && defined ZMQ_HAVE_LINUX                  \
+  && defined ZMQ_HAVE_PTHREAD_SET_AFFINITY
+    test_io_thread_affinity ();
+#endif
+
+#ifdef ZMQ_MSG_POOL
+    test_msg_pool (ctx);
+#endif
+
     void *router = zmq_socket (ctx, ZMQ_ROUTER);
     int value;
     size_t optsize = sizeof (int);
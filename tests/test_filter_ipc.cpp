@@ -89,9 +89,6 @@ static void run_test (int opt, T optval, int expected_error, int bounce_test)
     assert (rc == 0);
     rc = zmq_setsockopt (sc, ZMQ_SNDTIMEO, &timeout, sizeof (int));
     assert (rc == 0);
-    int interval = -1;
-    rc = zmq_setsockopt (sc, ZMQ_RECONNECT_IVL, &interval, sizeof (int));
-    assert (rc == 0);
 
     if (bounce_test) {
         const char *endpoint = "ipc://test_filter_ipc.sock";
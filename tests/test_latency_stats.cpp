@@ -0,0 +1,110 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+#define MESSAGES 100
+
+void check_stage (void *socket_, int stage_, uint64_t min_count_)
+{
+    zmq_latency_stats_t stats;
+    int rc = zmq_socket_latency (socket_, stage_, &stats);
+    assert (rc == 0);
+    assert (stats.count >= min_count_);
+    assert (stats.p50 <= stats.p90);
+    assert (stats.p90 <= stats.p99);
+    assert (stats.p99 <= stats.p999);
+    assert (stats.p999 <= stats.max);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    int rc = zmq_bind (push, "tcp://127.0.0.1:*");
+    assert (rc == 0);
+    char endpoint[256];
+    size_t endpoint_len = sizeof endpoint;
+    rc = zmq_getsockopt (push, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len);
+    assert (rc == 0);
+
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_connect (pull, endpoint);
+    assert (rc == 0);
+
+    zmq_latency_stats_t stats;
+    rc = zmq_socket_latency (push, ZMQ_LATENCY_SEND, &stats);
+    if (rc == -1) {
+        //  The library was built without latency statistics.
+        assert (errno == ENOTSUP);
+    } else {
+        assert (stats.count == 0);
+        assert (stats.max == 0);
+
+        for (int i = 0; i < MESSAGES; i++) {
+            rc = zmq_send (push, "latency", 7, 0);
+            assert (rc == 7);
+        }
+        char buffer[16];
+        for (int i = 0; i < MESSAGES; i++) {
+            rc = zmq_recv (pull, buffer, sizeof buffer, 0);
+            assert (rc == 7);
+        }
+
+        check_stage (push, ZMQ_LATENCY_SEND, MESSAGES);
+        check_stage (push, ZMQ_LATENCY_PIPE_OUT, MESSAGES);
+        check_stage (push, ZMQ_LATENCY_WIRE_OUT, 1);
+        check_stage (pull, ZMQ_LATENCY_WIRE_IN, MESSAGES);
+        check_stage (pull, ZMQ_LATENCY_PIPE_IN, MESSAGES);
+
+        //  Unknown stages are rejected
+        rc = zmq_socket_latency (push, 5, &stats);
+        assert (rc == -1);
+        assert (errno == EINVAL);
+    }
+
+    rc = zmq_socket_latency (push, ZMQ_LATENCY_SEND, NULL);
+    assert (rc == -1);
+    assert (errno == EFAULT);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
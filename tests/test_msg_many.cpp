@@ -0,0 +1,178 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+#define COUNT 64
+
+void init_messages (zmq_msg_t *msgs_, int count_, int first_)
+{
+    for (int i = 0; i < count_; i++) {
+        int rc = zmq_msg_init_size (&msgs_[i], sizeof (int));
+        assert (rc == 0);
+        int value = first_ + i;
+        memcpy (zmq_msg_data (&msgs_[i]), &value, sizeof value);
+    }
+}
+
+void close_messages (zmq_msg_t *msgs_, int count_)
+{
+    for (int i = 0; i < count_; i++) {
+        int rc = zmq_msg_close (&msgs_[i]);
+        assert (rc == 0);
+    }
+}
+
+void test_send_recv_many (void *ctx_, int type_)
+{
+    //  CLIENT/SERVER exercise the thread-safe sockets
+    const bool safe = type_ == ZMQ_CLIENT;
+    void *sender = zmq_socket (ctx_, type_);
+    assert (sender);
+    const char *endpoint = safe ? "inproc://many-safe" : "inproc://many";
+    int rc = zmq_bind (sender, endpoint);
+    assert (rc == 0);
+    void *receiver = zmq_socket (ctx_, safe ? ZMQ_SERVER : ZMQ_PULL);
+    assert (receiver);
+    rc = zmq_connect (receiver, endpoint);
+    assert (rc == 0);
+
+    zmq_msg_t msgs[COUNT];
+    init_messages (msgs, COUNT, 0);
+    rc = zmq_msg_send_many (msgs, COUNT, sender, 0);
+    assert (rc == COUNT);
+    close_messages (msgs, COUNT);
+
+    //  Receives what is queued, up to the array size
+    for (int i = 0; i < COUNT; i++) {
+        rc = zmq_msg_init (&msgs[i]);
+        assert (rc == 0);
+    }
+    rc = zmq_msg_recv_many (msgs, COUNT / 2, receiver, 0);
+    assert (rc == COUNT / 2);
+    rc = zmq_msg_recv_many (msgs + COUNT / 2, COUNT / 2, receiver, 0);
+    assert (rc == COUNT / 2);
+    for (int i = 0; i < COUNT; i++) {
+        assert (zmq_msg_size (&msgs[i]) == sizeof (int));
+        int value;
+        memcpy (&value, zmq_msg_data (&msgs[i]), sizeof value);
+        assert (value == i);
+    }
+
+    //  Nothing left
+    rc = zmq_msg_recv_many (msgs, COUNT, receiver, ZMQ_DONTWAIT);
+    assert (rc == -1);
+    assert (errno == EAGAIN);
+    close_messages (msgs, COUNT);
+
+    rc = zmq_close (receiver);
+    assert (rc == 0);
+    rc = zmq_close (sender);
+    assert (rc == 0);
+}
+
+void test_send_many_hwm (void *ctx_)
+{
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (push);
+    int hwm = 4;
+    int rc = zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_bind (push, "inproc://many-hwm");
+    assert (rc == 0);
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_connect (pull, "inproc://many-hwm");
+    assert (rc == 0);
+
+    //  Sends as many as the pipe takes and leaves the rest to the caller
+    zmq_msg_t msgs[COUNT];
+    init_messages (msgs, COUNT, 0);
+    const int sent = zmq_msg_send_many (msgs, COUNT, push, ZMQ_DONTWAIT);
+    assert (sent > 0 && sent < COUNT);
+    for (int i = sent; i < COUNT; i++) {
+        int value;
+        memcpy (&value, zmq_msg_data (&msgs[i]), sizeof value);
+        assert (value == i);
+    }
+    close_messages (msgs, COUNT);
+
+    //  The messages sent are delivered
+    for (int i = 0; i < COUNT; i++) {
+        rc = zmq_msg_init (&msgs[i]);
+        assert (rc == 0);
+    }
+    rc = zmq_msg_recv_many (msgs, COUNT, pull, ZMQ_DONTWAIT);
+    assert (rc == sent);
+    close_messages (msgs, COUNT);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+}
+
+void test_invalid_arguments (void *ctx_)
+{
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    assert (pull);
+
+    zmq_msg_t msgs[2];
+    int rc = zmq_msg_recv_many (msgs, 0, pull, ZMQ_DONTWAIT);
+    assert (rc == -1);
+    assert (errno == EINVAL);
+    rc = zmq_msg_recv_many (NULL, 2, pull, ZMQ_DONTWAIT);
+    assert (rc == -1);
+    assert (errno == EINVAL);
+    rc = zmq_msg_send_many (msgs, 2, NULL, 0);
+    assert (rc == -1);
+    assert (errno == ENOTSOCK);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    test_send_recv_many (ctx, ZMQ_PUSH);
+    test_send_recv_many (ctx, ZMQ_CLIENT);
+    test_send_many_hwm (ctx);
+    test_invalid_arguments (ctx);
+
+    int rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
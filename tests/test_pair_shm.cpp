@@ -0,0 +1,338 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/un.h>
+#include <dirent.h>
+#include <fcntl.h>
+
+const char *endpoint = "shm:///tmp/test_pair_shm";
+
+//  Large enough for a few messages to fill the ring of a connection.
+const size_t big_size = 300 * 1000;
+
+static void send_big (void *socket_, unsigned char seed_, int flags_, int *rc_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init_size (&msg, big_size);
+    assert (rc == 0);
+    unsigned char *data = (unsigned char *) zmq_msg_data (&msg);
+    for (size_t i = 0; i < big_size; i++)
+        data[i] = (unsigned char) (seed_ + i);
+    *rc_ = zmq_msg_send (&msg, socket_, flags_);
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+}
+
+static void recv_big (void *socket_, unsigned char seed_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    assert (rc == 0);
+    rc = zmq_msg_recv (&msg, socket_, 0);
+    assert (rc == (int) big_size);
+    const unsigned char *data = (const unsigned char *) zmq_msg_data (&msg);
+    for (size_t i = 0; i < big_size; i++)
+        assert (data[i] == (unsigned char) (seed_ + i));
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+}
+
+//  More data than the rings hold go through, in order.
+void test_large_messages (void *sb_, void *sc_)
+{
+    const int count = 10;
+    int rc;
+    for (int i = 0; i < count; i++) {
+        send_big (sc_, (unsigned char) i, 0, &rc);
+        assert (rc == (int) big_size);
+    }
+    for (int i = 0; i < count; i++)
+        recv_big (sb_, (unsigned char) i);
+}
+
+//  Both peers fill their outbound rings while neither of them reads.
+//  Each has to resume writing while its own input is stopped.
+void test_both_blocked (void *ctx_)
+{
+    void *sb = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sb);
+    void *sc = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sc);
+    int hwm = 2;
+    int rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_setsockopt (sc, ZMQ_RCVHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_bind (sb, "shm://*");
+    assert (rc == 0);
+    char bound[256];
+    size_t len = sizeof bound;
+    rc = zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, bound, &len);
+    assert (rc == 0);
+    rc = zmq_connect (sc, bound);
+    assert (rc == 0);
+    bounce (sb, sc);
+
+    //  Queue messages on both sides until the pipes are full.
+    int sent_b = 0;
+    int sent_c = 0;
+    while (true) {
+        send_big (sb, (unsigned char) sent_b, ZMQ_DONTWAIT, &rc);
+        if (rc == -1)
+            break;
+        sent_b++;
+    }
+    assert (errno == EAGAIN);
+    while (true) {
+        send_big (sc, (unsigned char) sent_c, ZMQ_DONTWAIT, &rc);
+        if (rc == -1)
+            break;
+        sent_c++;
+    }
+    assert (errno == EAGAIN);
+    msleep (SETTLE_TIME);
+
+    for (int i = 0; i < sent_c; i++)
+        recv_big (sb, (unsigned char) i);
+    for (int i = 0; i < sent_b; i++)
+        recv_big (sc, (unsigned char) i);
+
+    close_zero_linger (sc);
+    close_zero_linger (sb);
+}
+
+//  The transport works across processes.
+void test_fork (void *ctx_)
+{
+    const char *fork_endpoint = "shm:///tmp/test_pair_shm_fork";
+    void *sb = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, fork_endpoint);
+    assert (rc == 0);
+
+    int pid = fork ();
+    if (pid == 0) {
+        void *ctx = zmq_ctx_new ();
+        assert (ctx);
+        void *sc = zmq_socket (ctx, ZMQ_PAIR);
+        assert (sc);
+        rc = zmq_connect (sc, fork_endpoint);
+        assert (rc == 0);
+        rc = zmq_send (sc, "ping", 4, 0);
+        assert (rc == 4);
+        char buffer[16];
+        rc = zmq_recv (sc, buffer, sizeof buffer, 0);
+        assert (rc == 4);
+        assert (memcmp (buffer, "pong", 4) == 0);
+        rc = zmq_close (sc);
+        assert (rc == 0);
+        rc = zmq_ctx_term (ctx);
+        assert (rc == 0);
+        exit (0);
+    }
+    assert (pid > 0);
+
+    char buffer[16];
+    rc = zmq_recv (sb, buffer, sizeof buffer, 0);
+    assert (rc == 4);
+    assert (memcmp (buffer, "ping", 4) == 0);
+    rc = zmq_send (sb, "pong", 4, 0);
+    assert (rc == 4);
+
+    int child_status;
+    while (true) {
+        rc = waitpid (pid, &child_status, 0);
+        if (rc == -1 && errno == EINTR)
+            continue;
+        assert (rc > 0);
+        assert (WIFEXITED (child_status) && WEXITSTATUS (child_status) == 0);
+        break;
+    }
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+}
+
+//  Returns the number of descriptors open on segments made by
+//  sealed_segment.
+static int count_segments ()
+{
+    DIR *dir = opendir ("/proc/self/fd");
+    assert (dir);
+    int count = 0;
+    while (struct dirent *entry = readdir (dir)) {
+        char path[sizeof "/proc/self/fd/" + sizeof entry->d_name];
+        char target[256];
+        snprintf (path, sizeof path, "/proc/self/fd/%s", entry->d_name);
+        const ssize_t size = readlink (path, target, sizeof target - 1);
+        if (size <= 0)
+            continue;
+        target[size] = 0;
+        if (strncmp (target, "/memfd:test-shm", 15) == 0)
+            count++;
+    }
+    int rc = closedir (dir);
+    assert (rc == 0);
+    return count;
+}
+
+static int sealed_segment ()
+{
+    int fd = memfd_create ("test-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    assert (fd != -1);
+    int rc = ftruncate (fd, 4096);
+    assert (rc == 0);
+    rc = fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW);
+    assert (rc == 0);
+    return fd;
+}
+
+//  A peer passing more descriptors than the one segment expected is
+//  rejected, and none of them stays open.
+void test_reject_extra_fds (void *ctx_)
+{
+    void *sb = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, "shm:///tmp/test_pair_shm_fds");
+    assert (rc == 0);
+
+    int s = socket (AF_UNIX, SOCK_STREAM, 0);
+    assert (s != -1);
+    struct sockaddr_un addr;
+    memset (&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    strcpy (addr.sun_path, "/tmp/test_pair_shm_fds");
+    rc = connect (s, (struct sockaddr *) &addr, sizeof addr);
+    assert (rc == 0);
+    struct timeval timeout = {5, 0};
+    rc = setsockopt (s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    assert (rc == 0);
+
+    //  The marker byte the engine sends along with its segment.
+    unsigned char marker = 0xa5;
+    struct iovec iov;
+    iov.iov_base = &marker;
+    iov.iov_len = sizeof marker;
+
+    int segments[2] = {sealed_segment (), sealed_segment ()};
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE (sizeof segments)];
+    } control;
+    memset (&control, 0, sizeof control);
+
+    struct msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof segments);
+    memcpy (CMSG_DATA (cmsg), segments, sizeof segments);
+    rc = (int) sendmsg (s, &msg, 0);
+    assert (rc == 1);
+    for (int i = 0; i < 2; i++) {
+        rc = close (segments[i]);
+        assert (rc == 0);
+    }
+
+    //  The engine drops the connection. Its own segment, which it sent
+    //  first, is discarded unread.
+    char buffer[64];
+    ssize_t nbytes;
+    do
+        nbytes = recv (s, buffer, sizeof buffer, 0);
+    while (nbytes > 0);
+    assert (nbytes == 0);
+    rc = close (s);
+    assert (rc == 0);
+
+    msleep (SETTLE_TIME);
+    assert (count_segments () == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    if (!zmq_has ("shm")) {
+        printf ("shm transport not available, skipping test\n");
+        return 0;
+    }
+
+    setup_test_environment ();
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, endpoint);
+    assert (rc == 0);
+
+    char bound[256];
+    size_t len = sizeof bound;
+    rc = zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, bound, &len);
+    assert (rc == 0);
+    assert (strcmp (bound, endpoint) == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, endpoint);
+    assert (rc == 0);
+
+    bounce (sb, sc);
+    test_large_messages (sb, sc);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_unbind (sb, endpoint);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    test_fork (ctx);
+    test_both_blocked (ctx);
+    test_reject_extra_fds (ctx);
+
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
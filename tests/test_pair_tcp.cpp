@@ -41,6 +41,57 @@ void set_sockopt_fastpath (void *socket)
 }
 #endif
 
+#ifdef ZMQ_BUILD_DRAFT_API
+void set_sockopt_zerocopy (void *socket)
+{
+    int value = 8192;
+    int rc = zmq_setsockopt (socket, ZMQ_TCP_ZEROCOPY_THRESHOLD, &value,
+                             sizeof value);
+    assert (rc == 0);
+}
+
+void set_sockopt_small_batches (void *socket)
+{
+    int value = 1000;
+    int rc =
+      zmq_setsockopt (socket, ZMQ_IN_BATCH_SIZE, &value, sizeof value);
+    assert (rc == 0);
+    value = 1500;
+    rc = zmq_setsockopt (socket, ZMQ_OUT_BATCH_SIZE, &value, sizeof value);
+    assert (rc == 0);
+}
+
+void set_sockopt_adaptive_batches (void *socket)
+{
+    //  Batch sizes outside of 64..1048576 bytes are rejected.
+    int value = 63;
+    int rc =
+      zmq_setsockopt (socket, ZMQ_IN_BATCH_SIZE, &value, sizeof value);
+    assert (rc == -1 && errno == EINVAL);
+    value = 1048577;
+    rc = zmq_setsockopt (socket, ZMQ_OUT_BATCH_SIZE, &value, sizeof value);
+    assert (rc == -1 && errno == EINVAL);
+
+    value = 262144;
+    rc = zmq_setsockopt (socket, ZMQ_IN_BATCH_SIZE, &value, sizeof value);
+    assert (rc == 0);
+    rc = zmq_setsockopt (socket, ZMQ_OUT_BATCH_SIZE, &value, sizeof value);
+    assert (rc == 0);
+    value = 1;
+    rc = zmq_setsockopt (socket, ZMQ_ADAPTIVE_BATCH_SIZE, &value,
+                         sizeof value);
+    assert (rc == 0);
+
+    size_t size = sizeof value;
+    rc = zmq_getsockopt (socket, ZMQ_IN_BATCH_SIZE, &value, &size);
+    assert (rc == 0);
+    assert (value == 262144);
+    rc = zmq_getsockopt (socket, ZMQ_ADAPTIVE_BATCH_SIZE, &value, &size);
+    assert (rc == 0);
+    assert (value == 1);
+}
+#endif
+
 void test_pair_tcp (extra_func_t extra_func = NULL)
 {
     size_t len = MAX_SOCKET_STRING;
@@ -79,11 +130,175 @@ void test_pair_tcp (extra_func_t extra_func = NULL)
     assert (rc == 0);
 }
 
+//  Sends a burst of messages mixing sizes below and above the point where
+//  the engine stops copying message bodies into its output batch.
+void test_pair_tcp_mixed_sizes (extra_func_t extra_func = NULL)
+{
+    size_t len = MAX_SOCKET_STRING;
+    char my_endpoint[MAX_SOCKET_STRING];
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    if (extra_func)
+        extra_func (sb);
+
+    int rc = zmq_bind (sb, "tcp://127.0.0.1:*");
+    assert (rc == 0);
+    rc = zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, my_endpoint, &len);
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    if (extra_func)
+        extra_func (sc);
+
+    rc = zmq_connect (sc, my_endpoint);
+    assert (rc == 0);
+
+    const size_t sizes[] = {1, 100, 4095, 4096, 5000, 8192, 9000, 70000, 0};
+    const int nsizes = sizeof sizes / sizeof sizes[0];
+    const int count = 200;
+
+    for (int i = 0; i < count; i++) {
+        const size_t size = sizes[i % nsizes];
+        zmq_msg_t msg;
+        rc = zmq_msg_init_size (&msg, size);
+        assert (rc == 0);
+        unsigned char *data = (unsigned char *) zmq_msg_data (&msg);
+        for (size_t j = 0; j < size; j++)
+            data[j] = (unsigned char) (i + j);
+        rc = zmq_msg_send (&msg, sc, i % 3 == 0 ? ZMQ_SNDMORE : 0);
+        assert (rc == (int) size);
+    }
+
+    for (int i = 0; i < count; i++) {
+        const size_t size = sizes[i % nsizes];
+        zmq_msg_t msg;
+        rc = zmq_msg_init (&msg);
+        assert (rc == 0);
+        rc = zmq_msg_recv (&msg, sb, 0);
+        assert (rc == (int) size);
+        assert (zmq_msg_more (&msg) == (i % 3 == 0 ? 1 : 0));
+        const unsigned char *data = (unsigned char *) zmq_msg_data (&msg);
+        for (size_t j = 0; j < size; j++)
+            assert (data[j] == (unsigned char) (i + j));
+        rc = zmq_msg_close (&msg);
+        assert (rc == 0);
+    }
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+}
+
+#ifdef ZMQ_BUILD_DRAFT_API
+static void free_counted (void *data_, void *hint_)
+{
+    free (data_);
+    zmq_atomic_counter_inc (hint_);
+}
+
+//  Sends large messages without copying them and closes the sender right
+//  away; the messages are released once the kernel is done with them.
+void test_pair_tcp_zerocopy_release ()
+{
+    size_t len = MAX_SOCKET_STRING;
+    char my_endpoint[MAX_SOCKET_STRING];
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, "tcp://127.0.0.1:*");
+    assert (rc == 0);
+    rc = zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, my_endpoint, &len);
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    set_sockopt_zerocopy (sc);
+    rc = zmq_connect (sc, my_endpoint);
+    assert (rc == 0);
+
+    void *released = zmq_atomic_counter_new ();
+    assert (released);
+
+    const size_t size = 65536;
+    const int count = 16;
+    for (int i = 0; i < count; i++) {
+        unsigned char *data = (unsigned char *) malloc (size);
+        assert (data);
+        for (size_t j = 0; j < size; j++)
+            data[j] = (unsigned char) (i + j);
+        zmq_msg_t msg;
+        rc = zmq_msg_init_data (&msg, data, size, free_counted, released);
+        assert (rc == 0);
+        rc = zmq_msg_send (&msg, sc, 0);
+        assert (rc == (int) size);
+    }
+
+    zmq_msg_t msg;
+    rc = zmq_msg_init (&msg);
+    assert (rc == 0);
+    rc = zmq_msg_recv (&msg, sb, 0);
+    assert (rc == (int) size);
+    zmq_socket_statistics_t stats;
+    rc = zmq_socket_stats (sc, &stats);
+    assert (rc == 0);
+#if defined ZMQ_HAVE_LINUX && defined SO_ZEROCOPY
+    assert (stats.zerocopy_writes > 0);
+#endif
+
+    //  Close the sender with data possibly still in flight.
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    for (int i = 1; i < count; i++) {
+        rc = zmq_msg_recv (&msg, sb, 0);
+        assert (rc == (int) size);
+        const unsigned char *data = (unsigned char *) zmq_msg_data (&msg);
+        for (size_t j = 0; j < size; j++)
+            assert (data[j] == (unsigned char) (i + j));
+    }
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+
+    //  With the data received, the kernel reports the zero-copy writes
+    //  complete and the messages are released without the context
+    //  having to go away.
+    for (int i = 0; i < 100 && zmq_atomic_counter_value (released) < count;
+         i++)
+        msleep (10);
+    assert (zmq_atomic_counter_value (released) == count);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    zmq_atomic_counter_destroy (&released);
+}
+#endif
+
 int main (void)
 {
     setup_test_environment ();
 
     test_pair_tcp ();
+    test_pair_tcp_mixed_sizes ();
+#ifdef ZMQ_BUILD_DRAFT_API
+    test_pair_tcp_mixed_sizes (set_sockopt_zerocopy);
+    test_pair_tcp_mixed_sizes (set_sockopt_small_batches);
+    test_pair_tcp_mixed_sizes (set_sockopt_adaptive_batches);
+    test_pair_tcp_zerocopy_release ();
+#endif
 #ifdef ZMQ_BUILD_DRAFT
     test_pair_tcp (set_sockopt_fastpath);
 #endif
@@ -48,6 +48,7 @@
 #define ROUTING_ID_SIZE_MAX 32
 #define QT_WORKERS 5
 #define QT_CLIENTS 3
+#define BURST_SIZE 10000
 #define is_verbose 0
 
 struct thread_data
@@ -421,6 +422,113 @@ void check_proxy_stats (void *control_proxy)
             == (unsigned) zmq_atomic_counter_value (g_clients_pkts_out));
 }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+// Forwards from a PULL frontend to a PUSH backend until terminated
+static void burst_proxy_task (void *ctx)
+{
+    void *frontend = zmq_socket (ctx, ZMQ_PULL);
+    assert (frontend);
+    int rc = zmq_bind (frontend, "inproc://burst_frontend");
+    assert (rc == 0);
+    void *backend = zmq_socket (ctx, ZMQ_PUSH);
+    assert (backend);
+    rc = zmq_bind (backend, "inproc://burst_backend");
+    assert (rc == 0);
+    void *control = zmq_socket (ctx, ZMQ_REP);
+    assert (control);
+    rc = zmq_connect (control, "inproc://burst_control");
+    assert (rc == 0);
+
+    rc = zmq_proxy_steerable (frontend, backend, NULL, control);
+    assert (rc == 0);
+
+    rc = zmq_close (frontend);
+    assert (rc == 0);
+    rc = zmq_close (backend);
+    assert (rc == 0);
+    rc = zmq_close (control);
+    assert (rc == 0);
+}
+
+// The proxy forwards a burst in batches of several messages per poll
+// cycle. Every message of the burst must still be counted once, including
+// the multipart ones.
+void test_burst_stats (void *ctx)
+{
+    void *control = zmq_socket (ctx, ZMQ_REQ);
+    assert (control);
+    int linger = 0;
+    int rc = zmq_setsockopt (control, ZMQ_LINGER, &linger, sizeof (linger));
+    assert (rc == 0);
+    rc = zmq_bind (control, "inproc://burst_control");
+    assert (rc == 0);
+
+    void *thread = zmq_threadstart (&burst_proxy_task, ctx);
+
+    // The whole burst is queued before anything is read
+    void *source = zmq_socket (ctx, ZMQ_PUSH);
+    assert (source);
+    int hwm = 0;
+    rc = zmq_setsockopt (source, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_connect (source, "inproc://burst_frontend");
+    assert (rc == 0);
+    void *sink = zmq_socket (ctx, ZMQ_PULL);
+    assert (sink);
+    rc = zmq_connect (sink, "inproc://burst_backend");
+    assert (rc == 0);
+
+    // Every tenth message has two parts, all of them 3 bytes in total
+    for (int i = 0; i < BURST_SIZE; i++) {
+        if (i % 10 == 0) {
+            rc = zmq_send (source, "A", 1, ZMQ_SNDMORE);
+            assert (rc == 1);
+            rc = zmq_send (source, "BC", 2, 0);
+            assert (rc == 2);
+        } else {
+            rc = zmq_send (source, "ABC", 3, 0);
+            assert (rc == 3);
+        }
+    }
+
+    char buffer[CONTENT_SIZE_MAX];
+    for (int i = 0; i < BURST_SIZE; i++) {
+        size_t size = 0;
+        int more;
+        size_t moresz = sizeof more;
+        do {
+            rc = zmq_recv (sink, buffer, sizeof buffer, 0);
+            assert (rc >= 0);
+            size += rc;
+            rc = zmq_getsockopt (sink, ZMQ_RCVMORE, &more, &moresz);
+            assert (rc == 0);
+        } while (more);
+        assert (size == 3);
+    }
+
+    rc = zmq_send (control, "STATISTICS", 10, 0);
+    assert (rc == 10);
+    assert (recv_stat (control, false) == BURST_SIZE);
+    assert (recv_stat (control, false) == 3 * BURST_SIZE);
+    assert (recv_stat (control, false) == 0);
+    assert (recv_stat (control, false) == 0);
+    assert (recv_stat (control, false) == 0);
+    assert (recv_stat (control, false) == 0);
+    assert (recv_stat (control, false) == BURST_SIZE);
+    assert (recv_stat (control, true) == 3 * BURST_SIZE);
+
+    rc = zmq_send (control, "TERMINATE", 9, 0);
+    assert (rc == 9);
+    zmq_threadclose (thread);
+
+    rc = zmq_close (source);
+    assert (rc == 0);
+    rc = zmq_close (sink);
+    assert (rc == 0);
+    rc = zmq_close (control);
+    assert (rc == 0);
+}
+#endif
 
 // The main thread simply starts several clients and a server, and then
 // waits for the server to finish.
@@ -497,6 +605,10 @@ int main (void)
     for (int i = 0; i < QT_CLIENTS + 1; i++)
         zmq_threadclose (threads[i]);
 
+#ifdef ZMQ_BUILD_DRAFT_API
+    test_burst_stats (ctx);
+#endif
+
     rc = zmq_ctx_term (ctx);
     assert (rc == 0);
     return 0;
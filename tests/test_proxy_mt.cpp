@@ -0,0 +1,260 @@
+/*
+    Copyright (c) 2007-2017 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+//  Runs a ROUTER/DEALER broker with one forwarding loop per shard and
+//  steers it from a PAIR control socket.
+
+#define SHARDS 2
+
+void proxy_task (void *ctx_)
+{
+    void *frontends[SHARDS];
+    void *backends[SHARDS];
+    char endpoint[32];
+    for (int i = 0; i < SHARDS; i++) {
+        frontends[i] = zmq_socket (ctx_, ZMQ_ROUTER);
+        assert (frontends[i]);
+        sprintf (endpoint, "inproc://frontend-%d", i);
+        int rc = zmq_bind (frontends[i], endpoint);
+        assert (rc == 0);
+
+        backends[i] = zmq_socket (ctx_, ZMQ_DEALER);
+        assert (backends[i]);
+        sprintf (endpoint, "inproc://backend-%d", i);
+        rc = zmq_bind (backends[i], endpoint);
+        assert (rc == 0);
+    }
+
+    void *control = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (control);
+    int rc = zmq_connect (control, "inproc://control");
+    assert (rc == 0);
+
+    rc = zmq_proxy_mt (frontends, backends, SHARDS, control);
+    assert (rc == 0);
+
+    for (int i = 0; i < SHARDS; i++) {
+        rc = zmq_close (frontends[i]);
+        assert (rc == 0);
+        rc = zmq_close (backends[i]);
+        assert (rc == 0);
+    }
+    rc = zmq_close (control);
+    assert (rc == 0);
+}
+
+void send_recv (void *from_, void *to_, const char *content_)
+{
+    int rc = s_send (from_, content_);
+    assert (rc == (int) strlen (content_));
+    char *received = s_recv (to_);
+    assert (received);
+    assert (strcmp (received, content_) == 0);
+    free (received);
+}
+
+struct failing_proxy_t
+{
+    void *ctx;
+    int rc;
+    int err;
+};
+
+//  Runs a broker whose loops fail as soon as they forward a message to
+//  an unknown peer.
+void failing_proxy_task (void *arg_)
+{
+    failing_proxy_t *proxy = (failing_proxy_t *) arg_;
+    void *frontends[SHARDS];
+    void *backends[SHARDS];
+    char endpoint[32];
+    for (int i = 0; i < SHARDS; i++) {
+        frontends[i] = zmq_socket (proxy->ctx, ZMQ_PULL);
+        assert (frontends[i]);
+        sprintf (endpoint, "inproc://failing-frontend-%d", i);
+        int rc = zmq_bind (frontends[i], endpoint);
+        assert (rc == 0);
+
+        backends[i] = zmq_socket (proxy->ctx, ZMQ_ROUTER);
+        assert (backends[i]);
+        int mandatory = 1;
+        rc = zmq_setsockopt (backends[i], ZMQ_ROUTER_MANDATORY, &mandatory,
+                             sizeof mandatory);
+        assert (rc == 0);
+        sprintf (endpoint, "inproc://failing-backend-%d", i);
+        rc = zmq_bind (backends[i], endpoint);
+        assert (rc == 0);
+    }
+
+    void *control = zmq_socket (proxy->ctx, ZMQ_PAIR);
+    assert (control);
+    int rc = zmq_connect (control, "inproc://failing-control");
+    assert (rc == 0);
+
+    proxy->rc = zmq_proxy_mt (frontends, backends, SHARDS, control);
+    proxy->err = errno;
+
+    for (int i = 0; i < SHARDS; i++) {
+        close_zero_linger (frontends[i]);
+        close_zero_linger (backends[i]);
+    }
+    close_zero_linger (control);
+}
+
+void test_failed_loop (void *ctx_)
+{
+    void *control = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (control);
+    int rc = zmq_bind (control, "inproc://failing-control");
+    assert (rc == 0);
+
+    failing_proxy_t proxy = {ctx_, 0, 0};
+    void *thread = zmq_threadstart (&failing_proxy_task, &proxy);
+
+    //  Give the backend a peer, so that it is ready for writing.
+    msleep (SETTLE_TIME);
+    void *server = zmq_socket (ctx_, ZMQ_DEALER);
+    assert (server);
+    rc = zmq_connect (server, "inproc://failing-backend-0");
+    assert (rc == 0);
+
+    void *client = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (client);
+    rc = zmq_connect (client, "inproc://failing-frontend-0");
+    assert (rc == 0);
+    msleep (SETTLE_TIME);
+
+    rc = zmq_send (client, "nobody", 6, ZMQ_SNDMORE);
+    assert (rc == 6);
+    rc = zmq_send (client, "request", 7, 0);
+    assert (rc == 7);
+    msleep (SETTLE_TIME);
+
+    //  The loop of the first shard has failed. Rather than waiting for
+    //  its statistics, the proxy reports the failure and stops.
+    rc = zmq_send (control, "STATISTICS", 10, 0);
+    assert (rc == 10);
+    char buffer[8];
+    rc = zmq_recv (control, buffer, sizeof buffer, 0);
+    assert (rc == 5);
+    assert (memcmp (buffer, "ERROR", 5) == 0);
+
+    zmq_threadclose (thread);
+    assert (proxy.rc == -1);
+    assert (proxy.err == EHOSTUNREACH);
+
+    close_zero_linger (client);
+    close_zero_linger (server);
+    rc = zmq_close (control);
+    assert (rc == 0);
+}
+
+uint64_t recv_stat (void *control_, bool last_)
+{
+    uint64_t stat;
+    int rc = zmq_recv (control_, &stat, sizeof stat, 0);
+    assert (rc == sizeof stat);
+
+    int more;
+    size_t more_size = sizeof more;
+    rc = zmq_getsockopt (control_, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0);
+    assert (more == !last_);
+    return stat;
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *control = zmq_socket (ctx, ZMQ_PAIR);
+    assert (control);
+    int rc = zmq_bind (control, "inproc://control");
+    assert (rc == 0);
+
+    void *thread = zmq_threadstart (&proxy_task, ctx);
+
+    //  A client and a server on each shard; every request has to come
+    //  back through the loop that forwarded it.
+    void *clients[SHARDS];
+    void *servers[SHARDS];
+    char endpoint[32];
+    for (int i = 0; i < SHARDS; i++) {
+        clients[i] = zmq_socket (ctx, ZMQ_REQ);
+        assert (clients[i]);
+        sprintf (endpoint, "inproc://frontend-%d", i);
+        rc = zmq_connect (clients[i], endpoint);
+        assert (rc == 0);
+
+        servers[i] = zmq_socket (ctx, ZMQ_REP);
+        assert (servers[i]);
+        sprintf (endpoint, "inproc://backend-%d", i);
+        rc = zmq_connect (servers[i], endpoint);
+        assert (rc == 0);
+    }
+
+    for (int i = 0; i < SHARDS; i++) {
+        send_recv (clients[i], servers[i], "request");
+        send_recv (servers[i], clients[i], "reply");
+    }
+
+    //  Statistics are summed over all loops.
+    rc = zmq_send (control, "STATISTICS", 10, 0);
+    assert (rc == 10);
+    assert (recv_stat (control, false) == SHARDS);
+    recv_stat (control, false);
+    assert (recv_stat (control, false) == SHARDS);
+    recv_stat (control, false);
+    assert (recv_stat (control, false) == SHARDS);
+    recv_stat (control, false);
+    assert (recv_stat (control, false) == SHARDS);
+    recv_stat (control, true);
+
+    rc = zmq_send (control, "TERMINATE", 9, 0);
+    assert (rc == 9);
+    zmq_threadclose (thread);
+
+    for (int i = 0; i < SHARDS; i++) {
+        close_zero_linger (clients[i]);
+        close_zero_linger (servers[i]);
+    }
+    rc = zmq_close (control);
+    assert (rc == 0);
+
+    test_failed_loop (ctx);
+
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+void test_batch_held_back (void *ctx_)
+{
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (push);
+    int rc = zmq_bind (push, "inproc://batch");
+    assert (rc == 0);
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_connect (pull, "inproc://batch");
+    assert (rc == 0);
+
+    //  Batched messages are not visible to the peer yet
+    for (int i = 0; i < 10; i++) {
+        rc = zmq_send (push, "ABC", 3, ZMQ_SNDBATCH);
+        assert (rc == 3);
+    }
+    char buffer[8];
+    rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+    assert (rc == -1);
+    assert (errno == EAGAIN);
+
+    //  Multi-part messages can be batched as well
+    rc = zmq_send (push, "D", 1, ZMQ_SNDMORE | ZMQ_SNDBATCH);
+    assert (rc == 1);
+    rc = zmq_send (push, "E", 1, ZMQ_SNDBATCH);
+    assert (rc == 1);
+
+    //  The last message ends the batch
+    rc = zmq_send (push, "END", 3, 0);
+    assert (rc == 3);
+    for (int i = 0; i < 10; i++) {
+        rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+        assert (rc == 3);
+    }
+    rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+    assert (rc == 1);
+    int more;
+    size_t more_size = sizeof more;
+    rc = zmq_getsockopt (pull, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0);
+    assert (more == 1);
+    rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+    assert (rc == 1);
+    rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+    assert (rc == 3);
+    assert (memcmp (buffer, "END", 3) == 0);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+}
+
+void test_batch_flushed_at_hwm (void *ctx_)
+{
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (push);
+    int hwm = 5;
+    int rc = zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_bind (push, "inproc://hwm");
+    assert (rc == 0);
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_connect (pull, "inproc://hwm");
+    assert (rc == 0);
+
+    //  Once the pipe is full, the batch is handed over to the peer
+    int sent = 0;
+    while (zmq_send (push, "ABC", 3, ZMQ_SNDBATCH | ZMQ_DONTWAIT) == 3)
+        sent++;
+    assert (errno == EAGAIN);
+    assert (sent > 0);
+
+    char buffer[8];
+    for (int i = 0; i < sent; i++) {
+        rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+        assert (rc == 3);
+    }
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+}
+
+void test_publisher_burst (void *ctx_)
+{
+    void *pub = zmq_socket (ctx_, ZMQ_PUB);
+    assert (pub);
+    int rc = zmq_bind (pub, "tcp://127.0.0.1:*");
+    assert (rc == 0);
+    char endpoint[256];
+    size_t endpoint_len = sizeof endpoint;
+    rc = zmq_getsockopt (pub, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len);
+    assert (rc == 0);
+
+    void *subs[2];
+    for (int i = 0; i < 2; i++) {
+        subs[i] = zmq_socket (ctx_, ZMQ_SUB);
+        assert (subs[i]);
+        rc = zmq_setsockopt (subs[i], ZMQ_SUBSCRIBE, "", 0);
+        assert (rc == 0);
+        rc = zmq_connect (subs[i], endpoint);
+        assert (rc == 0);
+    }
+    msleep (SETTLE_TIME);
+
+    for (int i = 0; i < 999; i++) {
+        rc = zmq_send (pub, "burst", 5, ZMQ_SNDBATCH);
+        assert (rc == 5);
+    }
+    rc = zmq_send (pub, "burst", 5, 0);
+    assert (rc == 5);
+
+    char buffer[8];
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 1000; j++) {
+            rc = zmq_recv (subs[i], buffer, sizeof buffer, 0);
+            assert (rc == 5);
+        }
+
+    for (int i = 0; i < 2; i++) {
+        rc = zmq_close (subs[i]);
+        assert (rc == 0);
+    }
+    rc = zmq_close (pub);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    test_batch_held_back (ctx);
+    test_batch_flushed_at_hwm (ctx);
+    test_publisher_burst (ctx);
+
+    int rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
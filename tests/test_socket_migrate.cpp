@@ -0,0 +1,172 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+//  Messages in flight per direction while the connection is moved.
+const int batch = 100;
+const int rounds = 30;
+
+//  Large enough for messages to span several engine reads.
+const size_t msg_size = 10 * 1000;
+
+static void send_seq (void *socket_, int seq_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init_size (&msg, msg_size);
+    assert (rc == 0);
+    unsigned char *data = (unsigned char *) zmq_msg_data (&msg);
+    memset (data, (unsigned char) seq_, msg_size);
+    memcpy (data, &seq_, sizeof seq_);
+    rc = zmq_msg_send (&msg, socket_, 0);
+    assert (rc == (int) msg_size);
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+}
+
+static void recv_seq (void *socket_, int seq_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    assert (rc == 0);
+    rc = zmq_msg_recv (&msg, socket_, 0);
+    assert (rc == (int) msg_size);
+    const unsigned char *data = (const unsigned char *) zmq_msg_data (&msg);
+    int seq;
+    memcpy (&seq, data, sizeof seq);
+    assert (seq == seq_);
+    for (size_t i = sizeof seq; i < msg_size; i++)
+        assert (data[i] == (unsigned char) seq_);
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+}
+
+//  Moves both ends of a connection between the I/O threads repeatedly
+//  while messages flow both ways. Nothing may be lost, reordered or
+//  cause a reconnect.
+void test_migrate (void *ctx_, const char *endpoint_)
+{
+    void *sb = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sb);
+    void *sc = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sc);
+
+    //  Heartbeats keep the engines' timers busy as well.
+    int ivl = 10;
+    int rc = zmq_setsockopt (sb, ZMQ_HEARTBEAT_IVL, &ivl, sizeof ivl);
+    assert (rc == 0);
+    rc = zmq_setsockopt (sc, ZMQ_HEARTBEAT_IVL, &ivl, sizeof ivl);
+    assert (rc == 0);
+    int timeout = 5000;
+    rc = zmq_setsockopt (sb, ZMQ_HEARTBEAT_TIMEOUT, &timeout, sizeof timeout);
+    assert (rc == 0);
+    rc = zmq_setsockopt (sc, ZMQ_HEARTBEAT_TIMEOUT, &timeout, sizeof timeout);
+    assert (rc == 0);
+
+    rc = zmq_bind (sb, endpoint_);
+    assert (rc == 0);
+    char endpoint[256];
+    size_t len = sizeof endpoint;
+    rc = zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, endpoint, &len);
+    assert (rc == 0);
+    rc = zmq_connect (sc, endpoint);
+    assert (rc == 0);
+
+    bounce (sb, sc);
+
+    int seq = 0;
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < batch; i++) {
+            send_seq (sc, seq + i);
+            send_seq (sb, seq + i);
+        }
+
+        //  Each end in turn, to a thread chosen by a single-bit affinity
+        void *s = round % 2 ? sb : sc;
+        rc = zmq_socket_migrate (s, (uint64_t) 1 << (round / 2 % 3));
+        assert (rc == 0);
+        if (round % 5 == 0)
+            msleep (ivl * 2);
+
+        for (int i = 0; i < batch; i++) {
+            recv_seq (sb, seq + i);
+            recv_seq (sc, seq + i);
+        }
+        seq += batch;
+    }
+
+    bounce (sb, sc);
+    zmq_socket_statistics_t stats;
+    rc = zmq_socket_stats (sc, &stats);
+    assert (rc == 0);
+    assert (stats.reconnects == 0);
+
+    close_zero_linger (sc);
+    close_zero_linger (sb);
+}
+
+//  Migrating a socket without connections does nothing; an affinity
+//  without an I/O thread is rejected.
+void test_migrate_idle (void *ctx_)
+{
+    void *s = zmq_socket (ctx_, ZMQ_DEALER);
+    assert (s);
+    int rc = zmq_socket_migrate (s, 2);
+    assert (rc == 0);
+    rc = zmq_socket_migrate (s, (uint64_t) 1 << 63);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_bind (s, "tcp://127.0.0.1:*");
+    assert (rc == 0);
+    rc = zmq_socket_migrate (s, 4);
+    assert (rc == 0);
+    close_zero_linger (s);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+    int rc = zmq_ctx_set (ctx, ZMQ_IO_THREADS, 3);
+    assert (rc == 0);
+
+    test_migrate_idle (ctx);
+    test_migrate (ctx, "tcp://127.0.0.1:*");
+#if !defined ZMQ_HAVE_WINDOWS && !defined ZMQ_HAVE_OPENVMS
+    test_migrate (ctx, "ipc:///tmp/test_socket_migrate");
+#endif
+    if (zmq_has ("shm"))
+        test_migrate (ctx, "shm:///tmp/test_socket_migrate_shm");
+
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
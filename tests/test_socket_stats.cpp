@@ -0,0 +1,297 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "testutil.hpp"
+
+void test_push_pull (void *ctx_)
+{
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (push);
+    int rc = zmq_bind (push, "inproc://stats");
+    assert (rc == 0);
+
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_connect (pull, "inproc://stats");
+    assert (rc == 0);
+
+    //  One single-part and one two-part message
+    rc = zmq_send (push, "ABC", 3, 0);
+    assert (rc == 3);
+    rc = zmq_send (push, "DE", 2, ZMQ_SNDMORE);
+    assert (rc == 2);
+    rc = zmq_send (push, "F", 1, 0);
+    assert (rc == 1);
+
+    zmq_socket_statistics_t stats;
+    rc = zmq_socket_stats (push, &stats);
+    assert (rc == 0);
+    assert (stats.msgs_out == 2);
+    assert (stats.bytes_out == 6);
+    assert (stats.queue_depth == 2);
+    assert (stats.msgs_in == 0);
+    assert (stats.hwm_drops == 0);
+
+    char buffer[8];
+    rc = zmq_recv (pull, buffer, sizeof buffer, 0);
+    assert (rc == 3);
+    rc = zmq_recv (pull, buffer, sizeof buffer, 0);
+    assert (rc == 2);
+    rc = zmq_recv (pull, buffer, sizeof buffer, 0);
+    assert (rc == 1);
+
+    //  Nothing left to read
+    rc = zmq_recv (pull, buffer, sizeof buffer, ZMQ_DONTWAIT);
+    assert (rc == -1);
+    assert (errno == EAGAIN);
+
+    rc = zmq_socket_stats (pull, &stats);
+    assert (rc == 0);
+    assert (stats.msgs_in == 2);
+    assert (stats.bytes_in == 6);
+    assert (stats.eagains == 1);
+    assert (stats.msgs_out == 0);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+
+    //  The pusher has not been told yet that the messages were read, but
+    //  they leave its queue along with the pipe.
+    msleep (SETTLE_TIME);
+    int events;
+    size_t events_size = sizeof events;
+    rc = zmq_getsockopt (push, ZMQ_EVENTS, &events, &events_size);
+    assert (rc == 0);
+    rc = zmq_socket_stats (push, &stats);
+    assert (rc == 0);
+    assert (stats.queue_depth == 0);
+
+    rc = zmq_close (push);
+    assert (rc == 0);
+}
+
+const uint64_t burst_size = 100000;
+
+static void stats_reader (void *push_)
+{
+    //  Watch the counters go up while the main thread is sending.
+    zmq_socket_statistics_t stats;
+    uint64_t msgs_out = 0;
+    while (msgs_out < burst_size) {
+        int rc = zmq_socket_stats (push_, &stats);
+        assert (rc == 0);
+        assert (stats.msgs_out >= msgs_out);
+        assert (stats.msgs_out <= burst_size);
+        msgs_out = stats.msgs_out;
+    }
+}
+
+void test_read_from_thread (void *ctx_)
+{
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (push);
+    int hwm = 0;
+    int rc = zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_bind (push, "inproc://reader");
+    assert (rc == 0);
+
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_connect (pull, "inproc://reader");
+    assert (rc == 0);
+
+    void *reader = zmq_threadstart (stats_reader, push);
+    assert (reader);
+
+    for (uint64_t i = 0; i != burst_size; i++) {
+        rc = zmq_send (push, "X", 1, 0);
+        assert (rc == 1);
+    }
+
+    zmq_threadclose (reader);
+
+    zmq_socket_statistics_t stats;
+    rc = zmq_socket_stats (push, &stats);
+    assert (rc == 0);
+    assert (stats.msgs_out == burst_size);
+    assert (stats.bytes_out == burst_size);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+}
+
+void test_hwm_drops (void *ctx_)
+{
+    void *pub = zmq_socket (ctx_, ZMQ_PUB);
+    assert (pub);
+    int hwm = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://drops");
+    assert (rc == 0);
+
+    void *sub = zmq_socket (ctx_, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof hwm);
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    rc = zmq_connect (sub, "inproc://drops");
+    assert (rc == 0);
+
+    msleep (SETTLE_TIME);
+
+    //  The subscriber never reads, so the publisher has to drop
+    for (int i = 0; i < 100; i++) {
+        rc = zmq_send (pub, "X", 1, 0);
+        assert (rc == 1);
+    }
+
+    zmq_socket_statistics_t stats;
+    rc = zmq_socket_stats (pub, &stats);
+    assert (rc == 0);
+    assert (stats.msgs_out == 100);
+    assert (stats.hwm_drops > 0);
+    assert (stats.hwm_drops < 100);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+}
+
+void test_router_peers (void *ctx_)
+{
+    void *router = zmq_socket (ctx_, ZMQ_ROUTER);
+    assert (router);
+    int rc = zmq_bind (router, "inproc://peers");
+    assert (rc == 0);
+
+    void *dealer_a = zmq_socket (ctx_, ZMQ_DEALER);
+    assert (dealer_a);
+    rc = zmq_setsockopt (dealer_a, ZMQ_ROUTING_ID, "A", 1);
+    assert (rc == 0);
+    rc = zmq_connect (dealer_a, "inproc://peers");
+    assert (rc == 0);
+
+    void *dealer_b = zmq_socket (ctx_, ZMQ_DEALER);
+    assert (dealer_b);
+    rc = zmq_setsockopt (dealer_b, ZMQ_ROUTING_ID, "B", 1);
+    assert (rc == 0);
+    rc = zmq_connect (dealer_b, "inproc://peers");
+    assert (rc == 0);
+
+    rc = zmq_send (dealer_a, "HELLO", 5, 0);
+    assert (rc == 5);
+    rc = zmq_send (dealer_b, "HI", 2, 0);
+    assert (rc == 2);
+
+    char buffer[8];
+    for (int i = 0; i != 2; i++) {
+        rc = zmq_recv (router, buffer, sizeof buffer, 0);
+        assert (rc == 1);
+        rc = zmq_recv (router, buffer, sizeof buffer, 0);
+        assert (rc == 5 || rc == 2);
+    }
+
+    //  Two messages to A, none to B
+    for (int i = 0; i != 2; i++) {
+        rc = zmq_send (router, "A", 1, ZMQ_SNDMORE);
+        assert (rc == 1);
+        rc = zmq_send (router, "ABC", 3, 0);
+        assert (rc == 3);
+    }
+
+    zmq_socket_statistics_t stats;
+    rc = zmq_socket_peer_stats (router, "A", 1, &stats);
+    assert (rc == 0);
+    assert (stats.msgs_in == 1);
+    assert (stats.bytes_in == 5);
+    assert (stats.msgs_out == 2);
+    assert (stats.bytes_out == 6);
+    assert (stats.queue_depth == 2);
+
+    rc = zmq_socket_peer_stats (router, "B", 1, &stats);
+    assert (rc == 0);
+    assert (stats.msgs_in == 1);
+    assert (stats.bytes_in == 2);
+    assert (stats.msgs_out == 0);
+    assert (stats.queue_depth == 0);
+
+    //  The socket totals add up the peers
+    rc = zmq_socket_stats (router, &stats);
+    assert (rc == 0);
+    assert (stats.msgs_in == 2);
+    assert (stats.msgs_out == 2);
+    assert (stats.queue_depth == 2);
+
+    rc = zmq_socket_peer_stats (router, "C", 1, &stats);
+    assert (rc == -1);
+    assert (errno == EHOSTUNREACH);
+
+    //  Peers of a DEALER cannot be addressed
+    rc = zmq_socket_peer_stats (dealer_a, "A", 1, &stats);
+    assert (rc == -1);
+    assert (errno == ENOTSUP);
+
+    rc = zmq_close (dealer_b);
+    assert (rc == 0);
+    rc = zmq_close (dealer_a);
+    assert (rc == 0);
+    rc = zmq_close (router);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    test_push_pull (ctx);
+    test_hwm_drops (ctx);
+    test_router_peers (ctx);
+    test_read_from_thread (ctx);
+
+    //  Invalid arguments
+    int rc = zmq_socket_stats (NULL, NULL);
+    assert (rc == -1);
+    assert (errno == ENOTSOCK);
+
+    rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
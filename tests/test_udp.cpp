@@ -121,6 +121,27 @@ int main (void)
     rc = msg_recv_cmp (&msg, dish, "TV", "Friends");
     assert (rc != -1);
 
+    //  A burst larger than the engines' datagram batch
+    for (int i = 0; i < 50; i++) {
+        rc = msg_send (&msg, radio, "TV", "Friends");
+        assert (rc != -1);
+    }
+    for (int i = 0; i < 50; i++) {
+        rc = msg_recv_cmp (&msg, dish, "TV", "Friends");
+        assert (rc != -1);
+    }
+
+    //  A message too large for a datagram is dropped
+    char too_large[9001];
+    memset (too_large, 'X', sizeof too_large - 1);
+    too_large[sizeof too_large - 1] = '\0';
+    rc = msg_send (&msg, radio, "TV", too_large);
+    assert (rc != -1);
+    rc = msg_send (&msg, radio, "TV", "Seinfeld");
+    assert (rc != -1);
+    rc = msg_recv_cmp (&msg, dish, "TV", "Seinfeld");
+    assert (rc != -1);
+
     rc = zmq_close (dish);
     assert (rc == 0);
 
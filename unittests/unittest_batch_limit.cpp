@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <batch_limit.hpp>
+#include <msg.hpp>
+#include <v2_encoder.hpp>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+
+void tearDown ()
+{
+}
+
+void test_fixed_limit ()
+{
+    zmq::batch_limit_t limit (65536, false, zmq::out_batch_size);
+    TEST_ASSERT_EQUAL_UINT (65536, limit.get ());
+
+    limit.update (0);
+    TEST_ASSERT_EQUAL_UINT (65536, limit.get ());
+    limit.update (65536);
+    TEST_ASSERT_EQUAL_UINT (65536, limit.get ());
+}
+
+void test_initial_limit_capped ()
+{
+    zmq::batch_limit_t limit (4096, true, zmq::out_batch_size);
+    TEST_ASSERT_EQUAL_UINT (4096, limit.get ());
+
+    zmq::batch_limit_t large (262144, true, zmq::out_batch_size);
+    TEST_ASSERT_EQUAL_UINT (zmq::out_batch_size, large.get ());
+}
+
+void test_grows_under_load ()
+{
+    zmq::batch_limit_t limit (262144, true, zmq::out_batch_size);
+
+    size_t previous = limit.get ();
+    while (limit.get () < 262144) {
+        limit.update (limit.get ());
+        TEST_ASSERT_EQUAL_UINT (previous * 2, limit.get ());
+        previous = limit.get ();
+    }
+
+    //  Never grows beyond the configured batch size.
+    limit.update (limit.get ());
+    TEST_ASSERT_EQUAL_UINT (262144, limit.get ());
+}
+
+void test_shrinks_when_sparse ()
+{
+    zmq::batch_limit_t limit (262144, true, 262144);
+
+    //  Operations using between a quarter and all of the limit keep it.
+    limit.update (262144 / 4);
+    TEST_ASSERT_EQUAL_UINT (262144, limit.get ());
+
+    size_t previous = limit.get ();
+    while (limit.get () > zmq::min_adaptive_batch_size) {
+        limit.update (1);
+        TEST_ASSERT_EQUAL_UINT (previous / 2, limit.get ());
+        previous = limit.get ();
+    }
+
+    //  Never shrinks below the minimal adaptive batch.
+    limit.update (0);
+    TEST_ASSERT_EQUAL_UINT (zmq::min_adaptive_batch_size, limit.get ());
+}
+
+void test_small_configured_batch ()
+{
+    //  A configured batch below the adaptive minimum is used as it is.
+    zmq::batch_limit_t limit (256, true, zmq::out_batch_size);
+    TEST_ASSERT_EQUAL_UINT (256, limit.get ());
+
+    limit.update (0);
+    TEST_ASSERT_EQUAL_UINT (256, limit.get ());
+    limit.update (256);
+    TEST_ASSERT_EQUAL_UINT (256, limit.get ());
+}
+
+void test_encoder_honours_limit ()
+{
+    zmq::v2_encoder_t encoder (8192);
+
+    zmq::msg_t msg;
+    TEST_ASSERT_EQUAL_INT (0, msg.init_size (200));
+    memset (msg.data (), 'a', msg.size ());
+    encoder.load_msg (&msg);
+
+    //  The 2 byte header and the start of the body are copied into the
+    //  encoder buffer, up to the limit.
+    unsigned char *data = NULL;
+    TEST_ASSERT_EQUAL_UINT (100, encoder.encode (&data, 100));
+    TEST_ASSERT_NOT_NULL (data);
+
+    //  The rest of the body does not fit under the limit, so it is
+    //  handed out in place.
+    data = NULL;
+    TEST_ASSERT_EQUAL_UINT (102, encoder.encode (&data, 100));
+    TEST_ASSERT_TRUE (data > (unsigned char *) msg.data ()
+                      && data < (unsigned char *) msg.data () + msg.size ());
+    data = NULL;
+    TEST_ASSERT_EQUAL_UINT (0, encoder.encode (&data, 100));
+    TEST_ASSERT_EQUAL_INT (0, msg.close ());
+
+    //  A limit of 0 leaves the whole buffer to the encoder.
+    TEST_ASSERT_EQUAL_INT (0, msg.init_size (200));
+    encoder.load_msg (&msg);
+    data = NULL;
+    TEST_ASSERT_EQUAL_UINT (202, encoder.encode (&data, 0));
+    TEST_ASSERT_EQUAL_INT (0, msg.close ());
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_fixed_limit);
+    RUN_TEST (test_initial_limit_capped);
+    RUN_TEST (test_grows_under_load);
+    RUN_TEST (test_shrinks_when_sparse);
+    RUN_TEST (test_small_configured_batch);
+    RUN_TEST (test_encoder_honours_limit);
+
+    return UNITY_END ();
+}
@@ -0,0 +1,276 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#if defined(min)
+#undef min
+#endif
+
+#include <blob_map.hpp>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+typedef zmq::blob_map_t<int> map_t;
+
+zmq::blob_t make_key (const std::string &key_)
+{
+    return zmq::blob_t ((const unsigned char *) key_.data (), key_.size ());
+}
+
+bool map_insert (map_t &map_, const std::string &key_, int value_)
+{
+    zmq::blob_t key = make_key (key_);
+    return map_.insert (key, value_);
+}
+
+//  Returns the value stored under key_, or -1 if there is none.
+int map_find (map_t &map_, const std::string &key_)
+{
+    map_t::iterator it = map_.find (make_key (key_));
+    return it == map_.end () ? -1 : it->second;
+}
+
+void map_erase (map_t &map_, const std::string &key_)
+{
+    map_t::iterator it = map_.find (make_key (key_));
+    TEST_ASSERT_TRUE (it != map_.end ());
+    map_.erase (it);
+}
+
+//  Returns the values in the order of the slots they are stored in.
+std::vector<int> map_values (map_t &map_)
+{
+    std::vector<int> values;
+    for (map_t::iterator it = map_.begin (); it != map_.end (); ++it)
+        values.push_back (it->second);
+    return values;
+}
+
+//  Returns a key not used before whose probe sequence starts at bucket_.
+//  The hash is seeded per map, so the keys have to be searched for.
+std::string key_in_bucket (map_t &map_, size_t bucket_, int *counter_)
+{
+    while (true) {
+        char key[16];
+        sprintf (key, "key%d", (*counter_)++);
+        if (map_.bucket (make_key (key)) == bucket_)
+            return key;
+    }
+}
+
+void test_empty ()
+{
+    map_t map;
+    TEST_ASSERT_TRUE (map.empty ());
+    TEST_ASSERT_EQUAL_UINT (0, map.size ());
+    TEST_ASSERT_TRUE (map.begin () == map.end ());
+    TEST_ASSERT_EQUAL_INT (-1, map_find (map, "A"));
+}
+
+void test_insert_find ()
+{
+    map_t map;
+    TEST_ASSERT_TRUE (map_insert (map, "A", 1));
+    TEST_ASSERT_TRUE (map_insert (map, "B", 2));
+    TEST_ASSERT_TRUE (map_insert (map, "", 3));
+
+    //  The key is left untouched when it is present already.
+    zmq::blob_t key = make_key ("A");
+    TEST_ASSERT_FALSE (map.insert (key, 4));
+    TEST_ASSERT_EQUAL_UINT (1, key.size ());
+
+    TEST_ASSERT_EQUAL_UINT (3, map.size ());
+    TEST_ASSERT_EQUAL_INT (1, map_find (map, "A"));
+    TEST_ASSERT_EQUAL_INT (2, map_find (map, "B"));
+    TEST_ASSERT_EQUAL_INT (3, map_find (map, ""));
+    TEST_ASSERT_EQUAL_INT (-1, map_find (map, "AB"));
+}
+
+void test_probe_collisions ()
+{
+    map_t map;
+    int counter = 0;
+    const std::string a = key_in_bucket (map, 3, &counter);
+    const std::string b = key_in_bucket (map, 3, &counter);
+    const std::string c = key_in_bucket (map, 3, &counter);
+    const std::string d = key_in_bucket (map, 4, &counter);
+
+    //  b and c follow a, and d, whose home slot b took, follows c.
+    TEST_ASSERT_TRUE (map_insert (map, a, 1));
+    TEST_ASSERT_TRUE (map_insert (map, b, 2));
+    TEST_ASSERT_TRUE (map_insert (map, c, 3));
+    TEST_ASSERT_TRUE (map_insert (map, d, 4));
+    TEST_ASSERT_EQUAL_INT (1, map_find (map, a));
+    TEST_ASSERT_EQUAL_INT (2, map_find (map, b));
+    TEST_ASSERT_EQUAL_INT (3, map_find (map, c));
+    TEST_ASSERT_EQUAL_INT (4, map_find (map, d));
+
+    //  Erasing the head of the sequence moves each of the others back by
+    //  one slot.
+    map_erase (map, a);
+    TEST_ASSERT_EQUAL_INT (-1, map_find (map, a));
+    TEST_ASSERT_EQUAL_INT (2, map_find (map, b));
+    TEST_ASSERT_EQUAL_INT (3, map_find (map, c));
+    TEST_ASSERT_EQUAL_INT (4, map_find (map, d));
+    const int shifted[] = {2, 3, 4};
+    TEST_ASSERT_EQUAL_INT_ARRAY (shifted, &map_values (map)[0], 3);
+
+    //  The slot freed at the end of the sequence is reused.
+    TEST_ASSERT_TRUE (map_insert (map, a, 5));
+    const int reused[] = {2, 3, 4, 5};
+    TEST_ASSERT_EQUAL_INT_ARRAY (reused, &map_values (map)[0], 4);
+}
+
+void test_erase_wraparound ()
+{
+    map_t map;
+    const size_t last = map.bucket_count () - 1;
+    int counter = 0;
+    const std::string a = key_in_bucket (map, last, &counter);
+    const std::string b = key_in_bucket (map, last, &counter);
+    const std::string c = key_in_bucket (map, last, &counter);
+    const std::string d = key_in_bucket (map, 0, &counter);
+
+    //  a takes the last slot, b and c wrap around to slots 0 and 1, and
+    //  d, whose home slot is taken, goes to slot 2.
+    TEST_ASSERT_TRUE (map_insert (map, a, 1));
+    TEST_ASSERT_TRUE (map_insert (map, b, 2));
+    TEST_ASSERT_TRUE (map_insert (map, c, 3));
+    TEST_ASSERT_TRUE (map_insert (map, d, 4));
+    const int inserted[] = {2, 3, 4, 1};
+    TEST_ASSERT_EQUAL_INT_ARRAY (inserted, &map_values (map)[0], 4);
+
+    //  Erasing a moves b back across the end of the table, c to slot 0
+    //  and d to slot 1.
+    map_erase (map, a);
+    const int shifted[] = {3, 4, 2};
+    TEST_ASSERT_EQUAL_INT_ARRAY (shifted, &map_values (map)[0], 3);
+    TEST_ASSERT_EQUAL_INT (-1, map_find (map, a));
+    TEST_ASSERT_EQUAL_INT (2, map_find (map, b));
+    TEST_ASSERT_EQUAL_INT (3, map_find (map, c));
+    TEST_ASSERT_EQUAL_INT (4, map_find (map, d));
+
+    //  Erasing d, the end of the sequence, moves nothing.
+    map_erase (map, d);
+    const int kept[] = {3, 2};
+    TEST_ASSERT_EQUAL_INT_ARRAY (kept, &map_values (map)[0], 2);
+    TEST_ASSERT_EQUAL_INT (2, map_find (map, b));
+    TEST_ASSERT_EQUAL_INT (3, map_find (map, c));
+}
+
+void test_grow ()
+{
+    map_t map;
+    const size_t initial = map.bucket_count ();
+
+    //  Fill half of the table with a single probe sequence.
+    int counter = 0;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i != initial / 2; ++i) {
+        keys.push_back (key_in_bucket (map, 5, &counter));
+        TEST_ASSERT_TRUE (map_insert (map, keys.back (), (int) i));
+    }
+    TEST_ASSERT_EQUAL_UINT (initial, map.bucket_count ());
+
+    //  One more key makes the table grow and rehash everything.
+    keys.push_back (key_in_bucket (map, 0, &counter));
+    TEST_ASSERT_TRUE (map_insert (map, keys.back (), (int) initial / 2));
+    TEST_ASSERT_EQUAL_UINT (initial * 2, map.bucket_count ());
+    TEST_ASSERT_EQUAL_UINT (keys.size (), map.size ());
+    for (size_t i = 0; i != keys.size (); ++i)
+        TEST_ASSERT_EQUAL_INT ((int) i, map_find (map, keys[i]));
+}
+
+void test_iterate_after_erase ()
+{
+    map_t map;
+    const int count = 100;
+    char key[16];
+    for (int i = 0; i != count; ++i) {
+        sprintf (key, "%d", i);
+        TEST_ASSERT_TRUE (map_insert (map, key, i));
+    }
+
+    for (int i = 0; i != count; i += 2) {
+        sprintf (key, "%d", i);
+        map_erase (map, key);
+    }
+    TEST_ASSERT_EQUAL_UINT (count / 2, map.size ());
+
+    //  Every remaining entry is visited exactly once, with its own key.
+    std::vector<bool> seen (count, false);
+    for (map_t::iterator it = map.begin (); it != map.end (); ++it) {
+        const int value = it->second;
+        TEST_ASSERT_EQUAL_INT (1, value % 2);
+        TEST_ASSERT_FALSE (seen[value]);
+        seen[value] = true;
+        sprintf (key, "%d", value);
+        TEST_ASSERT_EQUAL_UINT (strlen (key), it->first.size ());
+        TEST_ASSERT_EQUAL_MEMORY (key, it->first.data (), strlen (key));
+    }
+    for (int i = 1; i < count; i += 2)
+        TEST_ASSERT_TRUE (seen[i]);
+
+    //  Erasing everything leaves an empty map.
+    while (!map.empty ())
+        map.erase (map.begin ());
+    TEST_ASSERT_TRUE (map.begin () == map.end ());
+}
+
+void test_seeded ()
+{
+    //  Each map hashes differently, so at least some of the keys end up
+    //  in different buckets.
+    map_t first, second;
+    char key[16];
+    bool differ = false;
+    for (int i = 0; i != 64 && !differ; ++i) {
+        sprintf (key, "%d", i);
+        differ = first.bucket (make_key (key)) != second.bucket (make_key (key));
+    }
+    TEST_ASSERT_TRUE (differ);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_insert_find);
+    RUN_TEST (test_probe_collisions);
+    RUN_TEST (test_erase_wraparound);
+    RUN_TEST (test_grow);
+    RUN_TEST (test_iterate_after_erase);
+    RUN_TEST (test_seeded);
+
+    return UNITY_END ();
+}
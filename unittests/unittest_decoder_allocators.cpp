@@ -0,0 +1,130 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+
+#include <decoder_allocators.hpp>
+#include <msg.hpp>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+const size_t bufsize = 1024;
+const size_t msg_size = 100;
+
+//  Constructs a zero-copy message on the allocator's current buffer, the way
+//  v2_decoder_t does.
+void init_msg (zmq::shared_message_memory_allocator &allocator_,
+               zmq::msg_t &msg_,
+               unsigned char *data_)
+{
+    int rc = msg_.init (data_, msg_size,
+                        zmq::shared_message_memory_allocator::call_dec_ref,
+                        allocator_.buffer (), allocator_.provide_content ());
+    TEST_ASSERT_EQUAL_INT (0, rc);
+    TEST_ASSERT_TRUE (msg_.is_zcmsg ());
+    allocator_.advance_content ();
+    allocator_.inc_ref ();
+}
+
+void test_reuse_unused_buffer ()
+{
+    zmq::shared_message_memory_allocator allocator (bufsize);
+    unsigned char *first = allocator.allocate ();
+    TEST_ASSERT_EQUAL (bufsize, allocator.size ());
+    TEST_ASSERT_EQUAL_PTR (first, allocator.allocate ());
+}
+
+void test_reuse_returned_buffer ()
+{
+    zmq::shared_message_memory_allocator allocator (bufsize);
+    zmq::msg_t first_msg;
+    zmq::msg_t second_msg;
+
+    unsigned char *first = allocator.allocate ();
+    init_msg (allocator, first_msg, first);
+
+    //  The first buffer is in use, so a second one is allocated.
+    unsigned char *second = allocator.allocate ();
+    TEST_ASSERT_TRUE (first != second);
+    init_msg (allocator, second_msg, second);
+
+    //  Closing the message returns the first buffer to the pool.
+    TEST_ASSERT_EQUAL_INT (0, first_msg.close ());
+    TEST_ASSERT_EQUAL_PTR (first, allocator.allocate ());
+
+    TEST_ASSERT_EQUAL_INT (0, second_msg.close ());
+}
+
+void test_many_buffers_in_use ()
+{
+    const int count = 1000;
+    zmq::shared_message_memory_allocator allocator (bufsize);
+    zmq::msg_t msgs[count];
+
+    for (int i = 0; i < count; i++)
+        init_msg (allocator, msgs[i], allocator.allocate ());
+
+    //  More buffers are returned than the pool keeps.
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_EQUAL_INT (0, msgs[i].close ());
+
+    for (int i = 0; i < count; i++)
+        init_msg (allocator, msgs[i], allocator.allocate ());
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_EQUAL_INT (0, msgs[i].close ());
+}
+
+void test_messages_outlive_allocator ()
+{
+    zmq::shared_message_memory_allocator *allocator =
+      new zmq::shared_message_memory_allocator (bufsize);
+    zmq::msg_t first_msg;
+    zmq::msg_t second_msg;
+
+    init_msg (*allocator, first_msg, allocator->allocate ());
+    init_msg (*allocator, second_msg, allocator->allocate ());
+    TEST_ASSERT_EQUAL_INT (0, first_msg.close ());
+
+    delete allocator;
+
+    //  The buffer and the pool are freed when the last message is closed.
+    memset (second_msg.data (), 0, second_msg.size ());
+    TEST_ASSERT_EQUAL_INT (0, second_msg.close ());
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_reuse_unused_buffer);
+    RUN_TEST (test_reuse_returned_buffer);
+    RUN_TEST (test_many_buffers_in_use);
+    RUN_TEST (test_messages_outlive_allocator);
+
+    return UNITY_END ();
+}
@@ -0,0 +1,162 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+
+#include <mailbox_safe.hpp>
+#include <mutex.hpp>
+#include <thread.hpp>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+
+void tearDown ()
+{
+}
+
+static zmq::command_t make_command (int sender_, uint64_t seq_)
+{
+    zmq::command_t cmd;
+    cmd.destination = (zmq::object_t *) (intptr_t) (sender_ + 1);
+    cmd.type = zmq::command_t::activate_write;
+    cmd.args.activate_write.msgs_read = seq_;
+    return cmd;
+}
+
+void test_send_recv ()
+{
+    zmq::mutex_t sync;
+    zmq::mailbox_safe_t mailbox (&sync);
+    zmq::scoped_lock_t lock (sync);
+
+    zmq::command_t cmd;
+    TEST_ASSERT_EQUAL_INT (-1, mailbox.recv (&cmd, 0));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+
+    //  More commands than there are spare nodes, sent and read twice.
+    for (int round = 0; round != 2; round++) {
+        for (int i = 0; i != 3 * zmq::mailbox_spare_nodes; i++)
+            mailbox.send (make_command (0, i));
+        for (int i = 0; i != 3 * zmq::mailbox_spare_nodes; i++) {
+            TEST_ASSERT_EQUAL_INT (0, mailbox.recv (&cmd, 0));
+            TEST_ASSERT_EQUAL_UINT64 (i, cmd.args.activate_write.msgs_read);
+        }
+        TEST_ASSERT_EQUAL_INT (-1, mailbox.recv (&cmd, 0));
+        TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    }
+
+    //  Unread commands are released with the mailbox.
+    mailbox.send (make_command (0, 0));
+}
+
+void test_recv_timeout ()
+{
+    zmq::mutex_t sync;
+    zmq::mailbox_safe_t mailbox (&sync);
+    zmq::scoped_lock_t lock (sync);
+
+    zmq::command_t cmd;
+    TEST_ASSERT_EQUAL_INT (-1, mailbox.recv (&cmd, 10));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+
+    //  The signaler used for waiting is reused and holds no stale signal.
+    mailbox.send (make_command (0, 0));
+    TEST_ASSERT_EQUAL_INT (0, mailbox.recv (&cmd, 10));
+    TEST_ASSERT_EQUAL_INT (-1, mailbox.recv (&cmd, 10));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+}
+
+#define SENDERS 4
+#define COMMANDS 20000
+
+struct sender_t
+{
+    zmq::mailbox_safe_t *mailbox;
+    int index;
+};
+
+void sender_routine (void *arg_)
+{
+    sender_t *sender = (sender_t *) arg_;
+    for (int i = 0; i != COMMANDS; i++) {
+        sender->mailbox->send (make_command (sender->index, i));
+
+        //  Pause now and then, so that the receiver runs dry and blocks.
+        if (i % 5000 == 4999)
+            msleep (1);
+    }
+}
+
+void test_many_senders ()
+{
+    zmq::mutex_t sync;
+    zmq::mailbox_safe_t mailbox (&sync);
+    sender_t senders[SENDERS];
+    zmq::thread_t threads[SENDERS];
+
+    for (int i = 0; i != SENDERS; i++) {
+        senders[i].mailbox = &mailbox;
+        senders[i].index = i;
+        threads[i].start (sender_routine, &senders[i]);
+    }
+
+    //  A sender may have swapped its node in as the tail without linking
+    //  it yet, so the receiver sees the list end early. It must be woken
+    //  up once the node is linked, or find it when its wait times out.
+    uint64_t next[SENDERS] = {0};
+    int received = 0;
+    int timeouts = 0;
+    sync.lock ();
+    while (received != SENDERS * COMMANDS) {
+        zmq::command_t cmd;
+        if (mailbox.recv (&cmd, 100) == -1) {
+            TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+            TEST_ASSERT_TRUE (++timeouts < 20);
+            continue;
+        }
+        const int sender = (int) (intptr_t) cmd.destination - 1;
+        TEST_ASSERT_TRUE (sender >= 0 && sender < SENDERS);
+        TEST_ASSERT_EQUAL_UINT64 (next[sender]++,
+                                  cmd.args.activate_write.msgs_read);
+        received++;
+    }
+
+    zmq::command_t cmd;
+    TEST_ASSERT_EQUAL_INT (-1, mailbox.recv (&cmd, 0));
+    sync.unlock ();
+
+    for (int i = 0; i != SENDERS; i++)
+        threads[i].stop ();
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_send_recv);
+    RUN_TEST (test_recv_timeout);
+    RUN_TEST (test_many_senders);
+
+    return UNITY_END ();
+}
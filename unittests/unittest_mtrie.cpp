@@ -421,6 +421,53 @@ void test_rm_with_callback_duplicate_uniq_only ()
     mtrie.rm (&pipes[1], check_count, &count, true);
 }
 
+void test_split_and_merge_labels ()
+{
+    int pipes[3];
+    zmq::generic_mtrie_t<int> mtrie;
+    const char *names[] = {"foobar", "foo", "fox"};
+    const zmq::generic_mtrie_t<int>::prefix_t data =
+      reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> ("foobarbaz");
+    const zmq::generic_mtrie_t<int>::prefix_t other =
+      reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> ("foxtrot");
+
+    for (int i = 0; i < 3; ++i) {
+        const zmq::generic_mtrie_t<int>::prefix_t name_data =
+          reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> (names[i]);
+        TEST_ASSERT_TRUE (
+          mtrie.add (name_data, getlen (name_data), &pipes[i]));
+    }
+
+    int count = 0;
+    mtrie.match (data, getlen (data), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (2, count);
+    count = 0;
+    mtrie.match (other, getlen (other), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (1, count);
+
+    //  Removing the inner entries merges the remaining chain back.
+    const zmq::generic_mtrie_t<int>::prefix_t foo =
+      reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> (names[1]);
+    TEST_ASSERT_EQUAL (zmq::generic_mtrie_t<int>::last_value_removed,
+                       mtrie.rm (foo, getlen (foo), &pipes[1]));
+    mtrie.rm (&pipes[2], check_name, names[2], false);
+
+    count = 0;
+    mtrie.match (data, getlen (data), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (1, count);
+    count = 0;
+    mtrie.match (foo, getlen (foo), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+    count = 0;
+    mtrie.match (other, getlen (other), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+
+    mtrie.rm (&pipes[0], check_name, names[0], false);
+    count = 0;
+    mtrie.match (data, getlen (data), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -453,5 +500,7 @@ int main (void)
     RUN_TEST (test_rm_with_callback_duplicate);
     RUN_TEST (test_rm_with_callback_duplicate_uniq_only);
 
+    RUN_TEST (test_split_and_merge_labels);
+
     return UNITY_END ();
 }
@@ -205,6 +205,124 @@ void test_add_fd_and_remove_by_timer ()
     close_fdpair (w, r);
 }
 
+struct busy_events_t : test_events_t
+{
+    busy_events_t (zmq::fd_t fd_, zmq::poller_t &poller_) :
+        test_events_t (fd_, poller_)
+    {
+    }
+
+    virtual void in_event ()
+    {
+        //  Keep the thread busy for two measurement windows.
+        const uint64_t end =
+          zmq::clock_t::now_us () + 2 * zmq::poller_busy_window * 1000;
+        while (zmq::clock_t::now_us () < end) {
+        }
+        test_events_t::in_event ();
+    }
+};
+
+void test_busy ()
+{
+    zmq::thread_ctx_t thread_ctx;
+    zmq::poller_t poller (thread_ctx);
+
+    zmq::fd_t r, w;
+    create_nonblocking_fdpair (&r, &w);
+
+    busy_events_t events (r, poller);
+
+    zmq::poller_t::handle_t handle = poller.add_fd (r, &events);
+    events.set_handle (handle);
+    poller.set_pollin (handle);
+    TEST_ASSERT_EQUAL_INT (0, poller.get_busy ());
+    poller.start ();
+
+    send_signal (w);
+
+    wait_in_events (events);
+
+    //  The time spent is accounted for after the event was handled.
+    int busy = 0;
+    for (int i = 0; i < 100 && busy == 0; i++) {
+        msleep (10);
+        busy = poller.get_busy ();
+    }
+    TEST_ASSERT_GREATER_THAN_INT (0, busy);
+
+    //  The busy share decays while the thread is idle.
+    msleep (3 * zmq::poller_busy_window + 50);
+    TEST_ASSERT_LESS_OR_EQUAL_INT (busy / 2, poller.get_busy ());
+
+    // required cleanup
+    close_fdpair (w, r);
+}
+
+struct steady_events_t : test_events_t
+{
+    steady_events_t (zmq::fd_t fd_, zmq::poller_t &poller_) :
+        test_events_t (fd_, poller_),
+        poller (poller_),
+        windows (0),
+        busy (0)
+    {
+    }
+
+    virtual void in_event ()
+    {
+        //  The fd is never drained, so the thread is woken up again at
+        //  once. Report how busy it was after all the windows.
+        if (windows == steady_windows) {
+            busy = poller.get_busy ();
+            test_events_t::in_event ();
+            return;
+        }
+
+        //  Keep the thread busy for one measurement window.
+        const uint64_t end =
+          zmq::clock_t::now_us () + zmq::poller_busy_window * 1000;
+        while (zmq::clock_t::now_us () < end) {
+        }
+        windows++;
+    }
+
+    static const int steady_windows = 8;
+
+    zmq::poller_t &poller;
+    int windows;
+    int busy;
+};
+
+void test_busy_steady ()
+{
+    zmq::thread_ctx_t thread_ctx;
+    zmq::poller_t poller (thread_ctx);
+
+    zmq::fd_t r, w;
+    create_nonblocking_fdpair (&r, &w);
+
+    steady_events_t events (r, poller);
+
+    zmq::poller_t::handle_t handle = poller.add_fd (r, &events);
+    events.set_handle (handle);
+    poller.set_pollin (handle);
+    poller.start ();
+
+    send_signal (w);
+
+    for (int i = 0; i < 1000 && events.in_events.get () == 0; i++)
+        msleep (10);
+    TEST_ASSERT_EQUAL_INT (1, events.in_events.get ());
+
+    //  A thread busy all the time converges to the full share, halving
+    //  the distance left with every window.
+    TEST_ASSERT_INT_WITHIN (1000000 >> 4, 1000000, events.busy);
+
+    // required cleanup
+    close_fdpair (w, r);
+}
+
 int main (void)
 {
     UNITY_BEGIN ();
@@ -215,6 +333,8 @@ int main (void)
     RUN_TEST (test_create);
     RUN_TEST (test_add_fd_and_start_and_receive_data);
     RUN_TEST (test_add_fd_and_remove_by_timer);
+    RUN_TEST (test_busy);
+    RUN_TEST (test_busy_steady);
 
     zmq::shutdown_network ();
 
@@ -0,0 +1,155 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#if defined(min)
+#undef min
+#endif
+
+#include <radix_tree.hpp>
+
+#include <string>
+#include <vector>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+bool tree_add (zmq::radix_tree_t &tree_, const char *key_)
+{
+    return tree_.add ((unsigned char *) key_, strlen (key_));
+}
+
+bool tree_rm (zmq::radix_tree_t &tree_, const char *key_)
+{
+    return tree_.rm ((unsigned char *) key_, strlen (key_));
+}
+
+bool tree_check (zmq::radix_tree_t &tree_, const char *data_)
+{
+    return tree_.check ((unsigned char *) data_, strlen (data_));
+}
+
+void test_empty ()
+{
+    zmq::radix_tree_t tree;
+    TEST_ASSERT_FALSE (tree_check (tree, ""));
+    TEST_ASSERT_FALSE (tree_check (tree, "foo"));
+    TEST_ASSERT_FALSE (tree_rm (tree, "foo"));
+}
+
+void test_add_check_prefixes ()
+{
+    zmq::radix_tree_t tree;
+    TEST_ASSERT_TRUE (tree_add (tree, "md.equities.NASDAQ."));
+    TEST_ASSERT_FALSE (tree_add (tree, "md.equities.NASDAQ."));
+
+    TEST_ASSERT_TRUE (tree_check (tree, "md.equities.NASDAQ.AAPL"));
+    TEST_ASSERT_TRUE (tree_check (tree, "md.equities.NASDAQ."));
+    TEST_ASSERT_FALSE (tree_check (tree, "md.equities.NASDAQ"));
+    TEST_ASSERT_FALSE (tree_check (tree, "md.equities.NYSE.IBM"));
+    TEST_ASSERT_FALSE (tree_check (tree, "md"));
+}
+
+void test_split_labels ()
+{
+    zmq::radix_tree_t tree;
+    TEST_ASSERT_TRUE (tree_add (tree, "md.equities.NASDAQ."));
+    TEST_ASSERT_TRUE (tree_add (tree, "md.equities.NYSE."));
+    TEST_ASSERT_TRUE (tree_add (tree, "md.eq"));
+
+    TEST_ASSERT_TRUE (tree_check (tree, "md.equities.NYSE.IBM"));
+    TEST_ASSERT_TRUE (tree_check (tree, "md.eqx"));
+    TEST_ASSERT_FALSE (tree_check (tree, "md.e"));
+
+    TEST_ASSERT_TRUE (tree_rm (tree, "md.eq"));
+    TEST_ASSERT_FALSE (tree_check (tree, "md.eqx"));
+    TEST_ASSERT_TRUE (tree_check (tree, "md.equities.NASDAQ.AAPL"));
+    TEST_ASSERT_TRUE (tree_check (tree, "md.equities.NYSE.IBM"));
+}
+
+void test_rm_refcounted ()
+{
+    zmq::radix_tree_t tree;
+    TEST_ASSERT_TRUE (tree_add (tree, "foo"));
+    TEST_ASSERT_FALSE (tree_add (tree, "foo"));
+    TEST_ASSERT_FALSE (tree_rm (tree, "foo"));
+    TEST_ASSERT_TRUE (tree_check (tree, "foobar"));
+    TEST_ASSERT_TRUE (tree_rm (tree, "foo"));
+    TEST_ASSERT_FALSE (tree_check (tree, "foobar"));
+    TEST_ASSERT_FALSE (tree_rm (tree, "foo"));
+}
+
+void test_rm_merges_labels ()
+{
+    zmq::radix_tree_t tree;
+    TEST_ASSERT_TRUE (tree_add (tree, "foobar"));
+    TEST_ASSERT_TRUE (tree_add (tree, "fox"));
+    TEST_ASSERT_TRUE (tree_rm (tree, "fox"));
+    TEST_ASSERT_FALSE (tree_rm (tree, "fo"));
+    TEST_ASSERT_TRUE (tree_check (tree, "foobar"));
+    TEST_ASSERT_FALSE (tree_check (tree, "foxtrot"));
+
+    //  Re-adding after merging splits the label again.
+    TEST_ASSERT_TRUE (tree_add (tree, "foo"));
+    TEST_ASSERT_TRUE (tree_check (tree, "foot"));
+    TEST_ASSERT_TRUE (tree_rm (tree, "foobar"));
+    TEST_ASSERT_TRUE (tree_check (tree, "foot"));
+}
+
+void collect (unsigned char *data_, size_t size_, void *arg_)
+{
+    std::vector<std::string> *keys = (std::vector<std::string> *) arg_;
+    keys->push_back (std::string ((char *) data_, size_));
+}
+
+void test_apply ()
+{
+    zmq::radix_tree_t tree;
+    const char *keys[] = {"", "a", "abc", "abd", "md.equities.NASDAQ."};
+    for (size_t i = 0; i < sizeof keys / sizeof keys[0]; ++i)
+        TEST_ASSERT_TRUE (tree_add (tree, keys[i]));
+
+    std::vector<std::string> applied;
+    tree.apply (collect, &applied);
+    TEST_ASSERT_EQUAL_UINT (sizeof keys / sizeof keys[0], applied.size ());
+    for (size_t i = 0; i < applied.size (); ++i)
+        TEST_ASSERT_EQUAL_STRING (keys[i], applied[i].c_str ());
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_add_check_prefixes);
+    RUN_TEST (test_split_labels);
+    RUN_TEST (test_rm_refcounted);
+    RUN_TEST (test_rm_merges_labels);
+    RUN_TEST (test_apply);
+
+    return UNITY_END ();
+}
@@ -0,0 +1,264 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <i_poll_events.hpp>
+#include <timer_wheel.hpp>
+
+#include <vector>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+struct test_sink_t : zmq::i_poll_events
+{
+    test_sink_t (zmq::timer_wheel_t &wheel_) : wheel (wheel_), now (0) {}
+
+    virtual void in_event () {}
+    virtual void out_event () {}
+
+    virtual void timer_event (int id_)
+    {
+        ids.push_back (id_);
+        times.push_back (now);
+
+        //  Negative IDs re-add the timer to expire straight away, once.
+        if (id_ < 0)
+            wheel.add (now, this, -id_);
+    }
+
+    zmq::timer_wheel_t &wheel;
+    uint64_t now;
+    std::vector<int> ids;
+    std::vector<uint64_t> times;
+};
+
+//  Runs the wheel the way a poller does, waiting for as long as execute
+//  returns each time.
+static void run (zmq::timer_wheel_t &wheel_, test_sink_t &sink_)
+{
+    while (!wheel_.empty ()) {
+        const uint64_t wait = wheel_.execute (sink_.now);
+        if (wheel_.empty ())
+            break;
+        TEST_ASSERT_TRUE (wait > 0);
+        sink_.now += wait;
+    }
+}
+
+void test_empty ()
+{
+    zmq::timer_wheel_t wheel (1000);
+    TEST_ASSERT_TRUE (wheel.empty ());
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.execute (1000));
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.execute (5000));
+}
+
+void test_expire_in_order ()
+{
+    zmq::timer_wheel_t wheel (1000);
+    test_sink_t sink (wheel);
+    sink.now = 1000;
+
+    wheel.add (1010, &sink, 2);
+    wheel.add (1005, &sink, 1);
+    wheel.add (1010, &sink, 3);
+    TEST_ASSERT_EQUAL_UINT64 (5, wheel.execute (1000));
+
+    TEST_ASSERT_EQUAL_UINT64 (1, wheel.execute (1004));
+    TEST_ASSERT_EQUAL (0, sink.ids.size ());
+
+    TEST_ASSERT_EQUAL_UINT64 (2, wheel.execute (1008));
+    TEST_ASSERT_EQUAL (1, sink.ids.size ());
+    TEST_ASSERT_EQUAL (1, sink.ids[0]);
+
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.execute (1020));
+    TEST_ASSERT_EQUAL (3, sink.ids.size ());
+    TEST_ASSERT_EQUAL (2, sink.ids[1]);
+    TEST_ASSERT_EQUAL (3, sink.ids[2]);
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_cancel ()
+{
+    zmq::timer_wheel_t wheel (0);
+    test_sink_t sink (wheel);
+    test_sink_t other (wheel);
+
+    wheel.add (10, &sink, 1);
+    wheel.add (20, &sink, 2);
+    wheel.add (10, &other, 1);
+    wheel.add (100000, &sink, 3);
+
+    wheel.cancel (&sink, 1);
+    wheel.cancel (&sink, 3);
+    wheel.execute (50);
+
+    TEST_ASSERT_EQUAL (1, sink.ids.size ());
+    TEST_ASSERT_EQUAL (2, sink.ids[0]);
+    TEST_ASSERT_EQUAL (1, other.ids.size ());
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_cancel_duplicate_first ()
+{
+    zmq::timer_wheel_t wheel (0);
+    test_sink_t sink (wheel);
+
+    wheel.add (300, &sink, 1);
+    wheel.add (100, &sink, 1);
+    wheel.cancel (&sink, 1);
+
+    sink.now = 0;
+    run (wheel, sink);
+    TEST_ASSERT_EQUAL (1, sink.times.size ());
+    TEST_ASSERT_EQUAL_UINT64 (300, sink.times[0]);
+}
+
+void test_expire_in_the_past ()
+{
+    zmq::timer_wheel_t wheel (0);
+    test_sink_t sink (wheel);
+
+    wheel.execute (500);
+    wheel.add (400, &sink, 1);
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.execute (500));
+    TEST_ASSERT_EQUAL (1, sink.ids.size ());
+}
+
+void test_add_from_handler ()
+{
+    zmq::timer_wheel_t wheel (0);
+    test_sink_t sink (wheel);
+
+    wheel.add (10, &sink, -7);
+    sink.now = 10;
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.execute (10));
+
+    TEST_ASSERT_EQUAL (2, sink.ids.size ());
+    TEST_ASSERT_EQUAL (-7, sink.ids[0]);
+    TEST_ASSERT_EQUAL (7, sink.ids[1]);
+}
+
+void test_long_timeouts_exact ()
+{
+    const uint64_t start = 123456789;
+    const uint64_t timeouts[] = {1,       255,      256,      257,
+                                 65535,   65536,    65537,    1000000,
+                                 3600000, 16777217, 86400000, 2147483647};
+    const size_t n = sizeof timeouts / sizeof timeouts[0];
+
+    zmq::timer_wheel_t wheel (start);
+    test_sink_t sink (wheel);
+    sink.now = start;
+    for (size_t i = 0; i != n; i++)
+        wheel.add (start + timeouts[i], &sink, static_cast<int> (i));
+
+    run (wheel, sink);
+
+    TEST_ASSERT_EQUAL (n, sink.ids.size ());
+    for (size_t i = 0; i != n; i++) {
+        TEST_ASSERT_EQUAL (static_cast<int> (i), sink.ids[i]);
+        TEST_ASSERT_EQUAL_UINT64 (start + timeouts[i], sink.times[i]);
+    }
+}
+
+void test_across_top_level ()
+{
+    //  Start just before the top level wraps around.
+    const uint64_t start = ((uint64_t) 1 << 32) - 100;
+
+    zmq::timer_wheel_t wheel (start);
+    test_sink_t sink (wheel);
+    sink.now = start;
+    wheel.add (start + 50, &sink, 1);
+    wheel.add (start + 200, &sink, 2);
+    wheel.add (start + 3000000000ULL, &sink, 3);
+
+    run (wheel, sink);
+
+    TEST_ASSERT_EQUAL (3, sink.ids.size ());
+    TEST_ASSERT_EQUAL_UINT64 (start + 50, sink.times[0]);
+    TEST_ASSERT_EQUAL_UINT64 (start + 200, sink.times[1]);
+    TEST_ASSERT_EQUAL_UINT64 (start + 3000000000ULL, sink.times[2]);
+}
+
+void test_add_at_pending_cascade ()
+{
+    zmq::timer_wheel_t wheel (0);
+    test_sink_t sink (wheel);
+
+    //  Stop right at the tick the first timer is due to be cascaded at,
+    //  then add a timer that goes to a lower level than the first one.
+    wheel.add (65536 + 10, &sink, 1);
+    wheel.execute (65535);
+    wheel.add (65536 + 300, &sink, 2);
+
+    sink.now = 65535;
+    run (wheel, sink);
+
+    TEST_ASSERT_EQUAL (2, sink.ids.size ());
+    TEST_ASSERT_EQUAL_UINT64 (65536 + 10, sink.times[0]);
+    TEST_ASSERT_EQUAL_UINT64 (65536 + 300, sink.times[1]);
+}
+
+void test_many ()
+{
+    zmq::timer_wheel_t wheel (0);
+    std::vector<test_sink_t *> sinks;
+    for (int i = 0; i != 1000; i++) {
+        sinks.push_back (new test_sink_t (wheel));
+        wheel.add (1000 + i * 37, sinks.back (), 1);
+        wheel.add (5000 + i * 11, sinks.back (), 2);
+    }
+    for (int i = 0; i != 1000; i += 2)
+        wheel.cancel (sinks[i], 2);
+
+    wheel.execute (100000);
+    TEST_ASSERT_TRUE (wheel.empty ());
+    for (int i = 0; i != 1000; i++) {
+        TEST_ASSERT_EQUAL (i % 2 ? 2 : 1, sinks[i]->ids.size ());
+        delete sinks[i];
+    }
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_expire_in_order);
+    RUN_TEST (test_cancel);
+    RUN_TEST (test_cancel_duplicate_first);
+    RUN_TEST (test_expire_in_the_past);
+    RUN_TEST (test_add_from_handler);
+    RUN_TEST (test_long_timeouts_exact);
+    RUN_TEST (test_across_top_level);
+    RUN_TEST (test_add_at_pending_cascade);
+    RUN_TEST (test_many);
+    return UNITY_END ();
+}
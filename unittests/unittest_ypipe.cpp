@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../tests/testutil.hpp"
 
 #include <ypipe.hpp>
+#include <signaler.hpp>
+#include <thread.hpp>
 
 #include <unity.h>
 
@@ -72,6 +74,128 @@ void test_write_complete_and_flush_and_check_read_and_read ()
     TEST_ASSERT_EQUAL_INT (value, read_value);
 }
 
+void test_incomplete_not_flushed ()
+{
+    zmq::ypipe_t<int, 4> ypipe;
+    ypipe.write (1, true);
+    ypipe.flush ();
+    TEST_ASSERT_FALSE (ypipe.check_read ());
+
+    ypipe.write (2, false);
+    ypipe.flush ();
+    int read_value = -1;
+    TEST_ASSERT_TRUE (ypipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (1, read_value);
+    TEST_ASSERT_TRUE (ypipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (2, read_value);
+    TEST_ASSERT_FALSE (ypipe.read (&read_value));
+}
+
+void test_unwrite ()
+{
+    zmq::ypipe_t<int, 4> ypipe;
+    ypipe.write (1, false);
+    ypipe.write (2, true);
+    ypipe.write (3, true);
+
+    //  Only the incomplete items can be taken back
+    int value = -1;
+    TEST_ASSERT_TRUE (ypipe.unwrite (&value));
+    TEST_ASSERT_EQUAL_INT (3, value);
+    TEST_ASSERT_TRUE (ypipe.unwrite (&value));
+    TEST_ASSERT_EQUAL_INT (2, value);
+    TEST_ASSERT_FALSE (ypipe.unwrite (&value));
+
+    ypipe.flush ();
+    TEST_ASSERT_TRUE (ypipe.read (&value));
+    TEST_ASSERT_EQUAL_INT (1, value);
+    TEST_ASSERT_FALSE (ypipe.read (&value));
+}
+
+void test_flush_wakes_sleeping_reader ()
+{
+    zmq::ypipe_t<int, 4> ypipe;
+
+    //  A reader finding the pipe empty goes to sleep, so the next flush
+    //  reports that it has to be woken up.
+    TEST_ASSERT_FALSE (ypipe.check_read ());
+    ypipe.write (1, false);
+    TEST_ASSERT_FALSE (ypipe.flush ());
+
+    //  Until it reads again, the reader is considered awake.
+    ypipe.write (2, false);
+    TEST_ASSERT_TRUE (ypipe.flush ());
+
+    int value = -1;
+    TEST_ASSERT_TRUE (ypipe.read (&value));
+    TEST_ASSERT_EQUAL_INT (1, value);
+    TEST_ASSERT_TRUE (ypipe.read (&value));
+    TEST_ASSERT_EQUAL_INT (2, value);
+}
+
+void test_many_chunks ()
+{
+    //  Spans many chunks, reusing the spare chunk on the way.
+    zmq::ypipe_t<int, 4> ypipe;
+    int next_read = 0;
+    for (int i = 0; i < 1000; i++) {
+        ypipe.write (i, false);
+        ypipe.flush ();
+        if (i % 7 == 6) {
+            int value;
+            while (ypipe.read (&value))
+                TEST_ASSERT_EQUAL_INT (next_read++, value);
+        }
+    }
+    int value;
+    while (ypipe.read (&value))
+        TEST_ASSERT_EQUAL_INT (next_read++, value);
+    TEST_ASSERT_EQUAL_INT (1000, next_read);
+}
+
+#define ITEMS 5000
+
+struct transfer_t
+{
+    zmq::ypipe_t<int, 16> pipe;
+
+    //  Wakes the reader up, standing in for the activate_read commands
+    //  sent between pipes.
+    zmq::signaler_t signaler;
+};
+
+void writer_routine (void *arg_)
+{
+    transfer_t *transfer = (transfer_t *) arg_;
+    for (int i = 0; i != ITEMS; i++) {
+        transfer->pipe.write (i, false);
+        if (!transfer->pipe.flush ())
+            transfer->signaler.send ();
+    }
+}
+
+void test_threaded_transfer ()
+{
+    transfer_t transfer;
+    zmq::thread_t writer;
+    writer.start (writer_routine, &transfer);
+
+    for (int i = 0; i != ITEMS; i++) {
+        //  Having found the pipe empty, the reader is asleep until the
+        //  writer wakes it up.
+        int value = -1;
+        if (!transfer.pipe.read (&value)) {
+            TEST_ASSERT_EQUAL_INT (0, transfer.signaler.wait (-1));
+            transfer.signaler.recv ();
+            TEST_ASSERT_TRUE (transfer.pipe.read (&value));
+        }
+        TEST_ASSERT_EQUAL_INT (i, value);
+    }
+
+    writer.stop ();
+    TEST_ASSERT_FALSE (transfer.pipe.check_read ());
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -82,6 +206,11 @@ int main (void)
     RUN_TEST (test_read_empty);
     RUN_TEST (test_write_complete_and_check_read_and_read);
     RUN_TEST (test_write_complete_and_flush_and_check_read_and_read);
+    RUN_TEST (test_incomplete_not_flushed);
+    RUN_TEST (test_unwrite);
+    RUN_TEST (test_flush_wakes_sleeping_reader);
+    RUN_TEST (test_many_chunks);
+    RUN_TEST (test_threaded_transfer);
 
     return UNITY_END ();
 }